@@ -54,6 +54,14 @@ benchmarks = [
     {'name': 'allocbench/huge.R', 'warmup_rep': 0, 'bench_rep': 1},
     {'name': 'allocbench/huge-recursive.R', 'warmup_rep': 0, 'bench_rep': 1},
     {'name': 'allocbench/huge-reuse.R', 'warmup_rep': 0, 'bench_rep': 1},
+    # Heap sizing policies, compared on run time and peak RSS:
+    {'name': 'allocbench/gcpolicy-growth.R', 'warmup_rep': 0, 'bench_rep': 1},
+    {'name': 'allocbench/gcpolicy-pause.R', 'warmup_rep': 0, 'bench_rep': 1},
+    {'name': 'allocbench/gcpolicy-ceiling.R', 'warmup_rep': 0, 'bench_rep': 1},
+    # PROTECT and UNPROTECT as used by package C code:
+    {'name': 'allocbench/protect.R', 'warmup_rep': 0, 'bench_rep': 1},
+    # Output text connections, one line at a time:
+    {'name': 'allocbench/capture-output.R', 'warmup_rep': 0, 'bench_rep': 1},
     ]
 
 
@@ -0,0 +1,66 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* PROTECT-heavy loops in the style of package C code.  Unlike
+   allocator_test.cpp, this uses only the R API, so it measures the
+   PROTECT macros as package code sees them, and can be built against
+   CR as well as rho. */
+
+#include <Rinternals.h>
+
+/* Protect and unprotect an existing object n times, with no
+   allocation, so that only the cost of the PROTECT macros is
+   measured. */
+SEXP protect_loop(SEXP n_)
+{
+    int n = asInteger(n_);
+    SEXP x = PROTECT(allocVector(INTSXP, 1));
+    for (int i = 0; i < n; ++i) {
+	PROTECT_INDEX ipx;
+	PROTECT(x);
+	PROTECT(x);
+	PROTECT_WITH_INDEX(x, &ipx);
+	REPROTECT(x, ipx);
+	UNPROTECT(3);
+    }
+    UNPROTECT(1);
+    return x;
+}
+
+/* Build a list of n scalars, protecting each temporary as package
+   code typically does, so that collections occur while entries are on
+   the stack. */
+SEXP protect_alloc_loop(SEXP n_)
+{
+    int n = asInteger(n_);
+    SEXP ans = PROTECT(allocVector(VECSXP, n));
+    for (int i = 0; i < n; ++i) {
+	SEXP elt = PROTECT(ScalarInteger(i));
+	SEXP name = PROTECT(ScalarString(mkChar("x")));
+	setAttrib(elt, R_NamesSymbol, name);
+	SET_VECTOR_ELT(ans, i, elt);
+	UNPROTECT(2);
+    }
+    UNPROTECT(1);
+    return ans;
+}
@@ -204,23 +204,25 @@ def bench(benchmarks, gitref, args, rvm):
 
 # Runs an allocator benchmark suite on a single R version.
 def benchmark_allocator(benchmarks, gitref, args, rvm):
-  # First, build the allocator_test C library.
+  # First, build the native code libraries.
   bench_dir = os.getcwd()
   try:
     os.chdir('allocbench')
-    try:
-      os.remove('allocator_test.o')
-    except OSError:
-      pass
-    try:
-      os.remove('allocator_test.so')
-    except OSError:
-      pass
-    subprocess.call([
-        rvm['command'],
-        'CMD',
-        'SHLIB',
-        'allocator_test.cpp'])
+    for source in ['allocator_test.cpp', 'protect_test.c']:
+      name = os.path.splitext(source)[0]
+      try:
+        os.remove(name + '.o')
+      except OSError:
+        pass
+      try:
+        os.remove(name + '.so')
+      except OSError:
+        pass
+      subprocess.call([
+          rvm['command'],
+          'CMD',
+          'SHLIB',
+          source])
   finally:
     os.chdir(bench_dir)
   print('Starting benchmark runs for commit %s with RVM %s.'
@@ -0,0 +1,35 @@
+#!/bin/sh
+
+#  R : A Computer Language for Statistical Data Analysis
+#  Copyright (C) 2014 and onwards the Rho Project Authors.
+#
+#  Rho is not part of the R project, and bugs and other issues should
+#  not be reported via r-bugs or other R project channels; instead refer
+#  to the Rho website.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, a copy is available at
+#  https://www.R-project.org/Licenses/
+
+# Runs the random-access gather benchmark with small pages, with huge
+# pages, and with pre-faulted huge pages.
+#
+# Usage: hugepages.sh [Rscript] [size in GB]
+
+RSCRIPT=${1:-Rscript}
+export GATHER_GB=${2:-50}
+cd "$(dirname "$0")/allocbench" || exit 1
+
+R_HUGEPAGES=no "$RSCRIPT" gather.R
+R_HUGEPAGES=yes "$RSCRIPT" gather.R
+R_HUGEPAGES=yes R_HUGEPAGES_POPULATE=yes "$RSCRIPT" gather.R
@@ -371,6 +371,38 @@ fi
 rm -rf conftest* TMP])
 ])# R_PROG_CC_C_O_LO
 
+## R_PTHREAD
+## ---------
+## Find the flags needed to link code which creates threads (as
+## std::thread does), and substitute them as PTHREAD_LIBS.
+AC_DEFUN([R_PTHREAD],
+[AC_CACHE_CHECK([for flags needed to link with threads],
+                [r_cv_pthread_libs],
+[r_cv_pthread_libs=no
+r_save_LIBS="${LIBS}"
+for r_flags in "none required" -pthread -lpthread; do
+  if test "${r_flags}" != "none required"; then
+    LIBS="${r_flags} ${r_save_LIBS}"
+  fi
+  AC_LINK_IFELSE([AC_LANG_PROGRAM([[#include <pthread.h>
+static void* fun(void* arg) { return arg; }]],
+[[pthread_t thread;
+pthread_create(&thread, 0, fun, 0);
+pthread_join(thread, 0);]])],
+                 [r_cv_pthread_libs="${r_flags}"])
+  LIBS="${r_save_LIBS}"
+  test "${r_cv_pthread_libs}" != no && break
+done])
+case "${r_cv_pthread_libs}" in
+  "none required"|no) PTHREAD_LIBS= ;;
+  *) PTHREAD_LIBS="${r_cv_pthread_libs}" ;;
+esac
+if test "${r_cv_pthread_libs}" = no; then
+  AC_MSG_WARN([cannot link with threads: parallel file operations will fail])
+fi
+AC_SUBST(PTHREAD_LIBS)
+])# R_PTHREAD
+
 ## R_PROG_CC_MAKEFRAG
 ## ------------------
 ## Generate a Make fragment with suffix rules for the C compiler.
@@ -387,6 +387,7 @@ extern0 int	R_BrowseLines	INI_as(0);	/* lines/per call in browser */
 
 extern0 Rboolean R_KeepSource	INI_as(FALSE);	/* options(keep.source) */
 extern0 Rboolean R_CBoundsCheck	INI_as(FALSE);	/* options(CBoundsCheck) */
+extern0 Rboolean R_CheckBounds	INI_as(FALSE);	/* options(check.bounds) */
 extern0 int	R_WarnLength	INI_as(1000);	/* Error/warning max length */
 extern0 int	R_nwarnings	INI_as(50);
 extern uintptr_t R_CStackLimit	INI_as((uintptr_t)-1);	/* C stack limit */
@@ -538,6 +539,7 @@ LibExtern SEXP R_LogicalNAValue INI_as(NULL);
 
 #ifndef R_NO_REMAP
 # define allocCharsxp		Rf_allocCharsxp
+# define allocVectorsInList	Rf_allocVectorsInList
 # define asVecSize		Rf_asVecSize
 # define begincontext		Rf_begincontext
 # define BindDomain		Rf_BindDomain
@@ -734,6 +736,7 @@ SEXP Rf_EnsureString(SEXP);
 /* Other Internally Used Functions */
 
 SEXP Rf_allocCharsxp(R_len_t);
+void Rf_allocVectorsInList(SEXPTYPE, R_xlen_t, SEXP, R_xlen_t, R_xlen_t);
 SEXP Rf_append(SEXP, SEXP); /* apparently unused now */
 R_xlen_t asVecSize(SEXP x);
 void Rf_checkArityCall(SEXP, SEXP, SEXP);
@@ -864,6 +867,9 @@ void R_SaveToFile(SEXP, FILE*, int);
 void R_SaveToFileV(SEXP, FILE*, int, int);
 Rboolean R_seemsOldStyleS4Object(SEXP object);
 int R_SetOptionWarn(int);
+unsigned int R_OptionsVersion(void);
+int R_GetOptionWarn(void);
+int R_GetOptionScipen(void);
 int R_SetOptionWidth(int);
 void R_Suicide(const char *);
 void R_getProcTime(double *data);
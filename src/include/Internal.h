@@ -199,6 +199,7 @@ SEXP do_formatPOSIXlt(rho::Expression* call, const rho::BuiltInFunction* op, rho
 SEXP do_formals(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* fun_);
 SEXP do_function(SEXP, SEXP, SEXP, SEXP);  // Special
 SEXP do_gc(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* verbose_, rho::RObject* reset_);
+SEXP do_gcevents(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* reset_);
 SEXP do_gcinfo(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* verbose_);
 SEXP do_gctime(rho::Expression* call, const rho::BuiltInFunction* op, int num_args, ...);
 SEXP do_gctorture(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* on_);
@@ -223,6 +224,8 @@ SEXP do_globalenv(rho::Expression* call, const rho::BuiltInFunction* op);
 SEXP do_grep(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* pattern_, rho::RObject* x_, rho::RObject* ignore_case_, rho::RObject* value_, rho::RObject* perl_, rho::RObject* fixed_, rho::RObject* useBytes_, rho::RObject* invert_);
 SEXP do_grepraw(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* pattern_, rho::RObject* x_, rho::RObject* offset_, rho::RObject* ignore_case_, rho::RObject* fixed_, rho::RObject* value_, rho::RObject* all_, rho::RObject* invert_);
 SEXP do_gsub(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* pattern_, rho::RObject* replacement_, rho::RObject* x_, rho::RObject* ignore_case_, rho::RObject* perl_, rho::RObject* fixed_, rho::RObject* useBytes_);
+SEXP do_heapretainers(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* file_, rho::RObject* n_);
+SEXP do_heapsnapshot(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* file_);
 SEXP do_iconv(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* x_, rho::RObject* from_, rho::RObject* to_, rho::RObject* sub_, rho::RObject* mark_, rho::RObject* toRaw_);
 SEXP do_ICUget(SEXP, SEXP, SEXP, SEXP);
 SEXP do_ICUset(SEXP, SEXP, SEXP, SEXP);
@@ -286,6 +289,7 @@ SEXP do_maxcol(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObje
 SEXP do_memoryprofile(rho::Expression* call, const rho::BuiltInFunction* op);
 SEXP do_merge(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* xinds_, rho::RObject* yinds_, rho::RObject* all_x_, rho::RObject* all_y_);
 SEXP do_mget(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* x, rho::RObject* envir, rho::RObject* mode, rho::RObject* ifnotfound, rho::RObject* inherits);
+SEXP do_mmapvector(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* file_, rho::RObject* mode_, rho::RObject* length_, rho::RObject* offset_);
 SEXP do_missing(SEXP, SEXP, SEXP, SEXP);  // Special
 SEXP do_names(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* x_);
 SEXP do_namesgets(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* x_, rho::RObject* value_);
@@ -483,6 +487,11 @@ SEXP do_getallconnections(rho::Expression* call, const rho::BuiltInFunction* op)
 SEXP do_sumconnection(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* object_);
 SEXP do_sockconn(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* host_, rho::RObject* port_, rho::RObject* server_, rho::RObject* blocking_, rho::RObject* open_, rho::RObject* encoding_, rho::RObject* timeout_);
 SEXP do_sockselect(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* socklist_, rho::RObject* write_, rho::RObject* timeout_);
+SEXP do_sockcallbacks(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* con_, rho::RObject* read_, rho::RObject* drained_);
+SEXP do_socklisten(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* port_, rho::RObject* accept_);
+SEXP do_sockqueue(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* con_, rho::RObject* data_);
+SEXP do_sockrunevents(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* timeout_);
+SEXP do_sockunlisten(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* listener_);
 SEXP do_gzcon(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* con_, rho::RObject* level_, rho::RObject* allowNonCompressed_);
 SEXP do_memCompress(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* from_, rho::RObject* type_);
 SEXP do_memDecompress(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* from_, rho::RObject* type_);
@@ -492,6 +501,14 @@ SEXP do_hasProvenance(SEXP, SEXP, SEXP, SEXP);
 rho::ArgumentArrayFn do_provCommand;
 SEXP do_provenance(SEXP, SEXP, SEXP, SEXP);  // Special
 rho::ArgumentArrayFn do_provenance_graph;
+SEXP do_memocache(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* budget_, rho::RObject* dir_);
+SEXP do_memocacheclear(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* cache_);
+SEXP do_memocacheinfo(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* cache_);
+SEXP do_memoget(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* cache_, rho::RObject* key_);
+SEXP do_memokey(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* fkey_, rho::RObject* args_);
+SEXP do_memoput(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* cache_, rho::RObject* key_, rho::RObject* value_);
+SEXP do_bindingdigests(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* names_, rho::RObject* envir_);
+SEXP do_recordcommand(rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* fun_, rho::RObject* envir_);
 SEXP do_bserialize(SEXP, SEXP, SEXP, SEXP);  // Special
 SEXP do_bdeserialize(SEXP, SEXP, SEXP, SEXP);  // Special
 
@@ -536,6 +536,7 @@ SEXP GEcreateSnapshot(pGEDevDesc dd);
 void GEplaySnapshot(SEXP snapshot, pGEDevDesc dd);
 void GEonExit(void);
 void GEnullDevice(void);
+Rboolean GEdecimating(void);
 
 
 /* From ../../main/plot.c, used by ../../library/grid/src/grid.c : */
@@ -83,6 +83,11 @@ extern "C" {
 
 /* define inline-able functions */
 
+/* The functions below call Rf_protect() and Rf_unprotect() rather than
+   using the PROTECT macros: these expand to the static inline
+   functions of Rinternals.h, which C99 does not allow to be used in an
+   inline function with external linkage. */
+
 #ifdef INLINE_PROTECT
 extern int R_PPStackSize;
 extern int R_PPStackTop;
@@ -185,35 +190,35 @@ INLINE_FUN SEXP Rf_list1(SEXP s)
 
 INLINE_FUN SEXP Rf_list2(SEXP s, SEXP t)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = CONS(s, Rf_list1(t));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 
 INLINE_FUN SEXP Rf_list3(SEXP s, SEXP t, SEXP u)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = CONS(s, Rf_list2(t, u));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 
 INLINE_FUN SEXP Rf_list4(SEXP s, SEXP t, SEXP u, SEXP v)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = CONS(s, Rf_list3(t, u, v));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 INLINE_FUN SEXP Rf_list5(SEXP s, SEXP t, SEXP u, SEXP v, SEXP w)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = CONS(s, Rf_list4(t, u, v, w));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
@@ -245,41 +250,41 @@ INLINE_FUN SEXP Rf_lang1(SEXP s)
 
 INLINE_FUN SEXP Rf_lang2(SEXP s, SEXP t)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = LCONS(s, Rf_list1(t));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 INLINE_FUN SEXP Rf_lang3(SEXP s, SEXP t, SEXP u)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = LCONS(s, Rf_list2(t, u));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 INLINE_FUN SEXP Rf_lang4(SEXP s, SEXP t, SEXP u, SEXP v)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = LCONS(s, Rf_list3(t, u, v));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 INLINE_FUN SEXP Rf_lang5(SEXP s, SEXP t, SEXP u, SEXP v, SEXP w)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = LCONS(s, Rf_list4(t, u, v, w));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
 INLINE_FUN SEXP Rf_lang6(SEXP s, SEXP t, SEXP u, SEXP v, SEXP w, SEXP x)
 {
-    PROTECT(s);
+    Rf_protect(s);
     s = LCONS(s, Rf_list5(t, u, v, w, x));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return s;
 }
 
@@ -290,9 +295,9 @@ INLINE_FUN SEXP Rf_lang6(SEXP s, SEXP t, SEXP u, SEXP v, SEXP w, SEXP x)
 INLINE_FUN Rboolean Rf_conformable(SEXP x, SEXP y)
 {
     int i, n;
-    PROTECT(x = Rf_getAttrib(x, R_DimSymbol));
+    Rf_protect(x = Rf_getAttrib(x, R_DimSymbol));
     y = Rf_getAttrib(y, R_DimSymbol);
-    UNPROTECT(1);
+    Rf_unprotect(1);
     if ((n = Rf_length(x)) != Rf_length(y))
 	return FALSE;
     for (i = 0; i < n; i++)
@@ -535,10 +540,10 @@ INLINE_FUN SEXP Rf_ScalarComplex(Rcomplex x)
 INLINE_FUN SEXP Rf_ScalarString(SEXP x)
 {
     SEXP ans;
-    PROTECT(x);
+    Rf_protect(x);
     ans = Rf_allocVector(STRSXP, (R_xlen_t)1);
     SET_STRING_ELT(ans, (R_xlen_t)0, x);
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return ans;
 }
 
@@ -592,12 +597,12 @@ INLINE_FUN SEXP mkNamed(SEXPTYPE TYP, const char **names)
     R_xlen_t i, n;
 
     for (n = 0; strlen(names[n]) > 0; n++) {}
-    ans = PROTECT(Rf_allocVector(TYP, n));
-    nms = PROTECT(Rf_allocVector(STRSXP, n));
+    ans = Rf_protect(Rf_allocVector(TYP, n));
+    nms = Rf_protect(Rf_allocVector(STRSXP, n));
     for (i = 0; i < n; i++)
 	SET_STRING_ELT(nms, i, Rf_mkChar(names[i]));
     Rf_setAttrib(ans, R_NamesSymbol, nms);
-    UNPROTECT(2);
+    Rf_unprotect(2);
     return ans;
 }
 
@@ -608,9 +613,9 @@ INLINE_FUN SEXP Rf_mkString(const char *s)
 {
     SEXP t;
 
-    PROTECT(t = Rf_allocVector(STRSXP, (R_xlen_t)1));
+    Rf_protect(t = Rf_allocVector(STRSXP, (R_xlen_t)1));
     SET_STRING_ELT(t, (R_xlen_t)0, Rf_mkChar(s));
-    UNPROTECT(1);
+    Rf_unprotect(1);
     return t;
 }
 
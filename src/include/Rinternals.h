@@ -432,6 +432,23 @@ int  (HASHVALUE)(SEXP x);
 /* Pointer Protection and Unprotection */
 typedef size_t PROTECT_INDEX;
 
+/* Storage of a stack of node pointers, laid out so that C code can
+   push and pop entries without calling into rho.  Entries from base
+   up to (but not including) top are occupied, and storage extends up
+   to limit.  Entries at or above floor may be popped simply by
+   lowering top: entries below it have had their reference counts
+   increased by the garbage collector, so popping them needs the
+   help of rho::NodeStack. */
+typedef struct R_StackRegion {
+    SEXP* base;
+    SEXP* top;
+    SEXP* limit;
+    SEXP* floor;
+} R_StackRegion;
+
+/* The storage of the C pointer protection stack: */
+LibExtern R_StackRegion* R_PPStackRegion;
+
 #ifdef DISABLE_PROTECT_MACROS
   /* Danger!  You almost certainly don't need to use DISABLE_PROTECT_MACROS for
    * your code.
@@ -454,16 +471,16 @@ typedef size_t PROTECT_INDEX;
 #  define PROTECT_WITH_INDEX(x, i) (*i = 0, (void)(x))
 #  define REPROTECT(x, i) ((void)(x), (void)(i))
 #else
-#  define PROTECT(s)	Rf_protect(s)
-#  define UNPROTECT(n)	Rf_unprotect(n)
+#  define PROTECT(s)	R_PPStackPush(s)
+#  define UNPROTECT(n)	R_PPStackPop(n)
 #  define UNPROTECT_PTR(s)	Rf_unprotect_ptr(s)
 
 /* We sometimes need to coerce a protected value and place the new
    coerced value under protection.  For these cases PROTECT_WITH_INDEX
    saves an index of the protection location that can be used to
    replace the protected value using REPROTECT. */
-#  define PROTECT_WITH_INDEX(x,i) R_ProtectWithIndex(x,i)
-#  define REPROTECT(x,i) R_Reprotect(x,i)
+#  define PROTECT_WITH_INDEX(x,i) R_PPStackPushWithIndex(x,i)
+#  define REPROTECT(x,i) R_PPStackRetarget(x,i)
 #endif
 
 /* Evaluation Environment */
@@ -674,6 +691,45 @@ void Rf_unprotect_ptr(SEXP);
 void R_ProtectWithIndex(SEXP, PROTECT_INDEX *);
 void R_Reprotect(SEXP, PROTECT_INDEX);
 #endif
+
+/* Inline fast paths of the PROTECT family of macros.  These fall
+   back to the corresponding functions when the stack needs to grow,
+   or when an entry below R_PPStackRegion->floor is involved. */
+static R_INLINE SEXP R_PPStackPush(SEXP s)
+{
+    R_StackRegion* r = R_PPStackRegion;
+    if (r->top == r->limit)
+	return Rf_protect(s);
+    *r->top++ = s;
+    return s;
+}
+
+static R_INLINE void R_PPStackPop(int n)
+{
+    R_StackRegion* r = R_PPStackRegion;
+    if (n >= 0 && r->top - r->floor >= n)
+	r->top -= n;
+    else Rf_unprotect(n);
+}
+
+static R_INLINE void R_PPStackPushWithIndex(SEXP s, PROTECT_INDEX* i)
+{
+    R_StackRegion* r = R_PPStackRegion;
+    if (r->top == r->limit) {
+	R_ProtectWithIndex(s, i);
+	return;
+    }
+    *i = (PROTECT_INDEX)(r->top - r->base);
+    *r->top++ = s;
+}
+
+static R_INLINE void R_PPStackRetarget(SEXP s, PROTECT_INDEX i)
+{
+    R_StackRegion* r = R_PPStackRegion;
+    if (r->base + i >= r->floor && r->base + i < r->top)
+	r->base[i] = s;
+    else R_Reprotect(s, i);
+}
 SEXP R_tryEval(SEXP, SEXP, int *);
 SEXP R_tryEvalSilent(SEXP, SEXP, int *);
 const char *R_curErrorBuf();
@@ -0,0 +1,110 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file AdoptedVector.hpp
+ *
+ * @brief Class template rho::AdoptedVector.
+ */
+
+#ifndef RHO_ADOPTEDVECTOR_HPP
+#define RHO_ADOPTEDVECTOR_HPP
+
+#include <cstdlib>
+#include "rho/FixedVector.hpp"
+#include "rho/MemoryBank.hpp"
+
+namespace rho {
+    /** @brief FixedVector taking ownership of a malloc()ed buffer.
+     *
+     * An AdoptedVector uses as its elements a block of memory that
+     * was built up with malloc() and realloc() by code that did not
+     * know the final size in advance, such as serialization to
+     * memory.  The block becomes the property of the vector, and is
+     * released with free() when the vector is garbage collected, so
+     * that the result need not be copied into a new vector.
+     *
+     * Since AdoptedVector<T, ST> is derived from FixedVector<T, ST>,
+     * an AdoptedVector<Rbyte, RAWSXP> (for example) is a RawVector in
+     * every respect.  The adopted bytes are counted by MemoryBank
+     * like the elements of any other vector, and are registered with
+     * GCNode::registerExternalData() so that a pointer to them on
+     * the processor stack keeps the vector alive.
+     *
+     * @tparam T Element type; it must require neither construction
+     *           nor destruction.
+     *
+     * @tparam ST The SEXPTYPE of the vector.
+     */
+    template <typename T, SEXPTYPE ST>
+    class AdoptedVector : public FixedVector<T, ST> {
+    public:
+	typedef typename FixedVector<T, ST>::size_type size_type;
+
+	/** @brief Create a vector adopting a buffer.
+	 *
+	 * @param data Pointer to a block obtained from malloc() or
+	 *          realloc(), holding at least \a length elements.
+	 *          Ownership of the block passes to the vector even if
+	 *          an error is raised.  May be null if \a length is
+	 *          zero.
+	 *
+	 * @param length Number of elements.
+	 *
+	 * @return Pointer to the newly created vector.
+	 */
+	static AdoptedVector* create(T* data, size_type length);
+    protected:
+	~AdoptedVector()
+	{
+	    if (m_block)
+		GCNode::unregisterExternalData(m_block);
+	    std::free(m_block);
+	}
+    private:
+	void* m_block;
+
+	AdoptedVector(T* data, size_type length)
+	    : FixedVector<T, ST>(length, data), m_block(data)
+	{
+	    MemoryBank::adjustBytesAllocated(length * sizeof(T));
+	    if (data)
+		GCNode::registerExternalData(data, data + length, this);
+	}
+    };
+
+    template <typename T, SEXPTYPE ST>
+    AdoptedVector<T, ST>* AdoptedVector<T, ST>::create(T* data,
+						       size_type length)
+    {
+	void* storage;
+	try {
+	    storage = GCNode::operator new(sizeof(AdoptedVector));
+	} catch (...) {
+	    std::free(data);
+	    throw;
+	}
+	return new(storage) AdoptedVector(data, length);
+    }
+}  // namespace rho
+
+#endif  // RHO_ADOPTEDVECTOR_HPP
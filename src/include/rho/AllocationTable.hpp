@@ -245,6 +245,26 @@ public:
    */
   void printSummary() const;
 
+  /** @brief Number of hash buckets in the table. */
+  unsigned numBuckets() const {
+    return m_num_buckets;
+  }
+
+  /** @brief Number of collisions encountered by insertions. */
+  unsigned insertCollisions() const {
+    return m_num_insert_collisions;
+  }
+
+  /** @brief Number of collisions encountered by searches. */
+  unsigned searchCollisions() const {
+    return m_num_search_collisions;
+  }
+
+  /** @brief Number of collisions encountered by erasures. */
+  unsigned eraseCollisions() const {
+    return m_num_erase_collisions;
+  }
+
   /**
    * Attempts to resize the hashtable to use a new number of bits
    * for hash keys. The resize fails if the number of collisions
@@ -60,7 +60,8 @@ public:
    */
   AllocatorSuperblock(unsigned size_class, unsigned bitset_entries):
       m_size_class(size_class),
-      m_next_untouched(0) {
+      m_next_untouched(0),
+      m_idle_scans(0) {
     // Here we mark all bitset entries as free so that we don't have to do
     // precise range checking while iterating over currently allocated blocks
     // when the number of blocks is not evenly divisible by 64.
@@ -81,6 +82,15 @@ public:
    */
   static void* allocateBlock(size_t block_size);
 
+  /**
+   * Allocate up to count small blocks (block_size >= 32 && block_size <=
+   * 256) as runs of untouched blocks in superblocks, storing pointers to
+   * them in results.  Returns the number of blocks allocated, which is
+   * less than count only if the small object arena is full.
+   */
+  static size_t allocateBlocks(size_t block_size, size_t count,
+                               void** results);
+
   /**
    * Allocates the next untouched block in this superblock.
    * The superblock must have an untouched block when calling this function.
@@ -90,6 +100,36 @@ public:
   /** Allocate a medium or large object. */
   static void* allocateLarge(unsigned size_log2);
 
+  /**
+   * Allocate count medium objects as runs of untouched blocks in
+   * superblocks, storing pointers to them in results.
+   */
+  static void allocateLargeBlocks(unsigned size_log2, size_t count,
+                                  void** results);
+
+  /** @brief Return the memory of idle superblocks to the operating system.
+   *
+   * A superblock is idle if none of its blocks is allocated.  Blocks of
+   * idle superblocks are removed from the freelists, and the pages of the
+   * superblocks (other than the header) are released with madvise().  The
+   * superblocks are kept, and are reused in preference to new ones.
+   *
+   * @param min_idle_scans A superblock is released only if it has been
+   *          found idle by more than this many consecutive calls.
+   * @param retained_bytes Idle superblocks totalling up to this many bytes
+   *          are kept without being released.
+   *
+   * @return the number of bytes released by this call.
+   */
+  static size_t releaseIdleSuperblocks(unsigned min_idle_scans,
+                                       size_t retained_bytes);
+
+  /**
+   * Returns the number of bytes of superblocks currently released to the
+   * operating system and not yet reused.
+   */
+  static size_t releasedBytes();
+
   /** @brief Apply function to all current allocations. */
   static void applyToArenaAllocations(std::function<void(void*)> fun);
 
@@ -193,6 +233,14 @@ private:
   std::uint32_t m_next_untouched;
   std::uint64_t m_free[s_max_bitset_entries];  // Bit map of free blocks.
 
+  /**
+   * Number of consecutive calls of releaseIdleSuperblocks() that have found
+   * this superblock idle, or s_released if its pages have been released.
+   */
+  std::uint32_t m_idle_scans;
+
+  static constexpr std::uint32_t s_released = ~std::uint32_t{0};
+
   /** Samll object arena is 1Gb = 30 bits. */
   static constexpr unsigned s_arenasize = 1 << 30;
 
@@ -284,6 +332,23 @@ private:
    */
   static AllocatorSuperblock* arenaSuperblockFromPointer(uintptr_t pointer);
 
+  /** Returns true if no block in this superblock is allocated. */
+  bool isIdle() const;
+
+  /**
+   * Allocates the next untouched blocks in this superblock, up to
+   * max_count of them, storing pointers to them in results.  The
+   * superblock must have an untouched block when calling this function.
+   * Returns the number of blocks allocated.
+   */
+  size_t allocateUntouchedRun(size_t max_count, void** results);
+
+  /**
+   * Release the pages of this superblock, other than the header, to the
+   * operating system.
+   */
+  void releasePages();
+
   /** Print debug info about all small-object superblocks. */
   static void debugPrintSmallSuperblocks();
 
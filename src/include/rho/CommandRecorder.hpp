@@ -0,0 +1,205 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file CommandRecorder.hpp
+ *
+ * @brief Class rho::CommandRecorder.
+ */
+
+#ifndef RHO_COMMANDRECORDER_HPP
+#define RHO_COMMANDRECORDER_HPP
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rho/Environment.hpp"
+#include "rho/Frame.hpp"
+#include "rho/GCRoot.hpp"
+
+namespace rho {
+    /** @brief Record of the inputs and outputs of a command.
+     *
+     * A CommandRecorder records, for as long as it exists, which
+     * bindings of a given Environment and its enclosing
+     * Environments up to the global environment (its scope()) are
+     * read and which are written, and which files are opened for
+     * reading.  It is used to re-execute a script incrementally: a
+     * command need not be evaluated again if the bindings and files
+     * it read are unchanged, provided the bindings it wrote are
+     * restored.
+     *
+     * As with CommandChronicle, bindings which are written and then
+     * read back are not regarded as having been read.  The value of
+     * a binding is retained when it is first read, and is marked as
+     * shared so that it cannot subsequently be modified in place.
+     * Every binding written is recorded, whether or not it was read
+     * first.
+     *
+     * The recording uses the read and write monitors of class
+     * Frame, which it installs on construction, calling on to any
+     * monitors already installed, e.g. by ProvenanceTracker.
+     * CommandRecorder objects are intended to be allocated on the
+     * processor stack, and may be nested: a binding read or written
+     * is reported to all the CommandRecorder objects in existence
+     * whose scope includes its Frame.
+     */
+    class CommandRecorder {
+    public:
+	/** @brief Record of a binding read.
+	 */
+	struct Read {
+	    const Symbol* symbol;
+	    unsigned int depth;  // Position in scope() of the
+	      // Environment whose Frame contains the binding.
+	    GCRoot<> value;  // Value when first read.  (If the
+	      // binding was to a Promise, this is the Promise.)
+	};
+
+	/** @brief Vector of bindings read.
+	 */
+	typedef std::vector<Read> ReadVector;
+
+	/** @brief Vector of bindings written.
+	 *
+	 * Each element comprises the Symbol of a binding written,
+	 * and the position in scope() of the Environment whose Frame
+	 * contains it.
+	 */
+	typedef std::vector<std::pair<const Symbol*, unsigned int> >
+	WriteVector;
+
+	/** @brief Constructor.
+	 *
+	 * @param env Non-null pointer to the Environment whose
+	 *          bindings, and those of its scope(), are to be
+	 *          monitored.
+	 */
+	explicit CommandRecorder(Environment* env);
+
+	~CommandRecorder();
+
+	/** @brief Bindings read.
+	 *
+	 * @return the bindings read, in the order in which they were
+	 * first read.
+	 */
+	const ReadVector& bindingsRead() const
+	{
+	    return m_reads;
+	}
+
+	/** @brief Bindings written.
+	 *
+	 * @return the bindings written, in the order in which they
+	 * were first written.
+	 */
+	const WriteVector& bindingsWritten() const
+	{
+	    return m_writes;
+	}
+
+	/** @brief Files opened for reading.
+	 *
+	 * @return the absolute paths of the files opened for reading.
+	 */
+	const std::set<std::string>& filesRead() const
+	{
+	    return m_files;
+	}
+
+	/** @brief Has an active binding been read?
+	 *
+	 * @return true iff an active binding has been read, in which
+	 * case the inputs of the command cannot be known.
+	 */
+	bool readActiveBinding() const
+	{
+	    return m_read_active;
+	}
+
+	/** @brief Report that a file is being opened for reading.
+	 *
+	 * This function should be called whenever a file is opened
+	 * for reading, and reports the fact to any CommandRecorder
+	 * objects in existence.
+	 *
+	 * @param path Path (possibly relative) of the file.
+	 */
+	static void noteFileRead(const char* path);
+
+	/** @brief Environments monitored on behalf of an Environment.
+	 *
+	 * @param env Non-null pointer to an Environment.
+	 *
+	 * @return \a env followed by its enclosing Environments, as
+	 * far as the global environment, but stopping before any
+	 * package or namespace environment, the base environment or
+	 * the empty environment.
+	 */
+	static std::vector<Environment*> scope(Environment* env);
+    private:
+	struct Monitored {
+	    GCRoot<Environment> env;
+	    bool was_read_monitored;
+	    bool was_write_monitored;
+	};
+
+	typedef std::pair<const Symbol*, unsigned int> Key;
+
+	static CommandRecorder* s_current;  // The innermost
+	  // CommandRecorder, or null if none.
+	static Frame::monitor s_old_read_monitor;
+	static Frame::monitor s_old_write_monitor;
+	static bool s_reading;  // True while a CommandRecorder is
+	  // itself reading a binding.
+
+	std::vector<Monitored> m_scope;
+	CommandRecorder* m_outer;
+	bool m_read_active;
+	ReadVector m_reads;
+	WriteVector m_writes;
+	std::set<Key> m_read_keys;
+	std::set<Key> m_written_keys;
+	std::set<std::string> m_files;
+
+	CommandRecorder(const CommandRecorder&) = delete;
+	CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+	// Position of frame in m_scope, or -1 if absent:
+	int depth(const Frame* frame) const;
+
+	// Should a binding of frame be passed on to the monitors that
+	// were installed before the CommandRecorders?
+	static bool wasMonitored(const Frame* frame, bool read);
+
+	static void monitorRead(const Frame::Binding& bdg);
+	static void monitorWrite(const Frame::Binding& bdg);
+
+	void readBinding(const Frame::Binding& bdg);
+	void writeBinding(const Frame::Binding& bdg);
+    };
+}  // namespace rho
+
+#endif  // RHO_COMMANDRECORDER_HPP
@@ -0,0 +1,122 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file ContentHash.hpp
+ *
+ * @brief Class rho::ContentHash.
+ */
+
+#ifndef RHO_CONTENTHASH_HPP
+#define RHO_CONTENTHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rho {
+    class RObject;
+
+    /** @brief Streaming 128-bit hash of bytes and R objects.
+     *
+     * A ContentHash runs two lanes of the XXH64 algorithm, with
+     * different seeds, over the same input, giving a 128-bit digest
+     * that is fast to compute and for which accidental collisions
+     * can be disregarded.  It is not a cryptographic hash.
+     *
+     * R objects are hashed by streaming their serialization (in
+     * native binary format, version 2) through the hash, so that
+     * equal objects have equal digests without a serialized copy
+     * ever being made.  The serialization header, which records the
+     * version of R, is left out, so digests are the same in different
+     * versions of rho.  External pointers are hashed by their
+     * addresses, as their serializations are all alike.
+     */
+    class ContentHash {
+    public:
+	/** @brief 128-bit digest.
+	 */
+	struct Digest {
+	    std::uint64_t hi;
+	    std::uint64_t lo;
+
+	    bool operator==(const Digest& other) const
+	    {
+		return hi == other.hi && lo == other.lo;
+	    }
+
+	    bool operator!=(const Digest& other) const
+	    {
+		return !(*this == other);
+	    }
+
+	    /** @brief The digest as 32 lower-case hexadecimal digits.
+	     */
+	    std::string hex() const;
+	};
+
+	ContentHash();
+
+	/** @brief Add bytes to the hash.
+	 *
+	 * @param data Pointer to the first byte.
+	 *
+	 * @param length Number of bytes.
+	 */
+	void update(const void* data, std::size_t length);
+
+	/** @brief Add an R object to the hash.
+	 *
+	 * @param object Pointer, possibly null, to the object.
+	 */
+	void update(const RObject* object);
+
+	/** @brief Digest of the input so far.
+	 *
+	 * The hash is not altered, so more input may follow.
+	 */
+	Digest digest() const;
+
+	/** @brief Digest of the serialization of an object.
+	 *
+	 * @param object Pointer, possibly null, to the object.
+	 *
+	 * @return The digest of \a object, as if it had been passed
+	 * to update() on a newly constructed ContentHash.
+	 */
+	static Digest digest(const RObject* object);
+    private:
+	struct Lane {
+	    std::uint64_t v[4];
+	    std::uint64_t seed;
+	};
+
+	Lane m_lanes[2];
+	std::uint64_t m_total;
+	std::size_t m_buflen;
+	unsigned char m_buffer[32];
+
+	void stripes(const unsigned char* data, std::size_t length);
+    };
+}  // namespace rho
+
+#endif  // RHO_CONTENTHASH_HPP
@@ -0,0 +1,201 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file FileBackedVector.hpp
+ *
+ * @brief Class template rho::FileBackedVector.
+ */
+
+#ifndef RHO_FILEBACKEDVECTOR_HPP
+#define RHO_FILEBACKEDVECTOR_HPP
+
+#include <memory>
+#include "rho/FixedVector.hpp"
+#include "rho/MemoryBank.hpp"
+
+namespace rho {
+    /** @brief Private memory mapping of a region of a file.
+     *
+     * The mapping is private: pages are read from the file by the
+     * operating system as they are first touched, and any page that
+     * is written to is copied, so that the file itself is never
+     * modified.
+     */
+    class FileMapping {
+    public:
+	/** @brief Map a region of a file.
+	 *
+	 * @param path Name of the file.
+	 *
+	 * @param offset Offset in bytes of the start of the region
+	 *          within the file.
+	 *
+	 * @param bytes Length of the region in bytes, or
+	 *          <tt>size_t(-1)</tt> to map from \a offset to the
+	 *          end of the file.
+	 *
+	 * @param granule The length of the region must be a multiple
+	 *          of this, and so must \a offset (so that the mapped
+	 *          data is suitably aligned for elements of this
+	 *          size).
+	 *
+	 * An error is raised if the file cannot be opened or mapped,
+	 * or if the region does not lie within the file.
+	 */
+	FileMapping(const char* path, std::size_t offset,
+		    std::size_t bytes, std::size_t granule);
+
+	~FileMapping();
+
+	/** @brief Start of the mapped region.
+	 *
+	 * @return Pointer to the first byte of the mapped region, or
+	 * a null pointer if the region is empty.
+	 */
+	void* data() const
+	{
+	    return m_data;
+	}
+
+	/** @brief Length of the mapped region.
+	 *
+	 * @return Length in bytes of the mapped region.
+	 */
+	std::size_t size() const
+	{
+	    return m_size;
+	}
+    private:
+	void* m_base;  // Page-aligned start of the mapping.
+	std::size_t m_length;  // Length of the mapping from m_base.
+	void* m_data;
+	std::size_t m_size;
+
+	FileMapping(const FileMapping&) = delete;
+	FileMapping& operator=(const FileMapping&) = delete;
+    };
+
+    /** @brief FixedVector whose elements are mapped from a file.
+     *
+     * The elements of a FileBackedVector are not allocated from the
+     * rho heap: they are a FileMapping of a region of a file holding
+     * the elements in the machine's native binary representation.
+     * Pages of the file are therefore read in only as they are
+     * used, and a vector larger than physical memory can be used
+     * provided that only part of it is touched at a time.
+     * Modifications made in place are not written back to the file.
+     * The mapping is released when the vector is garbage collected.
+     *
+     * Since FileBackedVector<T, ST> is derived from FixedVector<T,
+     * ST>, a FileBackedVector<double, REALSXP> (for example) is a
+     * RealVector in every respect.  clone() yields an ordinary
+     * FixedVector on the heap.
+     *
+     * The mapped bytes are not counted by MemoryBank, so a
+     * FileBackedVector contributes only its header to the
+     * allocation totals that drive garbage collection.  They are
+     * registered with GCNode::registerExternalData(), so a pointer
+     * to the elements on the processor stack keeps the vector
+     * alive, as it would for an ordinary FixedVector.
+     *
+     * @tparam T Element type; it must require neither construction
+     *           nor destruction.
+     *
+     * @tparam ST The SEXPTYPE of the vector.
+     */
+    template <typename T, SEXPTYPE ST>
+    class FileBackedVector : public FixedVector<T, ST> {
+    public:
+	typedef typename FixedVector<T, ST>::size_type size_type;
+
+	/** @brief Create a vector mapped from a file.
+	 *
+	 * @param path Name of the file.
+	 *
+	 * @param offset Offset in bytes within the file of the first
+	 *          element.  Must be a multiple of <tt>sizeof(T)</tt>.
+	 *
+	 * @param length Number of elements, or <tt>size_type(-1)</tt>
+	 *          to take all the elements from \a offset to the end
+	 *          of the file.
+	 *
+	 * @return Pointer to the newly created vector.
+	 */
+	static FileBackedVector* create(const char* path, std::size_t offset,
+					size_type length);
+
+	// Virtual function of VectorBase:
+	void decreaseSizeInPlace(size_type new_size) override;
+    protected:
+	~FileBackedVector()
+	{
+	    // ~FixedVector() deducts the elements from the bytes
+	    // allocated, but they were never added:
+	    MemoryBank::adjustBytesAllocated(this->size() * sizeof(T));
+	    if (m_mapping->data())
+		GCNode::unregisterExternalData(m_mapping->data());
+	    delete m_mapping;
+	}
+    private:
+	FileMapping* m_mapping;
+
+	FileBackedVector(FileMapping* mapping)
+	    : FixedVector<T, ST>(mapping->size()/sizeof(T),
+				 static_cast<T*>(mapping->data())),
+	      m_mapping(mapping)
+	{
+	    if (mapping->data()) {
+		char* data = static_cast<char*>(mapping->data());
+		GCNode::registerExternalData(data, data + mapping->size(),
+					     this);
+	    }
+	}
+    };
+
+    template <typename T, SEXPTYPE ST>
+    FileBackedVector<T, ST>*
+    FileBackedVector<T, ST>::create(const char* path, std::size_t offset,
+				    size_type length)
+    {
+	std::size_t bytes = std::size_t(-1);
+	if (length != size_type(-1)) {
+	    bytes = length * sizeof(T);
+	    if (bytes / sizeof(T) != length)
+		Rf_error(_("request to create impossibly large vector."));
+	}
+	std::unique_ptr<FileMapping>
+	    mapping(new FileMapping(path, offset, bytes, sizeof(T)));
+	void* storage = GCNode::operator new(sizeof(FileBackedVector));
+	return new(storage) FileBackedVector(mapping.release());
+    }
+
+    template <typename T, SEXPTYPE ST>
+    void FileBackedVector<T, ST>::decreaseSizeInPlace(size_type new_size)
+    {
+	size_type old_size = this->size();
+	FixedVector<T, ST>::decreaseSizeInPlace(new_size);
+	MemoryBank::adjustBytesAllocated((old_size - new_size) * sizeof(T));
+    }
+}  // namespace rho
+
+#endif  // RHO_FILEBACKEDVECTOR_HPP
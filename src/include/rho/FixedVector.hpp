@@ -67,6 +67,31 @@ namespace rho {
 	 */
 	static FixedVector* create(size_type sz);
 
+	/** @brief Create several vectors of the same size.
+	 *
+	 * This has the effect of calling create(sz) \a count times,
+	 * but the memory for small vectors is obtained with
+	 * GCNode::allocateBatch(), which is considerably faster.
+	 * Batches are limited in total size, so garbage collection
+	 * is still considered regularly.
+	 *
+	 * @tparam OutIter Output iterator type, to whose elements
+	 *           <tt>FixedVector*</tt> is assignable.
+	 *
+	 * @param sz Number of elements required in each vector.
+	 *          Zero is permissible.
+	 *
+	 * @param count Number of vectors required.
+	 *
+	 * @param out Iterator to which pointers to the new vectors are
+	 *          written.  Garbage collection may occur between the
+	 *          vectors being created, so the destination should
+	 *          protect them from garbage collection, as for example
+	 *          the elements of a ListVector do.
+	 */
+	template <typename OutIter>
+	static void createBatch(size_type sz, std::size_t count, OutIter out);
+
 	/** @brief Create a vector from a range.
 	 * 
 	 * @tparam An iterator type, at least a forward iterator.
@@ -211,6 +236,27 @@ namespace rho {
 
 	// Virtual function of GCNode:
 	void detachReferents() override;
+
+	/** @brief Create a vector whose elements are stored outside
+	 *         the vector object.
+	 *
+	 * This is for derived classes, such as FileBackedVector,
+	 * which obtain the element storage by other means and are
+	 * responsible for releasing it.  The elements are neither
+	 * constructed nor destructed, so this constructor is only
+	 * available for element types that require neither.
+	 *
+	 * @param sz Number of elements.  Zero is permissible.
+	 *
+	 * @param data Pointer to storage for \a sz elements.
+	 */
+	FixedVector(size_type sz, T* data)
+	    : VectorBase(ST, sz), m_data(data)
+	{
+	    static_assert(!ElementTraits::MustConstruct<T>::value
+			  && !ElementTraits::MustDestruct<T>::value,
+			  "External storage requires trivial elements.");
+	}
     private:
 	T* m_data;  // pointer to the vector's data block.
 
@@ -331,6 +377,42 @@ rho::FixedVector<T, ST>::create(size_type sz)
     return new(storage) FixedVector(sz);
 }
 
+template <typename T, SEXPTYPE ST>
+template <typename OutIter>
+void rho::FixedVector<T, ST>::createBatch(size_type sz, std::size_t count,
+					   OutIter out)
+{
+    // Sized as in allocate():
+    size_type blocksize = (sz + 1) * sizeof(T);
+    if (blocksize / sizeof(T) != sz + 1)
+	Rf_error(_("request to create impossibly large vector."));
+    std::size_t bytes = blocksize + sizeof(FixedVector) - sizeof(T);
+
+    // Garbage collection is considered only once per batch, so
+    // batches are limited in total size as well as in number, and
+    // vectors too large to share a batch are created singly:
+    const std::size_t batch_size = 256;
+    const std::size_t batch_bytes = 64 * 1024;
+    std::size_t per_batch = std::min(batch_size, batch_bytes / bytes);
+    if (per_batch < 2) {
+	for (; count > 0; --count) {
+	    *out = create(sz);
+	    ++out;
+	}
+	return;
+    }
+    void* storage[batch_size];
+    while (count > 0) {
+	std::size_t n = (count < per_batch ? count : per_batch);
+	GCNode::allocateBatch(bytes, n, storage);
+	for (std::size_t i = 0; i < n; ++i) {
+	    *out = new(storage[i]) FixedVector(sz);
+	    ++out;
+	}
+	count -= n;
+    }
+}
+
 template <typename T, SEXPTYPE ST>
 rho::FixedVector<T, ST>* rho::FixedVector<T, ST>::clone() const
 {
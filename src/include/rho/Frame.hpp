@@ -772,6 +772,26 @@ namespace rho {
 	    return m_locked;
 	}
 
+	/** @brief Is reading of Symbol values monitored?
+	 *
+	 * @return true iff read monitoring has been enabled for this
+	 * Frame using enableReadMonitoring().
+	 */
+	bool isReadMonitored() const
+	{
+	    return m_read_monitored;
+	}
+
+	/** @brief Is writing of Symbol values monitored?
+	 *
+	 * @return true iff write monitoring has been enabled for this
+	 * Frame using enableWriteMonitoring().
+	 */
+	bool isWriteMonitored() const
+	{
+	    return m_write_monitored;
+	}
+
 	/** @brief Lock this Frame.
 	 *
 	 * Locking a Frame prevents the addition or removal of
@@ -35,10 +35,15 @@
 #define GCMANAGER_HPP
 
 #include <cstddef>
+#include <cstdio>
+#include <deque>
 #include <iosfwd>
+#include <vector>
 #include "rho/MemoryBank.hpp"
 
 namespace rho {
+    class HeapSizingPolicy;
+
     /** @brief Class for managing garbage collection.
      *
      * This class only has static members.  A garbage
@@ -88,6 +93,98 @@ namespace rho {
 	    }
 	};
 
+	/** @brief Record of a completed garbage collection.
+	 *
+	 * GCManager keeps a record of the most recent collections
+	 * (see events()), and optionally writes each record to a log
+	 * file (see setEventLog()).
+	 */
+	struct Event {
+	    /** @brief Sequence number of the collection within the
+	     * session.
+	     */
+	    unsigned int number;
+
+	    /** @brief Time at which the collection began, in seconds
+	     * since the epoch.
+	     */
+	    double time;
+
+	    /** @brief true if a mark-sweep collection was carried out
+	     * (as well as a lightweight collection).
+	     */
+	    bool full;
+
+	    /** @brief What initiated the collection: "explicit" for a
+	     * forced full collection, "deferred" for a collection
+	     * postponed while collection was inhibited, otherwise
+	     * "allocation".
+	     */
+	    const char* trigger;
+
+	    /** @brief Total duration of the collection in seconds.
+	     *
+	     * This includes the phases below, and the return of free
+	     * memory to the operating system.  It does not include
+	     * finalizers, which are run after the collection.
+	     */
+	    double pause;
+
+	    /** @brief Seconds spent scanning the roots, marking and
+	     * sweeping, summed over the lightweight and any
+	     * mark-sweep collection.
+	     */
+	    double root_scan, mark, sweep;
+
+	    /** @brief Bytes allocated via MemoryBank, and GCNode
+	     * objects in existence, at the start and end of the
+	     * collection.
+	     */
+	    std::size_t bytes_before, bytes_after;
+	    std::size_t nodes_before, nodes_after;
+
+	    /** @brief Bytes of allocator superblocks returned to the
+	     * operating system, as reported by
+	     * GCNodeAllocator::releasedBytes() at the end of the
+	     * collection.
+	     */
+	    std::size_t released_bytes;
+
+	    /** @brief Statistics of the allocator's AllocationTable
+	     * at the end of the collection: number of buckets, and
+	     * cumulative collisions on insertion, search and erasure.
+	     */
+	    unsigned int table_buckets;
+	    unsigned int insert_collisions, search_collisions,
+		erase_collisions;
+
+	    /** @brief Number of free blocks on the freelist of each
+	     * allocator size class at the end of the collection.
+	     *
+	     * Walking the freelists is costly, so this is recorded
+	     * only for mark-sweep collections, and is otherwise empty.
+	     */
+	    std::vector<std::size_t> freelists;
+	};
+
+	/** @brief Discard the recorded collection events.
+	 */
+	static void clearEvents();
+
+	/** @brief Records of recent garbage collections.
+	 *
+	 * @return Records of the most recent collections (at most
+	 * maxEvents() of them), oldest first.
+	 */
+	static const std::deque<Event>& events()
+	{
+	    return s_events;
+	}
+
+	/** @brief Maximum number of collection records retained.
+	 */
+	static const std::size_t maxEvents = 1000;
+
 	/** @brief Initiate a garbage collection.
 	 *
 	 * It is currently an error to initiate a garbage collection when
@@ -95,6 +192,13 @@ namespace rho {
 	 */
 	static void gc(bool force_full_collection = true);
 
+	/** @brief Policy determining the collection thresholds.
+	 *
+	 * @return Pointer to the HeapSizingPolicy currently in
+	 * effect.
+	 */
+	static HeapSizingPolicy* heapSizingPolicy();
+
 	static void maybeGC() {
 	    if (s_gc_pending
 		|| MemoryBank::bytesAllocated() >
@@ -164,6 +268,28 @@ namespace rho {
 	 */
 	static void setGCThreshold(size_t initial_threshold);
 
+	/** @brief Direct collection records to a log file.
+	 *
+	 * @param path Name of a file to which a record of each
+	 *          subsequent garbage collection will be appended, as
+	 *          a line of JSON.  If this is a null pointer or an
+	 *          empty string, logging is turned off.
+	 *
+	 * @return true if successful, false if the file could not be
+	 * opened (in which case logging is turned off).
+	 */
+	static bool setEventLog(const char* path);
+
+	/** @brief Select the heap sizing policy.
+	 *
+	 * @param policy Pointer to the policy to be used to set the
+	 *          collection thresholds after each subsequent garbage
+	 *          collection.  GCManager takes ownership of the
+	 *          policy, and deletes the previous one.  If this is a
+	 *          null pointer, a GrowthHeapPolicy is used.
+	 */
+	static void setHeapSizingPolicy(HeapSizingPolicy* policy);
+
 	/** @brief Set/unset monitors on mark-sweep garbage collection.
 	 *
 	 * @param pre_gc If not a null pointer, this function will be
@@ -225,6 +351,11 @@ namespace rho {
 	static bool s_gc_is_running;
 	static bool s_gc_pending;
 
+	static HeapSizingPolicy* s_policy;
+
+	static std::deque<Event> s_events;
+	static std::FILE* s_event_log;
+
 	static size_t s_max_bytes;
 	static size_t s_max_nodes;
 
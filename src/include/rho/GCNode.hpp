@@ -154,6 +154,29 @@ namespace rho {
 	    return where;
 	}
 
+	/** @brief Allocate memory for several objects.
+	 *
+	 * This has the effect of calling operator new(bytes) \a count
+	 * times, but garbage collection is considered only once, and
+	 * the memory is obtained with
+	 * GCNodeAllocator::allocateBatch().  It is intended for
+	 * creating large numbers of small objects of the same size,
+	 * such as the elements of a PairList.
+	 *
+	 * @param bytes Number of bytes of memory required for each
+	 *          object.
+	 *
+	 * @param count Number of objects.
+	 *
+	 * @param results Pointer to an array of at least \a count
+	 *          elements, in which pointers to the allocated memory
+	 *          blocks are stored.  An object of a class derived
+	 *          from GCNode, of size \a bytes, should be constructed
+	 *          in each block by placement new: until then the block
+	 *          is kept from garbage collection as by operator new.
+	 */
+	static void allocateBatch(size_t bytes, size_t count, void** results);
+
 	/** @brief Deallocate memory
 	 *
 	 * Deallocate memory previously allocated by operator new.
@@ -206,6 +229,34 @@ namespace rho {
 	 */
 	static void gc(bool markSweep);
 
+	/** @brief Durations of the phases of a garbage collection.
+	 */
+	struct PhaseTimes {
+	    /** @brief Seconds spent identifying the nodes referenced
+	     * from the C++ stack.
+	     */
+	    double root_scan;
+
+	    /** @brief Seconds spent in the mark phase (zero for a
+	     * lightweight collection).
+	     */
+	    double mark;
+
+	    /** @brief Seconds spent deleting garbage nodes.
+	     */
+	    double sweep;
+	};
+
+	/** @brief Phase durations of the most recent collection.
+	 *
+	 * @return The durations of the phases of the most recent call
+	 * of gc().
+	 */
+	static const PhaseTimes& lastPhaseTimes()
+	{
+	    return s_phase_times;
+	}
+
 	/** @brief Number of GCNode objects in existence.
 	 *
 	 * @return the number of GCNode objects currently in
@@ -234,10 +285,37 @@ namespace rho {
 	virtual void visitReferents(const_visitor* v) const {}
 
 	// If candidate_pointer is a (possibly internal) pointer to a GCNode,
+	// or to external data registered by registerExternalData(),
 	// returns the pointer to that node.
 	// Otherwise returns nullptr.
 	static GCNode* asGCNode(void* candidate_pointer);
 
+	/** @brief Register data owned by a node outside the rho heap.
+	 *
+	 * Thereafter a pointer from \a begin up to and including \a
+	 * end found by the conservative stack scan protects \a node
+	 * from garbage collection, just as a pointer into the node
+	 * itself does.  This allows C code to hold only a pointer to
+	 * the elements of a vector whose elements are not allocated
+	 * with the vector, e.g. by mapping a file.
+	 *
+	 * @param begin Start of the data.
+	 *
+	 * @param end One past the end of the data.
+	 *
+	 * @param node Non-null pointer to the node owning the data,
+	 *          whose destructor must call
+	 *          unregisterExternalData(begin).
+	 */
+	static void registerExternalData(const void* begin, const void* end,
+					 const GCNode* node);
+
+	/** @brief Cancel registerExternalData().
+	 *
+	 * @param begin Start of data previously registered.
+	 */
+	static void unregisterExternalData(const void* begin);
+
     protected:
 	/**
 	 * @note The destructor is protected to ensure that GCNode
@@ -292,6 +370,7 @@ namespace rho {
 	  // pointers to nodes whose reference count has fallen to
 	  // zero (but may subsequently have increased again).
 	static unsigned int s_num_nodes;  // Number of nodes in existence
+	static PhaseTimes s_phase_times;
 
 	// Flag that is set if the on_stack bits are known to be up to date.
 	// If this true, then objects can be deleted immediately when
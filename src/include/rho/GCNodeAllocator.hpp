@@ -29,8 +29,10 @@
 
 #include <assert.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <vector>
 
 #include "rho/AddressSanitizer.hpp"
 
@@ -61,6 +63,7 @@ public:
 
 private:
   friend GCNodeAllocator;
+  friend AllocatorSuperblock;
 
   /** Link to the next node in this freelist. */
   FreeListNode* m_next;
@@ -96,15 +99,61 @@ public:
    */
   static void* allocate(std::size_t bytes);
 
+  /** @brief Allocate several objects of the same size.
+   *
+   * This is equivalent to calling allocate(bytes) \a count times, but
+   * the size class is determined only once, and blocks are taken from
+   * its freelist and then as runs of untouched blocks in superblocks.
+   *
+   * @param bytes Minimum size in bytes of each object.
+   *
+   * @param count Number of objects to allocate.
+   *
+   * @param results Pointer to an array of at least \a count elements, in
+   *          which pointers to the allocations are stored.  Each is to
+   *          be freed individually with free().
+   */
+  static void allocateBatch(std::size_t bytes, std::size_t count,
+                            void** results);
+
+  /** @brief Size of the block holding an allocation.
+   *
+   * @param pointer Pointer previously returned by allocate() and not yet
+   *          freed.
+   *
+   * @return The number of bytes of the block in which the allocation was
+   * made, i.e. the requested size rounded up to the size class of the
+   * block, or zero if \a pointer is not a current allocation.  This takes
+   * constant time.
+   */
+  static std::size_t allocationSize(const void* pointer);
+
   /** @brief Apply function to all current allocations. */
   static void applyToAllAllocations(std::function<void(void*)> f);
 
   /** @brief Free a previously allocated object. */
   static void free(void* p);
 
-  /** @brief Must be called before any allocations can be made. */
+  /** @brief Must be called before any allocations can be made.
+   *
+   * If the environment variable \c R_HUGEPAGES is \c yes (and the
+   * platform supports it), the small object arena is advised for
+   * transparent huge pages, and allocations of 2 MB or more are mapped
+   * directly and advised likewise.  If in addition \c
+   * R_HUGEPAGES_POPULATE is \c yes, these direct mappings are pre-faulted
+   * when they are created.
+   */
   static void initialize();
 
+  /** @brief Are huge pages in use?
+   *
+   * @return true iff the allocator was initialized to use transparent
+   * huge pages.
+   */
+  static bool usingHugePages() {
+    return s_use_huge_pages;
+  }
+
   /** @brief Find heap allocation start pointer.
    *
    * This function finds the corresponding allocation for an internal or
@@ -121,6 +170,55 @@ public:
   /** @brief Print allocator state summary for debugging. */
   static void printSummary();
 
+  /** @brief Lengths of the freelists.
+   *
+   * @param lengths Pointer to a vector which on return will contain, for
+   *          each size class of superblock (small and medium), the number
+   *          of free blocks on its freelist.  This takes time proportional
+   *          to the number of free blocks.
+   */
+  static void freelistLengths(std::vector<std::size_t>* lengths);
+
+  /** @brief The table of medium and large allocations.
+   *
+   * @return Pointer to the table, for reporting its statistics.
+   */
+  static const AllocationTable* allocationTable() {
+    return s_alloctable;
+  }
+
+  /** @brief Return memory held for free blocks to the operating system.
+   *
+   * This is intended to be called after a mark-sweep garbage collection.
+   * It releases the pages of superblocks in which no block has been
+   * allocated for a number of consecutive calls (see setReleasePolicy()),
+   * and asks the C library to return free memory from its own heap, where
+   * large allocations are made.
+   *
+   * @return the number of bytes of superblocks released by this call.
+   */
+  static std::size_t releaseFreeMemory();
+
+  /** @brief Number of bytes released to the operating system.
+   *
+   * @return the number of bytes of superblock memory currently released
+   * by releaseFreeMemory() and not yet reused.
+   */
+  static std::size_t releasedBytes();
+
+  /** @brief Set the hysteresis of releaseFreeMemory().
+   *
+   * @param min_idle_calls A superblock is released only once it has been
+   *          found empty by more than this many consecutive calls of
+   *          releaseFreeMemory().  Initially 2.
+   *
+   * @param retained_bytes Empty superblocks totalling up to this many
+   *          bytes are kept for reuse without being released.  Initially
+   *          16 MB.
+   */
+  static void setReleasePolicy(unsigned min_idle_calls,
+                               std::size_t retained_bytes);
+
 private:
   friend class AllocatorSuperblock;
   friend class AllocationTable;
@@ -160,6 +258,29 @@ private:
   static AllocatorSuperblock* s_superblocks[
       s_num_small_pools + s_num_medium_pools];
 
+  /** 2-log of the size of a transparent huge page (2 MB). */
+  static constexpr unsigned s_huge_page_log2 = 21;
+
+  /** Whether to use, and to pre-fault, transparent huge pages. */
+  static bool s_use_huge_pages;
+  static bool s_populate_huge_pages;
+
+  /**
+   * Map a region of 2^size_log2 bytes, aligned to and advised for huge
+   * pages.  Returns nullptr on failure.
+   */
+  static void* allocateHugePages(unsigned size_log2);
+
+  /** Allocate memory for a large allocation (outside superblocks). */
+  static void* allocateLargeBlock(unsigned size_log2);
+
+  /** Free memory obtained with allocateLargeBlock(). */
+  static void freeLargeBlock(void* pointer, unsigned size_log2);
+
+  /** Hysteresis parameters of releaseFreeMemory(). */
+  static unsigned s_release_min_idle_calls;
+  static std::size_t s_release_retained_bytes;
+
   /** Smallest known heap address. */
   static uintptr_t s_heap_start;
 
@@ -0,0 +1,214 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file HeapSizingPolicy.hpp
+ *
+ * @brief Class rho::HeapSizingPolicy and its implementations.
+ */
+
+#ifndef RHO_HEAPSIZINGPOLICY_HPP
+#define RHO_HEAPSIZINGPOLICY_HPP
+
+#include <cstddef>
+
+namespace rho {
+    /** @brief Policy determining when garbage collections occur.
+     *
+     * After every collection, GCManager passes the policy a summary
+     * of the collection, and the policy sets the levels of
+     * MemoryBank::bytesAllocated() at which the next lightweight
+     * (reference-count) collection and the next mark-sweep
+     * collection will be triggered.
+     *
+     * The policy in effect is selected with
+     * GCManager::setHeapSizingPolicy().
+     */
+    class HeapSizingPolicy {
+    public:
+	/** @brief Summary of a completed garbage collection.
+	 */
+	struct Collection {
+	    /** @brief true if a mark-sweep collection was carried
+	     * out (as well as a lightweight collection).
+	     */
+	    bool full;
+
+	    /** @brief Bytes allocated when the collection began.
+	     */
+	    std::size_t bytes_before;
+
+	    /** @brief Bytes allocated when the collection ended.
+	     */
+	    std::size_t bytes_after;
+
+	    /** @brief Duration of the collection in seconds.
+	     */
+	    double gc_seconds;
+
+	    /** @brief Seconds from the end of the previous collection
+	     * to the start of this one.
+	     */
+	    double mutator_seconds;
+	};
+
+	virtual ~HeapSizingPolicy() {}
+
+	/** @brief Set the collection thresholds.
+	 *
+	 * @param collection Summary of the collection just completed.
+	 *
+	 * @param min_threshold Neither threshold should be set lower
+	 *          than this.
+	 *
+	 * @param gclite_threshold Pointer to the threshold for
+	 *          lightweight collection, which the policy should
+	 *          update.
+	 *
+	 * @param threshold Pointer to the threshold for mark-sweep
+	 *          collection.  If \a collection was not a full
+	 *          collection, the policy may leave this unchanged.
+	 */
+	virtual void adjustThresholds(const Collection& collection,
+				      std::size_t min_threshold,
+				      std::size_t* gclite_threshold,
+				      std::size_t* threshold) = 0;
+
+	/** @brief Name of the policy.
+	 *
+	 * @return The name by which the policy is selected with
+	 * <tt>options(gc.policy)</tt>.
+	 */
+	virtual const char* name() const = 0;
+    };
+
+    /** @brief Heap sizing by a fixed growth factor.
+     *
+     * This is the default policy.  After each collection, the
+     * thresholds are set 20% above the number of bytes still
+     * allocated, but are never reduced by more than 20% in a
+     * single collection.
+     */
+    class GrowthHeapPolicy : public HeapSizingPolicy {
+    public:
+	void adjustThresholds(const Collection& collection,
+			      std::size_t min_threshold,
+			      std::size_t* gclite_threshold,
+			      std::size_t* threshold) override;
+
+	const char* name() const override
+	{
+	    return "growth";
+	}
+    };
+
+    /** @brief Heap sizing to bound the time spent in collection.
+     *
+     * The mark-sweep threshold is chosen so that, at the rate of
+     * heap growth observed since the previous mark-sweep
+     * collection, the time spent in mark-sweep collection is about
+     * a given fraction of the total run time.  Thus a program
+     * with a large live heap and a low allocation rate is
+     * collected rarely, and one with a small live heap is
+     * collected often.
+     *
+     * The lightweight threshold is chosen so that a lightweight
+     * collection, whose cost is proportional to the amount of
+     * garbage released, takes about the pause goal.  The
+     * duration of a mark-sweep collection is governed by the size
+     * of the live heap, so the pause goal does not bound it.
+     */
+    class PauseTimeHeapPolicy : public HeapSizingPolicy {
+    public:
+	/**
+	 * @param gc_fraction Target fraction of run time spent in
+	 *          mark-sweep collection; must be strictly between 0
+	 *          and 1.
+	 *
+	 * @param pause_goal Target duration in seconds of a
+	 *          lightweight collection.
+	 */
+	PauseTimeHeapPolicy(double gc_fraction, double pause_goal);
+
+	void adjustThresholds(const Collection& collection,
+			      std::size_t min_threshold,
+			      std::size_t* gclite_threshold,
+			      std::size_t* threshold) override;
+
+	const char* name() const override
+	{
+	    return "pause";
+	}
+    private:
+	double m_gc_fraction;
+	double m_pause_goal;
+	// Seconds of mutator time, and bytes allocated at the end
+	// of the most recent mark-sweep collection:
+	double m_mutator_seconds;
+	std::size_t m_bytes_after_full;
+	// Smoothed estimate of the seconds taken by a lightweight
+	// collection per byte released, or zero if not yet known:
+	double m_lite_seconds_per_byte;
+    };
+
+    /** @brief Heap sizing to respect a memory ceiling.
+     *
+     * The thresholds are set as by GrowthHeapPolicy, except that
+     * the headroom above the bytes still allocated is at most half
+     * the distance remaining to the ceiling.  Collections thus
+     * become more frequent as the ceiling is approached, and
+     * within 10% of the ceiling every lightweight trigger also
+     * carries out a mark-sweep collection.
+     */
+    class CeilingHeapPolicy : public HeapSizingPolicy {
+    public:
+	/**
+	 * @param ceiling Maximum number of bytes to be allocated via
+	 *          MemoryBank.  This is not enforced: it is a target.
+	 */
+	explicit CeilingHeapPolicy(std::size_t ceiling);
+
+	void adjustThresholds(const Collection& collection,
+			      std::size_t min_threshold,
+			      std::size_t* gclite_threshold,
+			      std::size_t* threshold) override;
+
+	const char* name() const override
+	{
+	    return "ceiling";
+	}
+
+	/** @brief Memory limit of the process's control group.
+	 *
+	 * @return The memory limit in bytes imposed on the process
+	 * by its Linux control group (version 2 or version 1), or
+	 * zero if there is no such limit or it cannot be
+	 * determined.
+	 */
+	static std::size_t controlGroupLimit();
+    private:
+	std::size_t m_ceiling;
+	GrowthHeapPolicy m_growth;
+    };
+}  // namespace rho
+
+#endif  // RHO_HEAPSIZINGPOLICY_HPP
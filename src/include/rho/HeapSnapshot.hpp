@@ -0,0 +1,172 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file HeapSnapshot.hpp
+ *
+ * @brief Class rho::HeapSnapshot.
+ */
+
+#ifndef RHO_HEAPSNAPSHOT_HPP
+#define RHO_HEAPSNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rho {
+    /** @brief Snapshot of the graph of GCNode objects.
+     *
+     * A snapshot records every GCNode allocated by GCNodeAllocator,
+     * with its type, the size of its allocator block and the nodes it
+     * refers to (as reported by GCNode::visitReferents()), together
+     * with the roots from which the mark phase of garbage collection
+     * starts.  The roots include the nodes found by the conservative
+     * scan of the C stack, which may include some that are no longer
+     * in use.  Nodes kept alive by WeakRef::markThru() are not
+     * treated as roots, since they are reachable only through weak
+     * references.  Environments are labelled with their names, and
+     * the values bound in environment frames with the names of their
+     * symbols.
+     *
+     * A snapshot is written to a file by write(), and can later be
+     * read back by read(), possibly in a different session, to find
+     * which nodes are keeping the most memory alive.  The retained
+     * size of a node is the total size of the nodes that it dominates,
+     * i.e. of the nodes that would become unreachable if it did;
+     * retainers() computes these from the dominator tree of the graph.
+     *
+     * The file format is binary, in the byte order of the machine
+     * writing it.  After an 8-byte signature come the numbers of
+     * nodes, edges, roots and labels (as 64-bit integers), then the
+     * node types (one byte each), node sizes (64-bit), the offsets of
+     * each node's edges in the edge array (64-bit, one more than the
+     * number of nodes), the edges and the roots (32-bit node indices),
+     * and lastly the labels, each as a 32-bit node index, a 32-bit
+     * length and the characters of the label.
+     */
+    class HeapSnapshot {
+    public:
+	/** @brief Type code recorded for GCNodes that are not
+	 * RObjects.
+	 */
+	static const unsigned char s_internal_type = 0xff;
+
+	/** @brief Node retaining a large amount of memory.
+	 */
+	struct Retainer {
+	    /** @brief Index of the node within the snapshot.
+	     */
+	    std::uint32_t node;
+
+	    /** @brief SEXPTYPE of the node, or s_internal_type.
+	     */
+	    unsigned char type;
+
+	    /** @brief Size in bytes of the node's own allocator block.
+	     */
+	    std::uint64_t size;
+
+	    /** @brief Total size in bytes of the nodes the node
+	     * dominates, including itself.
+	     */
+	    std::uint64_t retained;
+
+	    /** @brief Labels on the path of dominators from the roots
+	     * to the node, separated by <tt>$</tt>.
+	     */
+	    std::string path;
+	};
+
+	/** @brief Record the current state of the heap.
+	 *
+	 * Garbage collection is inhibited while the snapshot is taken.
+	 * It is advisable to carry out a mark-sweep collection first,
+	 * so that the snapshot is not cluttered with garbage.
+	 */
+	HeapSnapshot();
+
+	/** @brief Read a snapshot from a file.
+	 *
+	 * @param path Name of a file written by write().
+	 *
+	 * @return The snapshot.  An error is raised if the file cannot
+	 * be read or is not a heap snapshot.
+	 */
+	static HeapSnapshot read(const char* path);
+
+	/** @brief Nodes retaining the most memory.
+	 *
+	 * @param max_count Maximum number of nodes to report.
+	 *
+	 * @return The nodes with the largest retained sizes, largest
+	 * first.  Nodes not reachable from the roots are ignored.
+	 */
+	std::vector<Retainer> retainers(std::size_t max_count) const;
+
+	/** @brief Number of nodes in the snapshot.
+	 */
+	std::size_t numNodes() const
+	{
+	    return m_types.size();
+	}
+
+	/** @brief Number of references between nodes in the snapshot.
+	 */
+	std::size_t numEdges() const
+	{
+	    return m_edges.size();
+	}
+
+	/** @brief Total size in bytes of the nodes in the snapshot.
+	 */
+	std::uint64_t totalSize() const;
+
+	/** @brief Write the snapshot to a file.
+	 *
+	 * @param path Name of the file, which is overwritten.  An
+	 *          error is raised if it cannot be written.
+	 */
+	void write(const char* path) const;
+    private:
+	std::vector<unsigned char> m_types;
+	std::vector<std::uint64_t> m_sizes;
+	std::vector<std::uint64_t> m_edge_offsets;
+	std::vector<std::uint32_t> m_edges;
+	std::vector<std::uint32_t> m_roots;
+	std::vector<std::pair<std::uint32_t, std::string> > m_labels;
+
+	struct Empty {};
+	explicit HeapSnapshot(Empty)
+	{}
+
+	// Immediate dominator of each node, with the roots dominated by
+	// a virtual node numNodes(), and unreachable nodes set to
+	// uint32_t(-1).  *order is set to the reachable nodes in
+	// reverse postorder.
+	void dominators(std::vector<std::uint32_t>* idom,
+			std::vector<std::uint32_t>* order) const;
+    };
+}  // namespace rho
+
+#endif  // RHO_HEAPSNAPSHOT_HPP
@@ -114,31 +114,26 @@ namespace rho {
     }  // namespace ElementTraits
 
     // Inline definitions of operators.
+    // The operators are computed without branches, so that loops
+    // applying them elementwise, as & | and ! do, can be vectorised.
+
     inline Logical Logical::operator!() const {
-	if (isNA()) {
-	    return NA();
-	}
-	return Logical(1 - m_value);
+	unsigned int na = isNA(), v = 1u - unsigned(m_value);
+	return Logical(int(v ^ (na * (v ^ unsigned(NA_LOGICAL)))));
     }
 
     inline Logical Logical::operator||(Logical other) const {
-	if (isTrue() || other.isTrue()) {
-	    return true;
-	}
-	if (isNA() || other.isNA()) {
-	    return NA();
-	}
-	return false;
+	unsigned int one = isTrue() | other.isTrue();
+	unsigned int na = isNA() | other.isNA();
+	unsigned int v = na * unsigned(NA_LOGICAL);
+	return Logical(int(v ^ (one * (v ^ 1u))));
     }
 
     inline Logical Logical::operator&&(Logical other) const {
-	if (isFalse() || other.isFalse()) {
-	    return false;
-	}
-	if (isNA() || other.isNA()) {
-	    return NA();
-	}
-	return true;
+	unsigned int zero = isFalse() | other.isFalse();
+	unsigned int na = isNA() | other.isNA();
+	unsigned int v = 1u ^ (na * (1u ^ unsigned(NA_LOGICAL)));
+	return Logical(int(v & (zero - 1u)));
     }
 
 }  // namespace rho
@@ -53,6 +53,26 @@ namespace rho {
 	int value_as_int = static_cast<int>(Logical(value));
 	return static_cast<LogicalVector*>(Rf_ScalarLogical(value_as_int));
     }
+
+    /** @brief Count TRUE and NA elements of a logical array.
+     *
+     * The array is scanned without data-dependent branches, so that
+     * the loop can be vectorised by the compiler.  This is intended
+     * for code (such as which() and logical subscripting) that sizes
+     * its result before filling it in.
+     *
+     * @param begin Pointer to the first element of the array.
+     *
+     * @param end Pointer to one past the last element of the array.
+     *
+     * @param ntrue Non-null pointer to a location in which the number
+     *          of TRUE elements is stored.
+     *
+     * @param nna Non-null pointer to a location in which the number
+     *          of NA elements is stored.
+     */
+    void countLogicals(const Logical* begin, const Logical* end,
+		       std::size_t* ntrue, std::size_t* nna);
 }  // namespace rho
 
 extern "C" {
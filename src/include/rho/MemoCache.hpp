@@ -0,0 +1,157 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file MemoCache.hpp
+ *
+ * @brief Class rho::MemoCache.
+ */
+
+#ifndef RHO_MEMOCACHE_HPP
+#define RHO_MEMOCACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rho {
+    class RObject;
+
+    /** @brief Cache of the results of function calls.
+     *
+     * A MemoCache maps keys, normally the hexadecimal form of a
+     * ContentHash::Digest of a function and its arguments, to the
+     * values the calls returned.  Values are held in memory up to a
+     * budget of (approximately estimated) bytes, beyond which the
+     * least recently used are discarded.
+     *
+     * The values held in memory are not GC roots: they are kept in
+     * a list referenced by the protected field of the external
+     * pointer that owns the MemoCache, so that a value referring
+     * back to that external pointer does not keep the cache alive.
+     *
+     * If the cache has a directory, each value stored is also
+     * written there, serialized in a file named after its key, so
+     * that values discarded from memory, or stored by an earlier
+     * session, can be read back rather than recomputed.
+     */
+    class MemoCache {
+    public:
+	/** @brief Constructor.
+	 *
+	 * @param budget Number of bytes of values to hold in memory.
+	 *
+	 * @param directory Directory in which to keep values, or the
+	 *          empty string to keep values only in memory.
+	 *
+	 * @param owner Non-null pointer to the external pointer whose
+	 *          address is to be this MemoCache, and whose
+	 *          protected field the MemoCache will use to hold its
+	 *          values.
+	 */
+	MemoCache(std::size_t budget, const std::string& directory,
+		  RObject* owner);
+
+	/** @brief Remove all values from memory.
+	 *
+	 * Files in the directory, if any, are retained.
+	 */
+	void clear();
+
+	/** @brief Look up a value.
+	 *
+	 * @param key The key under which the value was stored.
+	 *
+	 * @param found Set to true if the value was found, and
+	 *          otherwise false.
+	 *
+	 * @return The value, or a null pointer if it was not found.
+	 */
+	RObject* lookup(const std::string& key, bool* found);
+
+	/** @brief Store a value.
+	 *
+	 * @param key The key under which to store the value.
+	 *
+	 * @param value The value, which may be a null pointer.  It
+	 *          should not subsequently be modified.
+	 */
+	void store(const std::string& key, RObject* value);
+
+	std::size_t budget() const {return m_budget;}
+	std::size_t bytes() const {return m_bytes;}
+	const std::string& directory() const {return m_directory;}
+	std::size_t diskHits() const {return m_disk_hits;}
+	std::size_t hits() const {return m_hits;}
+	std::size_t misses() const {return m_misses;}
+	std::size_t size() const {return m_entries.size();}
+
+	/** @brief Approximate memory occupied by an object.
+	 *
+	 * @param object Pointer, possibly null, to an object.
+	 *
+	 * @return Bytes occupied by the data of \a object and the
+	 * objects it contains, not counting environments.
+	 */
+	static std::size_t objectBytes(const RObject* object);
+    private:
+	struct Entry {
+	    std::string key;
+	    std::size_t slot;  // Index of the value in values().
+	    std::size_t bytes;
+	};
+	typedef std::list<Entry> EntryList;
+
+	std::size_t m_budget;
+	std::string m_directory;
+	RObject* m_owner;
+	std::vector<std::size_t> m_free_slots;
+	std::size_t m_next_slot;  // Slots from here on are unused.
+	EntryList m_entries;  // Most recently used first.
+	std::unordered_map<std::string, EntryList::iterator> m_index;
+	std::size_t m_bytes;
+	std::size_t m_hits;
+	std::size_t m_disk_hits;
+	std::size_t m_misses;
+
+	// Hold a value in memory, discarding others as necessary to
+	// keep within the budget.
+	void hold(const std::string& key, RObject* value);
+
+	// The list holding the values of m_entries:
+	RObject* values() const;
+
+	// Place value in an unused slot of values(), and return the
+	// index of the slot:
+	std::size_t newSlot(RObject* value);
+
+	void discard(EntryList::iterator it);
+
+	std::string path(const std::string& key) const;
+	RObject* readFile(const std::string& key, bool* found) const;
+	void writeFile(const std::string& key, RObject* value) const;
+    };
+}  // namespace rho
+
+#endif  // RHO_MEMOCACHE_HPP
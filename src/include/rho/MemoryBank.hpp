@@ -144,13 +144,17 @@ namespace rho {
 #endif
 
 	friend class GCNode;
-	static void notifyAllocation(size_t bytes);
+	static void notifyAllocation(size_t bytes, size_t count = 1);
 
 	static void notifyDeallocation(size_t bytes);
 
 	friend class String;
 	template<typename, SEXPTYPE>
 	friend class FixedVector;
+	template<typename, SEXPTYPE>
+	friend class FileBackedVector;
+	template<typename, SEXPTYPE>
+	friend class AdoptedVector;
 
         /** @brief Adjust the freed block statistics.
          *
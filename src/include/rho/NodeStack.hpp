@@ -30,7 +30,7 @@
 #ifndef NODESTACK_H
 #define NODESTACK_H 1
 
-#include <vector>
+#include <cstddef>
 #include "rho/GCNode.hpp"
 #include "rho/RObject.hpp"
 
@@ -45,6 +45,17 @@ namespace rho {
      * Note that it is necessary for GCNode::gclite() to call the
      * protectAll() method of every NodeStack in existence before it
      * starts to delete nodes with zero references counts.
+     *
+     * The entries are held in a contiguous array described by an
+     * R_StackRegion.  Pushing an entry does not alter its reference
+     * count: protectAll() increments the reference counts of all
+     * the entries pushed since it was last called, and only
+     * entries thus protected need their reference counts
+     * decremented when they are popped.  Consequently entries
+     * pushed and popped between garbage collections, which are the
+     * vast majority, cost no more than a store and a pointer
+     * adjustment.  The R_StackRegion is laid out so that C code can
+     * do this directly: see region().
      */
     class NodeStack {
     public:
@@ -95,7 +106,7 @@ namespace rho {
 	     */
 	    operator RObject* const() const
 	    {
-		return m_stack->m_vector[m_index];
+		return m_stack->m_region.base[m_index];
 	    }
 	private:
 	    friend class NodeStack;
@@ -131,6 +142,9 @@ namespace rho {
 		  m_saved_size(m_nodestack->size())
 	    {
 		stack->m_innermost_scope = this;
+#ifndef NDEBUG
+		stack->setFloor();
+#endif
 	    }
 
 	    ~Scope()
@@ -141,6 +155,9 @@ namespace rho {
 #endif
 		m_nodestack->resize(m_saved_size);
 		m_nodestack->m_innermost_scope = m_next_scope;
+#ifndef NDEBUG
+		m_nodestack->setFloor();
+#endif
 	    }
 	private:
 	    friend class NodeStack;
@@ -172,10 +189,7 @@ namespace rho {
 	 */
 	NodeStack(size_t initial_capacity);
 
-	~NodeStack()
-	{
-	    resize(0);
-	}
+	~NodeStack();
 
 	/** @brief Element access.
 	 *
@@ -201,7 +215,7 @@ namespace rho {
 	 */
 	const RObject* operator[](size_t index) const
 	{
-	    return m_vector[index];
+	    return m_region.base[index];
 	}
 
 	/** @brief Remove topmost cell with given contents.
@@ -261,7 +275,9 @@ namespace rho {
 #else
 	void pop(unsigned int count = 1)
 	{
-	    resize(size() - count);
+	    if (m_region.top - m_region.floor >= std::ptrdiff_t(count))
+		m_region.top -= count;
+	    else resize_aux(size() - count);
 	}
 #endif
 
@@ -282,8 +298,10 @@ namespace rho {
 	 */
 	size_t push(RObject* node)
 	{
-	    size_t index = m_vector.size();
-	    m_vector.push_back(node);
+	    if (m_region.top == m_region.limit)
+		grow(size() + 1);
+	    size_t index = size();
+	    *m_region.top++ = node;
 	    return index;
 	}
 
@@ -310,8 +328,8 @@ namespace rho {
 	void retarget(RObject* node, size_t index)
 	{
 	    if (index < m_protected_count)
-		retarget_aux(m_vector[index], node);
-	    m_vector[index] = node;
+		retarget_aux(m_region.base[index], node);
+	    m_region.base[index] = node;
 	}
 #endif
 
@@ -325,18 +343,33 @@ namespace rho {
 	 */
 	void resize(size_t new_size)
 	{
-	    if (new_size >= m_protected_count)
-		m_vector.resize(new_size, nullptr);
+	    if (new_size <= size() && m_region.base + new_size >= m_region.floor)
+		m_region.top = m_region.base + new_size;
 	    else resize_aux(new_size);
 	}
 
+	/** @brief Storage of the NodeStack.
+	 *
+	 * @return Pointer to the R_StackRegion describing the
+	 * storage of the NodeStack.  The pointer remains valid for
+	 * the lifetime of the NodeStack, though the storage it
+	 * describes moves as the NodeStack grows.  Code using the
+	 * R_StackRegion directly must observe the rules set out in
+	 * Rinternals.h, and must call the member functions of the
+	 * NodeStack for anything else.
+	 */
+	R_StackRegion* region()
+	{
+	    return &m_region;
+	}
+
 	/** @brief Current size of NodeStack.
 	 *
 	 * @return the number of pointers currently on the NodeStack.
 	 */
 	size_t size() const
 	{
-	    return m_vector.size();
+	    return size_t(m_region.top - m_region.base);
 	}
 
 	/** @brief pop and return the top element of the stack.
@@ -361,22 +394,33 @@ namespace rho {
 	 */
 	void visitRoots(GCNode::const_visitor* v);
     private:
-	std::vector<RObject*> m_vector;
+	R_StackRegion m_region;
 	size_t m_protected_count;  // The nodes (if any) pointed to
-	  // (*m_vector)[0] through (*m_vector)[m_protected_count - 1]
+	  // m_region.base[0] through m_region.base[m_protected_count - 1]
 	  // will have had their reference counts increased by this
 	  // class.  Stack entries beyond this (if any) will not yet
 	  // have had this protection applied.
  
 	Scope* m_innermost_scope;
 
+	NodeStack(const NodeStack&) = delete;
+	NodeStack& operator=(const NodeStack&) = delete;
+
+	// Enlarge the storage to hold at least min_capacity entries:
+	void grow(size_t min_capacity);
+
+	// Set m_region.floor from m_protected_count and, unless NDEBUG
+	// is defined, the start of the innermost Scope, so that pops
+	// that need checking or unprotection are not done inline:
+	void setFloor();
+
 	// Helper function for retarget(), handling the case where
 	// 'index' is within the protected range:
 	static void retarget_aux(RObject* oldnode, RObject* newnode)
 	    HOT_FUNCTION;
 
-	// Helper function for trim(), handling the case where the trim
-	// cuts down into protected nodes:
+	// Helper function for resize(), handling the cases where the
+	// stack grows or is cut down into protected nodes:
 	void resize_aux(size_t new_size) HOT_FUNCTION;
     };
 }  // namespace rho
@@ -43,6 +43,13 @@ namespace rho {
     /** @brief Class implementing CR's 'pointer protection stack'.
      *
      * All members of this class are static.
+     *
+     * The storage of the stack is exported to C code as
+     * R_PPStackRegion, so that the PROTECT family of macros in
+     * Rinternals.h can push and pop entries inline, calling the
+     * functions of the C interface below only when the stack needs
+     * to grow or the entries concerned have been protected by a
+     * garbage collection.
      */
     class ProtectStack {
     public:
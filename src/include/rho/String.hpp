@@ -36,6 +36,7 @@
 #include "rho/GCRoot.hpp"
 #include "rho/SEXP_downcast.hpp"
 #include "rho/VectorBase.hpp"
+#include <cstring>
 #include <string>
 #include <unordered_map>
 
@@ -204,6 +205,53 @@ namespace rho {
 	 * representing the specified text in the specified encoding.
 	 */
 	static String* obtain(const std::string& str,
+			      cetype_t encoding = CE_NATIVE)
+	{
+	    return obtain(str.data(), str.size(), encoding);
+	}
+
+	/** @brief Get a pointer to a String object from a
+	 * null-terminated C string.
+	 *
+	 * Behaves exactly as obtain(const std::string&, cetype_t).
+	 *
+	 * @param str The null-terminated text of the required
+	 *          String.
+	 *
+	 * @param encoding The encoding of the required String, as
+	 *          for obtain(const std::string&, cetype_t).
+	 *
+	 * @return Pointer to a String (preexisting or newly created)
+	 * representing the specified text in the specified encoding.
+	 */
+	static String* obtain(const char* str,
+			      cetype_t encoding = CE_NATIVE)
+	{
+	    return obtain(str, strlen(str), encoding);
+	}
+
+	/** @brief Get a pointer to a String object from a character
+	 * slice.
+	 *
+	 * Behaves exactly as obtain(const std::string&, cetype_t),
+	 * but takes the text as a pointer and length, so that callers
+	 * building many strings in a single buffer (e.g. paste()) can
+	 * create each String straight from its slice of the buffer,
+	 * without an intermediate std::string.
+	 *
+	 * @param text Pointer to the first character of the required
+	 *          String.  Need not be null-terminated, and may
+	 *          contain embedded null characters.
+	 *
+	 * @param length Number of characters in the String.
+	 *
+	 * @param encoding The encoding of the required String, as
+	 *          for obtain(const std::string&, cetype_t).
+	 *
+	 * @return Pointer to a String (preexisting or newly created)
+	 * representing the specified text in the specified encoding.
+	 */
+	static String* obtain(const char* text, std::size_t length,
 			      cetype_t encoding = CE_NATIVE);
 
 	/** @brief The name by which this type is known in R.
@@ -280,10 +328,10 @@ namespace rho {
 	bool m_ascii;
 
         // Should only be called by String::create().
-        String(char* character_storage,
-               const std::string& text, cetype_t encoding, bool isAscii);
-        static String* create(const std::string& text, cetype_t encoding,
-                              bool isAscii);
+        String(char* character_storage, const char* text,
+               std::size_t length, cetype_t encoding, bool isAscii);
+        static String* create(const char* text, std::size_t length,
+                              cetype_t encoding, bool isAscii);
         static String* createNA();
 
 	String(const String&) = delete;
@@ -308,6 +356,17 @@ namespace rho {
      */
     bool isASCII(const std::string& str);
 
+    /** @brief Is a character slice entirely ASCII?
+     *
+     * @param text Pointer to the first character to be examined.
+     *
+     * @param length Number of characters to examine.
+     *
+     * @return false if the slice contains at least one non-ASCII
+     * character, otherwise true.
+     */
+    bool isASCII(const char* text, std::size_t length);
+
 
     // Designed for use with std::accumulate():
     unsigned int stringWidth(unsigned int minwidth, const String* string);
@@ -38,6 +38,8 @@
 #ifdef __cplusplus
 
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include "rho/FixedVector.hpp"
 #include "rho/SEXP_downcast.hpp"
@@ -71,6 +73,104 @@ namespace rho {
 	return StringVector::createScalar(cs);
     }
 
+    /** @brief Dictionary encoding of the Strings in a StringVector.
+     *
+     * A StringDictionary assigns consecutive integer codes, starting
+     * from zero, to the distinct Strings presented to it.  Since at
+     * most one String exists with a given text and encoding, Strings
+     * are identified by address, without looking at their text.
+     * For long vectors with few distinct values this lets operations
+     * such as duplicated() and sort() work on the codes and a small
+     * dictionary, rather than on a hash table or a comparison sort
+     * over the whole vector.  The encoding is built afresh by each
+     * such operation: StringVector itself does not store codes.
+     *
+     * The dictionary does not protect the Strings it records from
+     * garbage collection: they must be kept alive by other means,
+     * typically by the vector being encoded.
+     */
+    class StringDictionary {
+    public:
+	/** @brief Default maximum size.
+	 *
+	 * Vectors with more distinct values than this are not worth
+	 * dictionary encoding.
+	 */
+	static const std::size_t maxSize = 65536;
+
+	/** @brief Minimum vector length.
+	 *
+	 * Shorter vectors, such as the results of ls() or names(),
+	 * are left to the ordinary code paths.
+	 */
+	static const std::size_t minLength = 16384;
+
+	/**
+	 * @param max_size Maximum number of distinct Strings the
+	 *          dictionary will accept.  Callers use this to give
+	 *          up on dictionary encoding for vectors with many
+	 *          distinct values.
+	 */
+	explicit StringDictionary(std::size_t max_size = maxSize)
+	    : m_max_size(max_size)
+	{}
+
+	/** @brief Might a vector have few distinct Strings?
+	 *
+	 * Counts the distinct Strings in a sample of a few thousand
+	 * elements spread evenly through a vector.  Vectors shorter
+	 * than minLength are never considered.
+	 *
+	 * @param sv Non-null pointer to the vector.
+	 *
+	 * @param max_size Maximum number of distinct Strings of
+	 *          interest.
+	 *
+	 * @return false if \a sv is shorter than minLength, or if the
+	 * sample makes it likely that \a sv has more than \a max_size
+	 * distinct Strings, so that callers need not encode up to
+	 * \a max_size elements before giving up.  Otherwise true.
+	 */
+	static bool mayHaveFewValues(const StringVector* sv,
+				     std::size_t max_size = maxSize);
+
+	/** @brief Code for a String.
+	 *
+	 * @param str Non-null pointer to the String to be encoded.
+	 *
+	 * @param is_new Non-null pointer to a location in which is
+	 *          stored true if \a str was not previously in the
+	 *          dictionary, otherwise false.
+	 *
+	 * @return The code of \a str, adding it to the dictionary if
+	 * necessary; or -1 if \a str is new and the dictionary
+	 * already holds \a max_size Strings.
+	 */
+	int encode(const String* str, bool* is_new);
+
+	/** @brief String with a given code.
+	 *
+	 * @param code A code previously returned by encode().
+	 *
+	 * @return The String with code \a code.
+	 */
+	const String* operator[](std::size_t code) const
+	{
+	    return m_entries[code];
+	}
+
+	/** @brief Number of distinct Strings in the dictionary.
+	 */
+	std::size_t size() const
+	{
+	    return m_entries.size();
+	}
+    private:
+	std::unordered_map<const String*, int> m_codes;
+	std::vector<const String*> m_entries;
+	std::size_t m_max_size;
+    };
+
     /** @brief (For debugging.)
      *
      * @note The name and interface of this function may well change.
@@ -31,6 +31,7 @@
 #ifndef WEAKREF_HPP
 #define WEAKREF_HPP
 
+#include <cstddef>
 #include <list>
 #include "rho/Allocator.hpp"
 #include "rho/FunctionBase.hpp"
@@ -148,18 +149,38 @@ namespace rho {
 
 	/** @brief Run finalizers.
 	 *
-	 * This is called by GCManager::gc() immediately after garbage
-	 * collection, and runs the finalizers of any weak references that
-	 * were identified during the garbage collection as being
-	 * ready to finalize; when the call exits, all such weak
-	 * references will have been tombstoned.  (Consequently,
-	 * calling this method at any other time will effectively be a
-	 * no-op.)
+	 * Weak references whose keys are found during garbage
+	 * collection to be unreachable are queued for finalization.
+	 * This method runs the finalizers of queued weak references,
+	 * oldest first, tombstoning each one.  It should be called only
+	 * at points where it is safe to run arbitrary R code: it is
+	 * called after an explicit garbage collection, and whenever
+	 * R_CheckUserInterrupt() is called.
+	 *
+	 * @param max_count The maximum number of finalizers to run.
+	 *          Any further queued finalizers are left for a
+	 *          subsequent call, so that a collection that frees
+	 *          very many finalizable objects does not cause a
+	 *          single long pause.
 	 *
 	 * @return true iff any finalizers are actually run (whether
 	 * successfully or not).
 	 */
-	static bool runFinalizers();
+	static bool runFinalizers(std::size_t max_count = std::size_t(-1));
+
+	/** @brief Number of finalizers run at each safe point.
+	 *
+	 * The value of \a max_count used by R_CheckUserInterrupt()
+	 * when calling runFinalizers().
+	 */
+	static const std::size_t finalizerBatchSize = 1000;
+
+	/** @brief Number of weak references awaiting finalization.
+	 */
+	static std::size_t numFinalizationsPending()
+	{
+	    return getFinalizationPending()->size();
+	}
 
 	/**
 	 * @return Pointer to the value of the WeakRef.
@@ -174,6 +195,8 @@ namespace rho {
 	void detachReferents() override;
     private:
 	typedef std::list<WeakRef*, Allocator<WeakRef*> > WRList;
+	class EphemeronMarker;
+
 	static WRList* getLive();
 	static WRList* getFinalizationPending();
 	static WRList* getTombstone();
@@ -202,6 +225,13 @@ namespace rho {
 	 * the WeakRef is placed on a finalization pending list.  If
 	 * the key is not marked and there is no finalizer, the
 	 * WeakRef is tombstoned.
+	 *
+	 * Rather than iterating over the live list to a fixed point,
+	 * WeakRefs with unmarked keys are indexed by key, and an
+	 * EphemeronMarker looks up each node it marks in that index,
+	 * moving any WeakRefs keyed on it to a work list.  Each WeakRef
+	 * is thus processed once, so the time taken is proportional to
+	 * the number of live WeakRefs plus the number of nodes marked.
 	 */
 	static void markThru();
 
@@ -93,6 +93,328 @@ static void cbm_Size(double *left, double *right,
 # include "bitmap.h"
 #endif
 
+#ifndef Win32
+/* ------------- threaded rendering --------------- */
+
+/* With options(bitmap.threads = n) for n > 1 when an image-surface
+   device is opened, the lines, rectangles, circles, polygons and
+   paths drawn on it are queued instead of being drawn at once.  The
+   queue is replayed when text or a raster image is to be drawn, when
+   the page is finished, or when it becomes long, by splitting the
+   surface into horizontal bands and drawing all the queued
+   operations on each band in a thread of its own.  The bands are
+   drawn by the same Cairo_* functions as the serial path, with the
+   cairo context translated to the band, so every pixel receives the
+   same operations in the same order.  Cairo itself may be used from
+   several threads provided that each uses its own context and
+   surface. */
+
+#include <pthread.h>
+
+typedef enum {
+    CBM_CLIP,
+    CBM_RECT,
+    CBM_CIRCLE,
+    CBM_LINE,
+    CBM_POLYLINE,
+    CBM_POLYGON,
+    CBM_PATH
+} CBMopType;
+
+typedef struct {
+    CBMopType type;
+    R_GE_gcontext gc;
+    double a[4];	/* clip, rect and line coordinates; circle x, y, r */
+    int n;		/* number of vertices */
+    double *xy;		/* x coordinates followed by y coordinates */
+    int npoly;		/* for paths */
+    int *nper;
+    Rboolean winding;
+} CBMop;
+
+typedef struct CBMqueue {
+    int nthreads;
+    CBMop *ops;
+    int nops, maxops;
+    size_t work;		/* roughly, number of vertices queued */
+    /* Clipping region at the start of the queue and after its end */
+    Rboolean startclipped, clipped;
+    double startclip[4], clip[4];
+} CBMqueue;
+
+typedef struct {
+    X11Desc xd;			/* copy of the device's, drawing on the band */
+    DevDesc dev;
+    CBMqueue *queue;
+} CBMband;
+
+/* Queues shorter than this are drawn serially on the device's own
+   context, since starting threads would take longer. */
+#define CBM_PARALLEL_WORK 2000
+/* Queues are replayed when they reach this many operations. */
+#define CBM_MAX_OPS 8192
+/* Bands are at least this many rows high. */
+#define CBM_MIN_ROWS 16
+
+static void CBM_Replay(CBMqueue *q, pDevDesc dd)
+{
+    for (int i = 0; i < q->nops; i++) {
+	CBMop *op = q->ops + i;
+	double *x = op->xy, *y = op->xy + op->n;
+	switch(op->type) {
+	case CBM_CLIP:
+	    Cairo_Clip(op->a[0], op->a[1], op->a[2], op->a[3], dd);
+	    break;
+	case CBM_RECT:
+	    Cairo_Rect(op->a[0], op->a[1], op->a[2], op->a[3], &op->gc, dd);
+	    break;
+	case CBM_CIRCLE:
+	    Cairo_Circle(op->a[0], op->a[1], op->a[2], &op->gc, dd);
+	    break;
+	case CBM_LINE:
+	    Cairo_Line(op->a[0], op->a[1], op->a[2], op->a[3], &op->gc, dd);
+	    break;
+	case CBM_POLYLINE:
+	    Cairo_Polyline(op->n, x, y, &op->gc, dd);
+	    break;
+	case CBM_POLYGON:
+	    Cairo_Polygon(op->n, x, y, &op->gc, dd);
+	    break;
+	case CBM_PATH:
+	    Cairo_Path(x, y, op->npoly, op->nper, op->winding, &op->gc, dd);
+	    break;
+	}
+    }
+}
+
+static void *CBM_ReplayBand(void *arg)
+{
+    CBMband *band = (CBMband *) arg;
+    CBM_Replay(band->queue, &band->dev);
+    return NULL;
+}
+
+static void CBM_Clear(CBMqueue *q)
+{
+    for (int i = 0; i < q->nops; i++) {
+	free(q->ops[i].xy);
+	free(q->ops[i].nper);
+    }
+    q->nops = 0;
+    q->work = 0;
+    q->startclipped = q->clipped;
+    memcpy(q->startclip, q->clip, sizeof(q->clip));
+}
+
+/* Draw everything queued for the device. */
+static void CBM_Flush(pDevDesc dd)
+{
+    pX11Desc xd = (pX11Desc) dd->deviceSpecific;
+    CBMqueue *q = xd->queue;
+    int nbands, height = xd->windowHeight;
+
+    if (!q || q->nops == 0) return;
+    nbands = height / CBM_MIN_ROWS;
+    if (nbands > q->nthreads) nbands = q->nthreads;
+    if (q->work < CBM_PARALLEL_WORK || nbands < 2) {
+	/* The device's context is in the state at the start of the queue */
+	CBM_Replay(q, dd);
+	CBM_Clear(q);
+	return;
+    }
+
+    CBMband *bands = (CBMband *) calloc(nbands, sizeof(CBMband));
+    pthread_t *threads = (pthread_t *) calloc(nbands, sizeof(pthread_t));
+    Rboolean *started = (Rboolean *) calloc(nbands, sizeof(Rboolean));
+    if (!bands || !threads || !started) {
+	free(bands); free(threads); free(started);
+	CBM_Replay(q, dd);
+	CBM_Clear(q);
+	return;
+    }
+    cairo_surface_flush(xd->cs);
+    unsigned char *data = cairo_image_surface_get_data(xd->cs);
+    int stride = cairo_image_surface_get_stride(xd->cs);
+    cairo_fill_rule_t rule = cairo_get_fill_rule(xd->cc);
+    for (int i = 0; i < nbands; i++) {
+	CBMband *band = bands + i;
+	int y0 = (int) ((double) height * i / nbands),
+	    y1 = (int) ((double) height * (i + 1) / nbands);
+	band->xd = *xd;
+	band->xd.cs =
+	    cairo_image_surface_create_for_data(data + (size_t) y0 * stride,
+						CAIRO_FORMAT_ARGB32,
+						xd->windowWidth, y1 - y0,
+						stride);
+	band->xd.cc = cairo_create(band->xd.cs);
+	band->dev = *dd;
+	band->dev.deviceSpecific = &band->xd;
+	band->queue = q;
+	cairo_translate(band->xd.cc, 0, -y0);
+	cairo_set_operator(band->xd.cc, CAIRO_OPERATOR_OVER);
+	cairo_set_antialias(band->xd.cc, xd->antialias);
+	cairo_set_fill_rule(band->xd.cc, rule);
+	if (q->startclipped)
+	    Cairo_Clip(q->startclip[0], q->startclip[1],
+		       q->startclip[2], q->startclip[3], &band->dev);
+    }
+    /* The first band is drawn by this thread, and so is any band
+       for which a thread cannot be started. */
+    for (int i = 1; i < nbands; i++)
+	started[i] = pthread_create(threads + i, NULL, CBM_ReplayBand,
+				    bands + i) == 0;
+    CBM_ReplayBand(bands);
+    for (int i = 1; i < nbands; i++) {
+	if (started[i]) pthread_join(threads[i], NULL);
+	else CBM_ReplayBand(bands + i);
+    }
+
+    /* Leave the device's context as it would be after the
+       operations, for what is drawn without queueing. */
+    cairo_set_fill_rule(xd->cc, cairo_get_fill_rule(bands[0].xd.cc));
+    if (q->clipped)
+	Cairo_Clip(q->clip[0], q->clip[1], q->clip[2], q->clip[3], dd);
+    else
+	cairo_reset_clip(xd->cc);
+    for (int i = 0; i < nbands; i++) {
+	cairo_destroy(bands[i].xd.cc);
+	cairo_surface_destroy(bands[i].xd.cs);
+    }
+    cairo_surface_mark_dirty(xd->cs);
+    free(bands); free(threads); free(started);
+    CBM_Clear(q);
+}
+
+static CBMop *CBM_Add(CBMopType type, int n, const pGEcontext gc,
+		      pDevDesc dd)
+{
+    pX11Desc xd = (pX11Desc) dd->deviceSpecific;
+    CBMqueue *q = xd->queue;
+    CBMop *op;
+
+    if (q->nops == CBM_MAX_OPS) CBM_Flush(dd);
+    if (q->nops == q->maxops) {
+	int newmax = q->maxops ? 2 * q->maxops : 64;
+	CBMop *ops = (CBMop *) realloc(q->ops, newmax * sizeof(CBMop));
+	if (!ops) error(_("out of memory while queueing graphics"));
+	q->ops = ops;
+	q->maxops = newmax;
+    }
+    op = q->ops + q->nops;
+    memset(op, 0, sizeof(CBMop));
+    op->type = type;
+    if (gc) op->gc = *gc;
+    if (n > 0) {
+	op->xy = (double *) malloc(2 * (size_t) n * sizeof(double));
+	if (!op->xy) error(_("out of memory while queueing graphics"));
+	op->n = n;
+    }
+    q->nops++;
+    q->work += 1 + n;
+    return op;
+}
+
+static void CBM_Clip(double x0, double x1, double y0, double y1,
+		     pDevDesc dd)
+{
+    pX11Desc xd = (pX11Desc) dd->deviceSpecific;
+    CBMop *op = CBM_Add(CBM_CLIP, 0, NULL, dd);
+    op->a[0] = x0; op->a[1] = x1; op->a[2] = y0; op->a[3] = y1;
+    xd->queue->clipped = TRUE;
+    memcpy(xd->queue->clip, op->a, sizeof(op->a));
+}
+
+static void CBM_Rect(double x0, double y0, double x1, double y1,
+		     const pGEcontext gc, pDevDesc dd)
+{
+    CBMop *op = CBM_Add(CBM_RECT, 0, gc, dd);
+    op->a[0] = x0; op->a[1] = y0; op->a[2] = x1; op->a[3] = y1;
+}
+
+static void CBM_Circle(double x, double y, double r,
+		       const pGEcontext gc, pDevDesc dd)
+{
+    CBMop *op = CBM_Add(CBM_CIRCLE, 0, gc, dd);
+    op->a[0] = x; op->a[1] = y; op->a[2] = r;
+}
+
+static void CBM_Line(double x1, double y1, double x2, double y2,
+		     const pGEcontext gc, pDevDesc dd)
+{
+    CBMop *op = CBM_Add(CBM_LINE, 0, gc, dd);
+    op->a[0] = x1; op->a[1] = y1; op->a[2] = x2; op->a[3] = y2;
+}
+
+static void CBM_Polyline(int n, const double *x, const double *y,
+			 const pGEcontext gc, pDevDesc dd)
+{
+    CBMop *op = CBM_Add(CBM_POLYLINE, n, gc, dd);
+    memcpy(op->xy, x, n * sizeof(double));
+    memcpy(op->xy + n, y, n * sizeof(double));
+}
+
+static void CBM_Polygon(int n, const double *x, const double *y,
+			const pGEcontext gc, pDevDesc dd)
+{
+    CBMop *op = CBM_Add(CBM_POLYGON, n, gc, dd);
+    memcpy(op->xy, x, n * sizeof(double));
+    memcpy(op->xy + n, y, n * sizeof(double));
+}
+
+static void CBM_Path(double *x, double *y,
+		     int npoly, int *nper,
+		     Rboolean winding,
+		     const pGEcontext gc, pDevDesc dd)
+{
+    int i, n = 0;
+    CBMop *op;
+
+    for (i = 0; i < npoly; i++) n += nper[i];
+    op = CBM_Add(CBM_PATH, n, gc, dd);
+    op->nper = (int *) malloc(npoly * sizeof(int));
+    if (!op->nper) error(_("out of memory while queueing graphics"));
+    memcpy(op->nper, nper, npoly * sizeof(int));
+    op->npoly = npoly;
+    op->winding = winding;
+    memcpy(op->xy, x, n * sizeof(double));
+    memcpy(op->xy + n, y, n * sizeof(double));
+}
+
+static void CBM_Raster(unsigned int *raster, int w, int h,
+		       double x, double y,
+		       double width, double height,
+		       double rot,
+		       Rboolean interpolate,
+		       const pGEcontext gc, pDevDesc dd)
+{
+    CBM_Flush(dd);
+    Cairo_Raster(raster, w, h, x, y, width, height, rot, interpolate,
+		 gc, dd);
+}
+
+static void CBM_Text(double x, double y, const char *str,
+		     double rot, double hadj,
+		     const pGEcontext gc, pDevDesc dd)
+{
+    CBM_Flush(dd);
+#ifdef HAVE_PANGOCAIRO
+    PangoCairo_Text(x, y, str, rot, hadj, gc, dd);
+#else
+    Cairo_Text(x, y, str, rot, hadj, gc, dd);
+#endif
+}
+
+static void CBM_Free(pX11Desc xd)
+{
+    if (xd->queue) {
+	CBM_Clear(xd->queue);
+	free(xd->queue->ops);
+	free(xd->queue);
+	xd->queue = NULL;
+    }
+}
+#endif
+
 static Rboolean
 BM_Open(pDevDesc dd, pX11Desc xd, int width, int height)
 {
@@ -138,8 +460,11 @@ static unsigned int Cbitgp(void *xi, int x, int y)
     return data[x*stride+y];
 }
 
-static void BM_Close_bitmap(pX11Desc xd)
+static void BM_Close_bitmap(pX11Desc xd, pDevDesc dd)
 {
+#ifndef Win32
+    CBM_Flush(dd);
+#endif
     if (xd->type == PNGdirect) {
 	char buf[PATH_MAX];
 	snprintf(buf, PATH_MAX, xd->filename, xd->npages);
@@ -182,7 +507,7 @@ static void BM_NewPage(const pGEcontext gc, pDevDesc dd)
     if (xd->type == PNG || xd->type == JPEG || xd->type == BMP) {
 	if (xd->npages > 1) {
 	    /* try to preserve the page we do have */
-	    BM_Close_bitmap(xd);
+	    BM_Close_bitmap(xd, dd);
 	    if (xd->fp) fclose(xd->fp);
 	}
 	snprintf(buf, PATH_MAX, xd->filename, xd->npages);
@@ -193,7 +518,7 @@ static void BM_NewPage(const pGEcontext gc, pDevDesc dd)
     else if(xd->type == PNGdirect || xd->type == TIFF) {
 	if (xd->npages > 1) {
 	    xd->npages--;
-	    BM_Close_bitmap(xd);
+	    BM_Close_bitmap(xd, dd);
 	    xd->npages++;
 	}
     }
@@ -292,6 +617,12 @@ static void BM_NewPage(const pGEcontext gc, pDevDesc dd)
 	error(_("unimplemented cairo-based device"));
 
     cairo_reset_clip(xd->cc);
+#ifndef Win32
+    if (xd->queue) {
+	xd->queue->clipped = FALSE;
+	CBM_Clear(xd->queue);
+    }
+#endif
     if (xd->type == PNG  || xd->type == TIFF|| xd->type == PNGdirect) {
 	/* First clear it */
 	cairo_set_operator (xd->cc, CAIRO_OPERATOR_CLEAR);
@@ -313,11 +644,14 @@ static void BM_Close(pDevDesc dd)
     if (xd->npages)
 	if (xd->type == PNG || xd->type == JPEG ||
 	    xd->type == TIFF || xd->type == BMP || xd->type == PNGdirect)
-	    BM_Close_bitmap(xd);
+	    BM_Close_bitmap(xd, dd);
     if (xd->fp) fclose(xd->fp);
     if (xd->cc) cairo_show_page(xd->cc);
     if (xd->cs) cairo_surface_destroy(xd->cs);
     if (xd->cc) cairo_destroy(xd->cc);
+#ifndef Win32
+    CBM_Free(xd);
+#endif
     free(xd);
 }
 
@@ -421,6 +755,26 @@ BMDeviceDriver(pDevDesc dd, int kind, const char *filename,
     dd->newPage = BM_NewPage;
     dd->close = BM_Close;
 
+#ifndef Win32
+    if (xd->type == PNG || xd->type == JPEG || xd->type == TIFF ||
+	xd->type == BMP || xd->type == PNGdirect) {
+	int nthreads = asInteger(GetOption1(install("bitmap.threads")));
+	if (nthreads != NA_INTEGER && nthreads > 1 &&
+	    (xd->queue = (CBMqueue *) calloc(1, sizeof(CBMqueue)))) {
+	    xd->queue->nthreads = nthreads < 64 ? nthreads : 64;
+	    dd->clip = CBM_Clip;
+	    dd->rect = CBM_Rect;
+	    dd->circle = CBM_Circle;
+	    dd->line = CBM_Line;
+	    dd->polyline = CBM_Polyline;
+	    dd->polygon = CBM_Polygon;
+	    dd->path = CBM_Path;
+	    dd->raster = CBM_Raster;
+	    dd->text = dd->textUTF8 = CBM_Text;
+	}
+    }
+#endif
+
     dd->left = 0;
     dd->right = width;
     dd->top = 0;
@@ -96,6 +96,9 @@ typedef struct {
     cairo_antialias_t antialias;
 
     double fontscale;
+
+    struct CBMqueue *queue;		/* deferred drawing for threaded
+					   rendering, or NULL */
 } X11Desc;
 
 typedef X11Desc* pX11Desc;
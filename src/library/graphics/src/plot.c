@@ -1536,10 +1536,42 @@ SEXP C_plotXY(SEXP args)
 
     /* Points : */
     if (type == 'p' || type == 'b' || type == 'o') {
+	/* With options(graphics.decimate = TRUE), a large number of
+	   identical opaque symbols is drawn at most once per device
+	   unit: drawing another on top would not change the output. */
+	unsigned char *drawn = NULL;
+	double dleft = 0.0, dbottom = 0.0;
+	int dwidth = 0, dheight = 0;
+	if (n > 1000 && npch == 1 && ncex == 1 && ncol == 1 && nbg == 1
+	    && nlwd == 1 && R_OPAQUE(INTEGER(col)[0])
+	    && (R_OPAQUE(INTEGER(bg)[0]) || R_TRANSPARENT(INTEGER(bg)[0]))
+	    && GEdecimating()) {
+	    double w, h;
+	    dleft = fmin2(dd->dev->left, dd->dev->right);
+	    dbottom = fmin2(dd->dev->bottom, dd->dev->top);
+	    w = ceil(fabs(dd->dev->right - dd->dev->left)) + 1;
+	    h = ceil(fabs(dd->dev->top - dd->dev->bottom)) + 1;
+	    if (w * h <= 64.0 * 1024 * 1024) {
+		dwidth = (int) w;
+		dheight = (int) h;
+		vmax = vmaxget();
+		drawn = (unsigned char *) R_alloc((size_t) dwidth * dheight / 8 + 1, 1);
+		memset(drawn, 0, (size_t) dwidth * dheight / 8 + 1);
+	    }
+	}
 	for (i = 0; i < n; i++) {
 	    xx = x[i];
 	    yy = y[i];
 	    GConvert(&xx, &yy, USER, DEVICE, dd);
+	    if (drawn && R_FINITE(xx) && R_FINITE(yy)) {
+		double cx = floor(xx - dleft), cy = floor(yy - dbottom);
+		if (cx >= 0 && cx < dwidth && cy >= 0 && cy < dheight) {
+		    size_t cell = (size_t) cy * dwidth + (size_t) cx;
+		    if (drawn[cell / 8] & (1 << (cell % 8)))
+			continue;
+		    drawn[cell / 8] |= (unsigned char) (1 << (cell % 8));
+		}
+	    }
 	    if (R_FINITE(xx) && R_FINITE(yy)) {
 		if (R_FINITE( (thiscex = REAL(cex)[i % ncex]) ) &&
 		    (thispch = INTEGER(pch)[i % npch]) != NA_INTEGER) {
@@ -1559,6 +1591,7 @@ SEXP C_plotXY(SEXP args)
 		}
 	    }
 	}
+	if (drawn) vmaxset(vmax);
     }
     GMode(0, dd);
     GRestorePars(dd);
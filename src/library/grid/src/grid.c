@@ -1830,7 +1830,7 @@ SEXP L_lineTo(SEXP x, SEXP y, SEXP arrow)
  */
 SEXP L_lines(SEXP x, SEXP y, SEXP index, SEXP arrow) 
 {
-    int i, j, nx, nl, start=0;
+    int i, j, nx, nl, start=0, vector;
     double *xx, *yy;
     double xold, yold;
     double vpWidthCM, vpHeightCM;
@@ -1869,12 +1869,16 @@ SEXP L_lines(SEXP x, SEXP y, SEXP index, SEXP arrow)
 	yy = (double *) R_alloc(nx, sizeof(double));
 	xold = NA_REAL;
 	yold = NA_REAL;
+	vector = transformLocnVector(x, y, nx, INTEGER(indices), vpc,
+				     vpWidthCM, vpHeightCM, dd, transform,
+				     xx, yy);
 	for (i=0; i<nx; i++) {
-	    transformLocn(x, y, INTEGER(indices)[i] - 1, vpc, &gc,
-			  vpWidthCM, vpHeightCM,
-			  dd,
-			  transform,
-			  &(xx[i]), &(yy[i]));
+	    if (!vector)
+		transformLocn(x, y, INTEGER(indices)[i] - 1, vpc, &gc,
+			      vpWidthCM, vpHeightCM,
+			      dd,
+			      transform,
+			      &(xx[i]), &(yy[i]));
 	    /* The graphics engine only takes device coordinates
 	     */
 	    xx[i] = toDeviceX(xx[i], GE_INCHES, dd);
@@ -2367,7 +2371,7 @@ SEXP L_arrows(SEXP x1, SEXP x2, SEXP xnm1, SEXP xn,
 
 SEXP L_polygon(SEXP x, SEXP y, SEXP index)
 {
-    int i, j, nx, np, start=0;
+    int i, j, nx, np, start=0, vector;
     double *xx, *yy;
     double xold, yold;
     double vpWidthCM, vpHeightCM;
@@ -2406,12 +2410,16 @@ SEXP L_polygon(SEXP x, SEXP y, SEXP index)
 	yy = (double *) R_alloc(nx + 1, sizeof(double));
 	xold = NA_REAL;
 	yold = NA_REAL;
+	vector = transformLocnVector(x, y, nx, INTEGER(indices), vpc,
+				     vpWidthCM, vpHeightCM, dd, transform,
+				     xx, yy);
 	for (j=0; j<nx; j++) {
-	    transformLocn(x, y, INTEGER(indices)[j] - 1, vpc, &gc,
-			  vpWidthCM, vpHeightCM,
-			  dd,
-			  transform,
-			  &(xx[j]), &(yy[j]));
+	    if (!vector)
+		transformLocn(x, y, INTEGER(indices)[j] - 1, vpc, &gc,
+			      vpWidthCM, vpHeightCM,
+			      dd,
+			      transform,
+			      &(xx[j]), &(yy[j]));
 	    /* The graphics engine only takes device coordinates
 	     */
 	    xx[j] = toDeviceX(xx[j], GE_INCHES, dd);
@@ -2856,12 +2864,16 @@ SEXP L_path(SEXP x, SEXP y, SEXP index, SEXP rule)
     k = 0;
     for (i=0; i < npoly; i++) {
         SEXP indices = VECTOR_ELT(index, i);
+	int vector = transformLocnVector(x, y, nper[i], INTEGER(indices),
+					 vpc, vpWidthCM, vpHeightCM, dd,
+					 transform, xx + k, yy + k);
         for (j=0; j < nper[i]; j++) {            
-	    transformLocn(x, y, INTEGER(indices)[j] - 1, vpc, &gc,
-			  vpWidthCM, vpHeightCM,
-			  dd,
-			  transform,
-			  &(xx[k]), &(yy[k]));
+	    if (!vector)
+		transformLocn(x, y, INTEGER(indices)[j] - 1, vpc, &gc,
+			      vpWidthCM, vpHeightCM,
+			      dd,
+			      transform,
+			      &(xx[k]), &(yy[k]));
 	    /* The graphics engine only takes device coordinates
 	     */
 	    xx[k] = toDeviceX(xx[k], GE_INCHES, dd);
@@ -3300,7 +3312,7 @@ SEXP L_textBounds(SEXP label, SEXP x, SEXP y,
 
 SEXP L_points(SEXP x, SEXP y, SEXP pch, SEXP size)
 {
-    int i, nx, npch;
+    int i, nx, npch, vector;
     /*    double *xx, *yy;*/
     double *xx, *yy;
     double vpWidthCM, vpHeightCM;
@@ -3326,13 +3338,18 @@ SEXP L_points(SEXP x, SEXP y, SEXP pch, SEXP size)
     vmax = vmaxget();
     xx = (double *) R_alloc(nx, sizeof(double));
     yy = (double *) R_alloc(nx, sizeof(double));
+    vector = transformLocnVector(x, y, nx, NULL, vpc,
+				 vpWidthCM, vpHeightCM, dd, transform,
+				 xx, yy);
     for (i=0; i<nx; i++) {
-	gcontextFromgpar(currentgp, i, &gc, dd);
-	transformLocn(x, y, i, vpc, &gc,
-		      vpWidthCM, vpHeightCM,
-		      dd,
-		      transform,
-		      &(xx[i]), &(yy[i]));
+	if (!vector) {
+	    gcontextFromgpar(currentgp, i, &gc, dd);
+	    transformLocn(x, y, i, vpc, &gc,
+			  vpWidthCM, vpHeightCM,
+			  dd,
+			  transform,
+			  &(xx[i]), &(yy[i]));
+	}
 	/* The graphics engine only takes device coordinates
 	 */
 	xx[i] = toDeviceX(xx[i], GE_INCHES, dd);
@@ -1518,6 +1518,180 @@ void transformLocn(SEXP x, SEXP y, int index,
     *yy = locationY(lout);
 }
 
+/* Vectorised conversion of locations.
+ *
+ * transformLocn() works out the class, unit codes and data of x and y
+ * afresh for every location.  For the units most often used for
+ * locations (absolute units, npc, snpc and native, and sums,
+ * differences and multiples of these), the conversion to INCHES
+ * depends only on the viewport, so transformLocnVector() converts
+ * all the locations at once from flat arrays of values and unit codes.
+ * The arithmetic is the same as in transformLocation() and
+ * transformXArithmetic(), so the results are identical.
+ */
+static int simpleLocationUnit(int unit)
+{
+    switch (unit) {
+    case L_NPC:
+    case L_CM:
+    case L_INCHES:
+    case L_NATIVE:
+    case L_SNPC:
+    case L_MM:
+    case L_POINTS:
+    case L_PICAS:
+    case L_BIGPOINTS:
+    case L_DIDA:
+    case L_CICERO:
+    case L_SCALEDPOINTS:
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+static double simpleLocation(double value, int unit,
+			     double scalemin, double scalemax,
+			     double thisCM, double otherCM, double scale)
+{
+    double result = value;
+    switch (unit) {
+    case L_NATIVE:
+	return ((result - scalemin)/(scalemax - scalemin))*thisCM/2.54;
+    case L_NPC:
+	return (result * thisCM)/2.54;
+    case L_SNPC:
+	if (thisCM <= otherCM)
+	    return (result * thisCM)/2.54;
+	else
+	    return (result * otherCM)/2.54;
+    case L_CM:
+	result = result/2.54;
+	break;
+    case L_INCHES:
+	break;
+    case L_MM:
+	result = (result/10)/2.54;
+	break;
+    case L_POINTS:
+	result = result/72.27;
+	break;
+    case L_PICAS:
+	result = (result*12)/72.27;
+	break;
+    case L_BIGPOINTS:
+	result = result/72;
+	break;
+    case L_DIDA:
+	result = result/1157*1238/72.27;
+	break;
+    case L_CICERO:
+	result = result*12/1157*1238/72.27;
+	break;
+    case L_SCALEDPOINTS:
+	result = result/65536/72.27;
+	break;
+    }
+    /* Physical units are scaled by GSS_SCALE, as in transform() */
+    return result * scale;
+}
+
+/* Convert elements of the unit x to INCHES in result[0..n-1].
+ * Element i is indices[i] - 1 (as in the "index" argument of
+ * L_lines), or i if indices is NULL.  Returns 0, leaving result
+ * undefined, if x contains units that this cannot handle.
+ */
+static int transformSimpleLocation(SEXP x, int n, const int *indices,
+				   double scalemin, double scalemax,
+				   double thisCM, double otherCM,
+				   double scale, double *result)
+{
+    int i;
+    if (isUnitArithmetic(x)) {
+	if (addOp(x) || minusOp(x)) {
+	    int add = addOp(x);
+	    double *temp = (double *) R_alloc(n, sizeof(double));
+	    if (!transformSimpleLocation(arg1(x), n, indices,
+					 scalemin, scalemax, thisCM, otherCM,
+					 scale, result) ||
+		!transformSimpleLocation(arg2(x), n, indices,
+					 scalemin, scalemax, thisCM, otherCM,
+					 scale, temp))
+		return 0;
+	    for (i = 0; i < n; i++)
+		result[i] = add ? result[i] + temp[i] : result[i] - temp[i];
+	} else if (timesOp(x)) {
+	    SEXP mult = arg1(x);
+	    int nmult = LENGTH(mult);
+	    if (TYPEOF(mult) != REALSXP || nmult == 0 ||
+		!transformSimpleLocation(arg2(x), n, indices,
+					 scalemin, scalemax, thisCM, otherCM,
+					 scale, result))
+		return 0;
+	    for (i = 0; i < n; i++) {
+		int index = indices ? indices[i] - 1 : i;
+		result[i] = REAL(mult)[index % nmult] * result[i];
+	    }
+	} else
+	    return 0;
+    } else if (isUnitList(x)) {
+	return 0;
+    } else {
+	SEXP units = getAttrib(x, install("valid.unit"));
+	int nunits = LENGTH(units), nvalues = LENGTH(x);
+	const int *unit;
+	if (TYPEOF(units) != INTSXP || nunits == 0 || nvalues == 0)
+	    return 0;
+	unit = INTEGER(units);
+	for (i = 0; i < nunits; i++)
+	    if (!simpleLocationUnit(unit[i]))
+		return 0;
+	for (i = 0; i < n; i++) {
+	    int index = indices ? indices[i] - 1 : i;
+	    double value = (TYPEOF(x) == REALSXP) ?
+		REAL(x)[index % nvalues] : numeric(x, index % nvalues);
+	    result[i] = simpleLocation(value, unit[index % nunits],
+				       scalemin, scalemax,
+				       thisCM, otherCM, scale);
+	}
+    }
+    return 1;
+}
+
+/* Equivalent to calling transformLocn() for n locations, the i-th
+ * being indices[i] - 1 (or i if indices is NULL), but returning 0
+ * without converting anything if x or y contains units whose
+ * conversion depends on more than the viewport (e.g., "char",
+ * "strwidth", "grobx" or "null"); the caller should then use
+ * transformLocn() for each location.
+ *
+ * Temporary memory is allocated with R_alloc().
+ */
+int transformLocnVector(SEXP x, SEXP y, int n, const int *indices,
+			LViewportContext vpc,
+			double widthCM, double heightCM,
+			pGEDevDesc dd,
+			LTransform t,
+			double *xx, double *yy)
+{
+    int i;
+    double scale = REAL(gridStateElement(dd, GSS_SCALE))[0];
+    if (!transformSimpleLocation(x, n, indices,
+				 vpc.xscalemin, vpc.xscalemax,
+				 widthCM, heightCM, scale, xx) ||
+	!transformSimpleLocation(y, n, indices,
+				 vpc.yscalemin, vpc.yscalemax,
+				 heightCM, widthCM, scale, yy))
+	return 0;
+    /* As trans(), for a location with third coordinate 1 */
+    for (i = 0; i < n; i++) {
+	double x0 = xx[i], y0 = yy[i];
+	xx[i] = x0*t[0][0] + y0*t[1][0] + 1*t[2][0];
+	yy[i] = x0*t[0][1] + y0*t[1][1] + 1*t[2][1];
+    }
+    return 1;
+}
+
 double transformWidthtoINCHES(SEXP w, int index,
 			      LViewportContext vpc,
 			      const pGEcontext gc,
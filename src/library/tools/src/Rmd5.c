@@ -22,41 +22,248 @@
 #include "tools.h"
 #define ROL_UNUSED
 #include "md5.h"
+#include "hash.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+typedef enum { HASH_MD5, HASH_SHA256, HASH_XXH64 } hash_algo;
+
+typedef struct {
+    hash_algo algo;
+    union {
+	struct md5_ctx md5;
+	struct sha256_ctx sha256;
+	struct xxh64_ctx xxh64;
+    } u;
+} hash_ctx;
+
+/* Longest digest in hexadecimal, plus the terminator */
+#define HASH_HEXLEN 65
+
+/* Files are read unbuffered in blocks of this size, a multiple of 64 so
+   that MD5 and SHA-256 never need to copy a partial block. */
+#define HASH_BUFSIZE (1 << 20)
+
+/* Most threads used to hash a vector of files */
+#define HASH_THREADS 8
+
+static hash_algo hash_algorithm(SEXP algo)
+{
+    const char *s;
+    if(!isString(algo) || length(algo) != 1)
+	error(_("invalid '%s' argument"), "algorithm");
+    s = CHAR(STRING_ELT(algo, 0));
+    if(!strcmp(s, "md5")) return HASH_MD5;
+    if(!strcmp(s, "sha256")) return HASH_SHA256;
+    if(!strcmp(s, "xxh64")) return HASH_XXH64;
+    error(_("unknown hash algorithm '%s'"), s);
+    return HASH_MD5; /* -Wall */
+}
+
+static void hash_init(hash_ctx *ctx, hash_algo algo)
+{
+    ctx->algo = algo;
+    switch(algo) {
+    case HASH_MD5: md5_init_ctx(&ctx->u.md5); break;
+    case HASH_SHA256: sha256_init_ctx(&ctx->u.sha256); break;
+    case HASH_XXH64: xxh64_init_ctx(&ctx->u.xxh64, 0); break;
+    }
+}
+
+static void hash_update(hash_ctx *ctx, const void *buf, size_t len)
+{
+    switch(ctx->algo) {
+    case HASH_MD5: md5_process_bytes(buf, len, &ctx->u.md5); break;
+    case HASH_SHA256: sha256_process_bytes(buf, len, &ctx->u.sha256); break;
+    case HASH_XXH64: xxh64_process_bytes(buf, len, &ctx->u.xxh64); break;
+    }
+}
+
+/* Write the digest as lower-case hexadecimal to out */
+static void hash_hex(hash_ctx *ctx, char *out)
+{
+    unsigned char res[32];
+    int i, n = 0;
+    uint64_t h;
+
+    switch(ctx->algo) {
+    case HASH_MD5:
+	md5_finish_ctx(&ctx->u.md5, res);
+	n = 16;
+	break;
+    case HASH_SHA256:
+	sha256_finish_ctx(&ctx->u.sha256, res);
+	n = 32;
+	break;
+    case HASH_XXH64:
+	h = xxh64_finish_ctx(&ctx->u.xxh64);
+	for(n = 0; n < 8; n++)
+	    res[n] = (unsigned char) (h >> (56 - 8 * n));
+	break;
+    }
+    for(i = 0; i < n; i++)
+	sprintf(out + 2*i, "%02x", res[i]);
+}
+
+/* Hash one file into out, using buf for reading.  Returns 0 on success,
+   1 if the file cannot be opened and 2 on a read error.  This makes no
+   calls to the R API, so can be run on any thread. */
+static int hash_file(const char *path, hash_algo algo, unsigned char *buf,
+		     char *out)
+{
+    hash_ctx ctx;
+    size_t n;
+    int res;
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+#else
+    FILE *fp = fopen(path, "r");
+#endif
+    if(!fp) return 1;
+    /* buf is large enough that stdio buffering would only add a copy */
+    setvbuf(fp, NULL, _IONBF, 0);
+    hash_init(&ctx, algo);
+    while((n = fread(buf, 1, HASH_BUFSIZE, fp)) > 0)
+	hash_update(&ctx, buf, n);
+    res = ferror(fp) ? 2 : 0;
+    fclose(fp);
+    if(!res) hash_hex(&ctx, out);
+    return res;
+}
+
+typedef struct {
+    const char **paths;
+    int n;
+    hash_algo algo;
+    char *out;       /* n digests of HASH_HEXLEN bytes */
+    int *status;
+    int next;        /* index of next file to hash */
+#ifndef _WIN32
+    pthread_mutex_t lock;
+#endif
+} hash_job;
+
+typedef struct {
+    hash_job *job;
+    unsigned char *buf;
+} hash_worker;
+
+static void *hash_files_worker(void *arg)
+{
+    hash_worker *w = arg;
+    hash_job *job = w->job;
+    for(;;) {
+	int i;
+#ifndef _WIN32
+	pthread_mutex_lock(&job->lock);
+#endif
+	i = job->next++;
+#ifndef _WIN32
+	pthread_mutex_unlock(&job->lock);
+#endif
+	if(i >= job->n) break;
+	job->status[i] = hash_file(job->paths[i], job->algo, w->buf,
+				   job->out + (size_t) i * HASH_HEXLEN);
+    }
+    return NULL;
+}
 
 /* .Call so manages R_alloc stack */
-SEXP Rmd5(SEXP files)
+static SEXP hash_files(SEXP files, hash_algo algo)
 {
     SEXP ans;
-    int i, j, nfiles = length(files), res;
-    const char *path;
-    char out[33];
-    FILE *fp;
-    unsigned char resblock[16];
+    int i, nfiles = length(files), nthreads = 1;
+    hash_job job;
+    hash_worker *workers;
 
     if(!isString(files)) error(_("argument 'files' must be character"));
+    job.paths = (const char **) R_alloc(nfiles, sizeof(char *));
+    for(i = 0; i < nfiles; i++)
+	job.paths[i] = translateChar(STRING_ELT(files, i));
+    job.n = nfiles;
+    job.algo = algo;
+    job.out = R_alloc(nfiles, HASH_HEXLEN);
+    job.status = (int *) R_alloc(nfiles, sizeof(int));
+    job.next = 0;
+
+#ifndef _WIN32
+    if(nfiles > 1) {
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = ncpu < HASH_THREADS ? (int) ncpu : HASH_THREADS;
+	if(nthreads > nfiles) nthreads = nfiles;
+	if(nthreads < 1) nthreads = 1;
+    }
+#endif
+    workers = (hash_worker *) R_alloc(nthreads, sizeof(hash_worker));
+    for(i = 0; i < nthreads; i++) {
+	workers[i].job = &job;
+	workers[i].buf = (unsigned char *) R_alloc(HASH_BUFSIZE, 1);
+    }
+
+#ifndef _WIN32
+    if(nthreads > 1) {
+	pthread_t *tids = (pthread_t *) R_alloc(nthreads, sizeof(pthread_t));
+	int started = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	/* The calling thread takes a share of the files too, so a failure
+	   to start a thread only costs speed */
+	for(i = 1; i < nthreads; i++)
+	    if(!pthread_create(&tids[started], NULL, hash_files_worker,
+			       &workers[i]))
+		started++;
+	hash_files_worker(&workers[0]);
+	for(i = 0; i < started; i++)
+	    pthread_join(tids[i], NULL);
+	pthread_mutex_destroy(&job.lock);
+    } else
+#endif
+	hash_files_worker(&workers[0]);
+
     PROTECT(ans = allocVector(STRSXP, nfiles));
     for(i = 0; i < nfiles; i++) {
-	path = translateChar(STRING_ELT(files, i));
-#ifdef _WIN32
-	fp = fopen(path, "rb");
-#else
-	fp = fopen(path, "r");
-#endif
-	if(!fp) {
-	    SET_STRING_ELT(ans, i, NA_STRING);
-	} else {
-	    res = md5_stream(fp, &resblock);
-	    if(res) {
-		warning(_("md5 failed on file '%s'"), path);
-		SET_STRING_ELT(ans, i, NA_STRING);
-	    } else {
-		for(j = 0; j < 16; j++)
-		    sprintf (out+2*j, "%02x", resblock[j]);
-		SET_STRING_ELT(ans, i, mkChar(out));
+	if(job.status[i] == 0)
+	    SET_STRING_ELT(ans, i, mkChar(job.out + (size_t) i * HASH_HEXLEN));
+	else {
+	    if(job.status[i] == 2) {
+		if(algo == HASH_MD5)
+		    warning(_("md5 failed on file '%s'"), job.paths[i]);
+		else
+		    warning(_("hashing failed on file '%s'"), job.paths[i]);
 	    }
-	    fclose(fp);
+	    SET_STRING_ELT(ans, i, NA_STRING);
 	}
     }
     UNPROTECT(1);
     return ans;
 }
+
+SEXP Rmd5(SEXP files)
+{
+    return hash_files(files, HASH_MD5);
+}
+
+SEXP Rhashsum(SEXP files, SEXP algo)
+{
+    return hash_files(files, hash_algorithm(algo));
+}
+
+/* Hash the bytes of raw vector x after the first 'skip' */
+SEXP Rhashraw(SEXP x, SEXP algo, SEXP skip)
+{
+    hash_ctx ctx;
+    char out[HASH_HEXLEN];
+    R_xlen_t n, off = asInteger(skip);
+
+    if(TYPEOF(x) != RAWSXP) error(_("argument 'x' must be a raw vector"));
+    n = XLENGTH(x);
+    if(off == NA_INTEGER || off < 0 || off > n)
+	error(_("invalid '%s' argument"), "skip");
+    hash_init(&ctx, hash_algorithm(algo));
+    hash_update(&ctx, RAW(x) + off, n - off);
+    hash_hex(&ctx, out);
+    return mkString(out);
+}
@@ -0,0 +1,267 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* SHA-256 follows FIPS 180-4; XXH64 follows the xxHash specification
+   by Yann Collet.  Both read their input a byte at a time, so are
+   independent of alignment and byte order. */
+
+#include <string.h>
+#include "hash.h"
+
+/* ---------------------------------------------------------------- SHA-256 */
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_process_block(const unsigned char *p, size_t nblocks,
+				 uint32_t *state)
+{
+    uint32_t w[64];
+    while (nblocks--) {
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+	    e = state[4], f = state[5], g = state[6], h = state[7];
+	int i;
+	for (i = 0; i < 16; i++, p += 4)
+	    w[i] = (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16
+		| (uint32_t) p[2] << 8 | (uint32_t) p[3];
+	for (; i < 64; i++) {
+	    uint32_t s0 = ROR32(w[i-15], 7) ^ ROR32(w[i-15], 18) ^ (w[i-15] >> 3),
+		s1 = ROR32(w[i-2], 17) ^ ROR32(w[i-2], 19) ^ (w[i-2] >> 10);
+	    w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+	for (i = 0; i < 64; i++) {
+	    uint32_t S1 = ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25),
+		ch = (e & f) ^ (~e & g),
+		t1 = h + S1 + ch + sha256_k[i] + w[i],
+		S0 = ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22),
+		maj = (a & b) ^ (a & c) ^ (b & c),
+		t2 = S0 + maj;
+	    h = g; g = f; f = e; e = d + t1;
+	    d = c; c = b; b = a; a = t1 + t2;
+	}
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+void sha256_init_ctx(struct sha256_ctx *ctx)
+{
+    static const uint32_t init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, init, sizeof init);
+    ctx->total = 0;
+    ctx->buflen = 0;
+}
+
+void sha256_process_bytes(const void *buffer, size_t len,
+			  struct sha256_ctx *ctx)
+{
+    const unsigned char *p = buffer;
+    ctx->total += len;
+    if (ctx->buflen) {
+	size_t add = 64 - ctx->buflen < len ? 64 - ctx->buflen : len;
+	memcpy(ctx->buffer + ctx->buflen, p, add);
+	ctx->buflen += add;
+	p += add;
+	len -= add;
+	if (ctx->buflen < 64)
+	    return;
+	sha256_process_block(ctx->buffer, 1, ctx->state);
+	ctx->buflen = 0;
+    }
+    if (len >= 64) {
+	sha256_process_block(p, len / 64, ctx->state);
+	p += len & ~(size_t) 63;
+	len &= 63;
+    }
+    memcpy(ctx->buffer, p, len);
+    ctx->buflen = len;
+}
+
+void sha256_finish_ctx(struct sha256_ctx *ctx, void *resbuf)
+{
+    unsigned char *out = resbuf;
+    uint64_t bits = ctx->total << 3;
+    size_t n = ctx->buflen;
+    int i;
+
+    ctx->buffer[n++] = 0x80;
+    if (n > 56) {
+	memset(ctx->buffer + n, 0, 64 - n);
+	sha256_process_block(ctx->buffer, 1, ctx->state);
+	n = 0;
+    }
+    memset(ctx->buffer + n, 0, 56 - n);
+    for (i = 0; i < 8; i++)
+	ctx->buffer[63 - i] = (unsigned char) (bits >> (8 * i));
+    sha256_process_block(ctx->buffer, 1, ctx->state);
+    for (i = 0; i < 8; i++) {
+	out[4*i] = (unsigned char) (ctx->state[i] >> 24);
+	out[4*i + 1] = (unsigned char) (ctx->state[i] >> 16);
+	out[4*i + 2] = (unsigned char) (ctx->state[i] >> 8);
+	out[4*i + 3] = (unsigned char) ctx->state[i];
+    }
+}
+
+/* ------------------------------------------------------------------ XXH64 */
+
+#define XXH_PRIME1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME3 0x165667B19E3779F9ULL
+#define XXH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME5 0x27D4EB2F165667C5ULL
+
+#define ROL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static uint64_t read64(const unsigned char *p)
+{
+    return (uint64_t) p[0] | (uint64_t) p[1] << 8 | (uint64_t) p[2] << 16
+	| (uint64_t) p[3] << 24 | (uint64_t) p[4] << 32
+	| (uint64_t) p[5] << 40 | (uint64_t) p[6] << 48
+	| (uint64_t) p[7] << 56;
+}
+
+static uint32_t read32(const unsigned char *p)
+{
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+	| (uint32_t) p[3] << 24;
+}
+
+static uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME2;
+    acc = ROL64(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static uint64_t xxh64_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= xxh64_round(0, v);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+/* Consume whole 32-byte stripes from p, returning the number of bytes
+   used. */
+static size_t xxh64_stripes(const unsigned char *p, size_t len, uint64_t *v)
+{
+    size_t done = 0;
+    uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+    for (; len - done >= 32; done += 32) {
+	v1 = xxh64_round(v1, read64(p + done));
+	v2 = xxh64_round(v2, read64(p + done + 8));
+	v3 = xxh64_round(v3, read64(p + done + 16));
+	v4 = xxh64_round(v4, read64(p + done + 24));
+    }
+    v[0] = v1; v[1] = v2; v[2] = v3; v[3] = v4;
+    return done;
+}
+
+void xxh64_init_ctx(struct xxh64_ctx *ctx, uint64_t seed)
+{
+    ctx->v[0] = seed + XXH_PRIME1 + XXH_PRIME2;
+    ctx->v[1] = seed + XXH_PRIME2;
+    ctx->v[2] = seed;
+    ctx->v[3] = seed - XXH_PRIME1;
+    ctx->seed = seed;
+    ctx->total = 0;
+    ctx->buflen = 0;
+}
+
+void xxh64_process_bytes(const void *buffer, size_t len,
+			 struct xxh64_ctx *ctx)
+{
+    const unsigned char *p = buffer;
+    size_t done;
+    ctx->total += len;
+    if (ctx->buflen) {
+	size_t add = 32 - ctx->buflen < len ? 32 - ctx->buflen : len;
+	memcpy(ctx->buffer + ctx->buflen, p, add);
+	ctx->buflen += add;
+	p += add;
+	len -= add;
+	if (ctx->buflen < 32)
+	    return;
+	xxh64_stripes(ctx->buffer, 32, ctx->v);
+	ctx->buflen = 0;
+    }
+    done = xxh64_stripes(p, len, ctx->v);
+    memcpy(ctx->buffer, p + done, len - done);
+    ctx->buflen = len - done;
+}
+
+uint64_t xxh64_finish_ctx(struct xxh64_ctx *ctx)
+{
+    const unsigned char *p = ctx->buffer, *end = p + ctx->buflen;
+    uint64_t h;
+
+    if (ctx->total >= 32) {
+	uint64_t *v = ctx->v;
+	h = ROL64(v[0], 1) + ROL64(v[1], 7) + ROL64(v[2], 12) + ROL64(v[3], 18);
+	h = xxh64_merge(h, v[0]);
+	h = xxh64_merge(h, v[1]);
+	h = xxh64_merge(h, v[2]);
+	h = xxh64_merge(h, v[3]);
+    } else
+	h = ctx->seed + XXH_PRIME5;
+    h += ctx->total;
+
+    for (; end - p >= 8; p += 8) {
+	h ^= xxh64_round(0, read64(p));
+	h = ROL64(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+    }
+    if (end - p >= 4) {
+	h ^= (uint64_t) read32(p) * XXH_PRIME1;
+	h = ROL64(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+	p += 4;
+    }
+    for (; p < end; p++) {
+	h ^= *p * XXH_PRIME5;
+	h = ROL64(h, 11) * XXH_PRIME1;
+    }
+    h ^= h >> 33;
+    h *= XXH_PRIME2;
+    h ^= h >> 29;
+    h *= XXH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
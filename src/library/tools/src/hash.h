@@ -0,0 +1,62 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/* Streaming SHA-256 (FIPS 180-4) and XXH64 digests, used alongside the
+   MD5 code in md5.c by the hashing functions in Rmd5.c. */
+
+#ifndef R_TOOLS_HASH_H
+#define R_TOOLS_HASH_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct sha256_ctx
+{
+  uint32_t state[8];
+  uint64_t total;
+  size_t buflen;
+  unsigned char buffer[64];
+};
+
+void sha256_init_ctx(struct sha256_ctx *ctx);
+void sha256_process_bytes(const void *buffer, size_t len,
+			  struct sha256_ctx *ctx);
+/* Writes the 32-byte digest to resbuf. */
+void sha256_finish_ctx(struct sha256_ctx *ctx, void *resbuf);
+
+struct xxh64_ctx
+{
+  uint64_t v[4];
+  uint64_t seed;
+  uint64_t total;
+  size_t buflen;
+  unsigned char buffer[32];
+};
+
+void xxh64_init_ctx(struct xxh64_ctx *ctx, uint64_t seed);
+void xxh64_process_bytes(const void *buffer, size_t len,
+			 struct xxh64_ctx *ctx);
+/* Returns the 64-bit hash; its canonical form is big-endian. */
+uint64_t xxh64_finish_ctx(struct xxh64_ctx *ctx);
+
+#endif
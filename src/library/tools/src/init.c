@@ -41,6 +41,8 @@ static const R_CallMethodDef CallEntries[] = {
     CALLDEF(dirchmod, 2),
     {"C_getfmts", (DL_FUNC) &getfmts, 1},
     CALLDEF(Rmd5, 1),
+    CALLDEF(Rhashsum, 2),
+    CALLDEF(Rhashraw, 3),
     CALLDEF(check_nonASCII, 2),
     CALLDEF(check_nonASCII2, 1),
     CALLDEF(doTabExpand, 2),
@@ -39,8 +39,6 @@
 /* moved from md5.h */
 static void md5_process_block __P ((const void *buffer, size_t len,
 				    struct md5_ctx *ctx));
-static void md5_process_bytes __P ((const void *buffer, size_t len,
-				    struct md5_ctx *ctx));
 
 
 /* This array contains the bytes used to pad the buffer to the next
@@ -50,7 +48,7 @@ static const unsigned char fillbuf[64] = { 0x80, 0 /* , 0, 0, ...  */ };
 
 /* Initialize structure containing state of computation.
    (RFC 1321, 3.3: Step 3)  */
-static void
+void
 md5_init_ctx (struct md5_ctx *ctx)
 {
   ctx->A = 0x67452301;
@@ -83,7 +81,7 @@ md5_read_ctx (const struct md5_ctx *ctx, void *resbuf)
 
    IMPORTANT: On some systems it is required that RESBUF is correctly
    aligned for a 32 bits value.  */
-static void *
+void *
 md5_finish_ctx (struct md5_ctx *ctx, void *resbuf)
 {
   /* Take yet unprocessed bytes into account.  */
@@ -184,8 +182,8 @@ md5_buffer (const char *buffer, size_t len, void *resblock)
 }
 #endif
 
-static void
- md5_process_bytes (const void *buffer, size_t len, struct md5_ctx *ctx)
+void
+md5_process_bytes (const void *buffer, size_t len, struct md5_ctx *ctx)
 {
   /* When we already have some bits in our internal buffer concatenate
      both inputs first.  */
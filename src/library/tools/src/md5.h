@@ -101,6 +101,13 @@ struct md5_ctx
    beginning at RESBLOCK.  */
 extern int md5_stream __P ((FILE *stream, void *resblock));
 
+/* Initialize, update and finish a digest computed from buffers, as
+   used by md5_stream.  md5_finish_ctx writes 16 bytes at RESBUF. */
+extern void md5_init_ctx __P ((struct md5_ctx *ctx));
+extern void md5_process_bytes __P ((const void *buffer, size_t len,
+				    struct md5_ctx *ctx));
+extern void *md5_finish_ctx __P ((struct md5_ctx *ctx, void *resbuf));
+
 #ifndef ROL_UNUSED
 /* The following is from gnupg-1.0.2's cipher/bithelp.h.  */
 /* Rotate a 32 bit integer by n bytes */
@@ -32,6 +32,8 @@
 SEXP delim_match(SEXP x, SEXP delims);
 SEXP dirchmod(SEXP dr);
 SEXP Rmd5(SEXP files);
+SEXP Rhashsum(SEXP files, SEXP algo);
+SEXP Rhashraw(SEXP x, SEXP algo, SEXP skip);
 SEXP check_nonASCII(SEXP text, SEXP ignore_quotes);
 SEXP check_nonASCII2(SEXP text);
 SEXP doTabExpand(SEXP strings, SEXP starts);
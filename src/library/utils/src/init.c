@@ -36,6 +36,7 @@ static const R_CallMethodDef CallEntries[] = {
     CALLDEF(menu, 1),
     CALLDEF(nsl, 1),
     CALLDEF(objectSize, 1),
+    CALLDEF(objectSizeExact, 1),
     CALLDEF(processevents, 0),
     CALLDEF(octsize, 1),
 
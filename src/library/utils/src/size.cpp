@@ -33,8 +33,13 @@
 
 #include <Defn.h>
 #include "rho/ExpressionVector.hpp"
+#include "rho/GCNodeAllocator.hpp"
 #include "rho/GCStackRoot.hpp"
 
+#include <array>
+#include <unordered_set>
+#include <vector>
+
 using namespace rho;
 
 /* A count of the memory used by an object. The following assumptions
@@ -163,3 +168,106 @@ SEXP objectSize(SEXP x)
 {
     return ScalarReal( double( objectsize(x)) );
 }
+
+/* The exact size of an object, from the sizes of the allocator blocks
+   actually holding it and the nodes reachable from it.  Each node is
+   charged once however often it is shared, and as with objectsize()
+   no charge is made for symbols, environments, promises or builtins,
+   which are not traversed.  The result has an attribute "types"
+   giving the bytes charged to each type of node. */
+
+namespace {
+    class SizeVisitor : public GCNode::const_visitor {
+    public:
+	SizeVisitor()
+	    : m_bytes(0)
+	{
+	    m_type_bytes.fill(0);
+	}
+
+	void operator()(const GCNode* node) override
+	{
+	    if (m_visited.insert(node).second)
+		m_pending.push_back(node);
+	}
+
+	// Charge each pending node and queue its referents:
+	void run()
+	{
+	    while (!m_pending.empty()) {
+		const GCNode* node = m_pending.back();
+		m_pending.pop_back();
+		const RObject* robj = dynamic_cast<const RObject*>(node);
+		SEXPTYPE type = robj ? robj->sexptype() : NILSXP;
+		if (robj && (robj == R_NilValue || robj == NA_STRING
+			     || !traversed(type)))
+		    continue;
+		std::size_t bytes = GCNodeAllocator::allocationSize(node);
+		m_bytes += bytes;
+		m_type_bytes[robj ? type : ANYSXP] += bytes;
+		node->visitReferents(this);
+	    }
+	}
+
+	std::size_t bytes() const
+	{
+	    return m_bytes;
+	}
+
+	std::size_t typeBytes(SEXPTYPE type) const
+	{
+	    return m_type_bytes[type];
+	}
+    private:
+	std::unordered_set<const GCNode*> m_visited;
+	std::vector<const GCNode*> m_pending;
+	std::size_t m_bytes;
+	std::array<std::size_t, MAX_NUM_SEXPTYPE> m_type_bytes;
+
+	static bool traversed(SEXPTYPE type)
+	{
+	    switch (type) {
+	    case SYMSXP:
+	    case ENVSXP:
+	    case PROMSXP:
+	    case SPECIALSXP:
+	    case BUILTINSXP:
+		return false;
+	    default:
+		return true;
+	    }
+	}
+    };
+}
+
+extern "C"
+SEXP objectSizeExact(SEXP x)
+{
+    SizeVisitor visitor;
+    if (x && x != R_NilValue)
+	visitor(x);
+    visitor.run();
+
+    // Summarize by type, omitting types not found:
+    int ntypes = 0;
+    for (int type = 0; type < MAX_NUM_SEXPTYPE; ++type)
+	if (visitor.typeBytes(SEXPTYPE(type)))
+	    ++ntypes;
+    GCStackRoot<> types(allocVector(REALSXP, ntypes));
+    GCStackRoot<> names(allocVector(STRSXP, ntypes));
+    for (int type = 0, i = 0; type < MAX_NUM_SEXPTYPE; ++type) {
+	std::size_t bytes = visitor.typeBytes(SEXPTYPE(type));
+	if (bytes) {
+	    REAL(types)[i] = double(bytes);
+	    SET_STRING_ELT(names, i, mkChar(type == ANYSXP ? "internal"
+					    : type2char(SEXPTYPE(type))));
+	    ++i;
+	}
+    }
+    setAttrib(types, R_NamesSymbol, names);
+
+    SEXP ans = PROTECT(ScalarReal(double(visitor.bytes())));
+    setAttrib(ans, install("types"), types);
+    UNPROTECT(1);
+    return ans;
+}
@@ -25,6 +25,7 @@
 #endif
 
 SEXP objectSize(SEXP s);
+SEXP objectSizeExact(SEXP s);
 SEXP unzip(SEXP args);
 SEXP Rprof(SEXP args);
 SEXP Rprofmem(SEXP args);
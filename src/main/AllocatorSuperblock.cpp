@@ -28,11 +28,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "rho/AddressSanitizer.hpp"
 #include "rho/AllocationTable.hpp"
@@ -43,14 +50,32 @@ namespace {
   uintptr_t arena_superblock_start = 0;
   uintptr_t arena_superblock_end = 0;
   uintptr_t arena_superblock_next = 0;
+
+  // All medium-object superblocks, which are allocated separately:
+  std::vector<rho::AllocatorSuperblock*> large_superblocks;
+
+  // Superblocks whose pages have been released, available for reuse:
+  std::vector<rho::AllocatorSuperblock*> released_arena_superblocks;
+  std::vector<rho::AllocatorSuperblock*> released_large_superblocks;
 }
 
 void rho::AllocatorSuperblock::allocateArena() {
+  static_assert(sizeof(AllocatorSuperblock) <= s_superblock_header_size,
+                "superblock header members exceed the fixed header size");
   void* arena = nullptr;
   size_t space = s_arenasize; // Total acquired arena space.
-  if (posix_memalign(&arena, s_small_superblock_size, space) != 0) {
+  // Align to huge pages if they are to be used:
+  size_t alignment = GCNodeAllocator::s_use_huge_pages
+      ? size_t{1} << GCNodeAllocator::s_huge_page_log2
+      : s_small_superblock_size;
+  if (posix_memalign(&arena, alignment, space) != 0) {
     allocerr("failed to allocate small-object arena");
   }
+#ifdef MADV_HUGEPAGE
+  if (GCNodeAllocator::s_use_huge_pages) {
+    madvise(arena, space, MADV_HUGEPAGE);
+  }
+#endif
   size_t num_superblock = space / s_small_superblock_size;
   arena_superblock_start = reinterpret_cast<uintptr_t>(arena);
   arena_superblock_end = arena_superblock_start
@@ -63,6 +88,16 @@ void rho::AllocatorSuperblock::allocateArena() {
 
 rho::AllocatorSuperblock* rho::AllocatorSuperblock::newSuperblockFromArena(
     unsigned block_size) {
+  unsigned superblock_size =
+      (s_small_superblock_size - s_superblock_header_size) / block_size;
+  unsigned bitset_entries = (superblock_size + 63) / 64;
+  if (!released_arena_superblocks.empty()) {
+    // Reuse a released superblock, possibly for a different size class.
+    void* pointer = released_arena_superblocks.back();
+    released_arena_superblocks.pop_back();
+    return new (pointer)AllocatorSuperblock(
+        sizeClassFromBlockSize(block_size), bitset_entries);
+  }
   if (arena_superblock_next >= arena_superblock_end) {
     return nullptr;
   }
@@ -70,9 +105,6 @@ rho::AllocatorSuperblock* rho::AllocatorSuperblock::newSuperblockFromArena(
   // The whole arena is poisoned on allocation, now we just unpoison this
   // superblock header.
   ASAN_UNPOISON_MEMORY_REGION(pointer, s_superblock_header_size);
-  unsigned superblock_size =
-      (s_small_superblock_size - s_superblock_header_size) / block_size;
-  unsigned bitset_entries = (superblock_size + 63) / 64;
   AllocatorSuperblock* superblock =
       new (pointer)AllocatorSuperblock(
           sizeClassFromBlockSize(block_size), bitset_entries);
@@ -82,13 +114,22 @@ rho::AllocatorSuperblock* rho::AllocatorSuperblock::newSuperblockFromArena(
 
 rho::AllocatorSuperblock* rho::AllocatorSuperblock::newLargeSuperblock(
     unsigned size_log2) {
-  void* memory = new double[s_large_superblock_size / sizeof(double)];
   unsigned bitset_entries =
       ((1 << (s_large_superblock_size_log2 - size_log2)) + 63) / 64;
+  if (!released_large_superblocks.empty()) {
+    // Reuse a released superblock.  It is already in the allocation table,
+    // which does not depend on the size class.
+    void* memory = released_large_superblocks.back();
+    released_large_superblocks.pop_back();
+    return new (memory)AllocatorSuperblock(
+        sizeClassFromSizeLog2(size_log2), bitset_entries);
+  }
+  void* memory = new double[s_large_superblock_size / sizeof(double)];
   AllocatorSuperblock* superblock = new (memory)AllocatorSuperblock(
       sizeClassFromSizeLog2(size_log2), bitset_entries);
   GCNodeAllocator::s_alloctable->insertSuperblock(superblock,
       s_large_superblock_size_log2);
+  large_superblocks.push_back(superblock);
   // Poison all blocks in the superblock. They are unpoisoned one at a time
   // later, when allocated.
   ASAN_POISON_MEMORY_REGION(
@@ -153,6 +194,72 @@ void* rho::AllocatorSuperblock::allocateBlock(size_t block_size) {
   return superblock->allocateNextUntouched();
 }
 
+size_t rho::AllocatorSuperblock::allocateBlocks(size_t block_size,
+                                               size_t count,
+                                               void** results) {
+  unsigned size_class = sizeClassFromBlockSize(block_size);
+  size_t done = 0;
+  while (done < count) {
+    AllocatorSuperblock* superblock =
+        GCNodeAllocator::s_superblocks[size_class];
+    if (!superblock) {
+      superblock = newSuperblockFromArena(block_size);
+      if (!superblock) {
+        break;
+      }
+      GCNodeAllocator::s_superblocks[size_class] = superblock;
+    }
+    done += superblock->allocateUntouchedRun(count - done, results + done);
+  }
+  return done;
+}
+
+void rho::AllocatorSuperblock::allocateLargeBlocks(unsigned size_log2,
+                                                   size_t count,
+                                                   void** results) {
+  unsigned size_class = sizeClassFromSizeLog2(size_log2);
+  size_t done = 0;
+  while (done < count) {
+    AllocatorSuperblock* superblock =
+        GCNodeAllocator::s_superblocks[size_class];
+    if (!superblock) {
+      superblock = newLargeSuperblock(size_log2);
+      GCNodeAllocator::s_superblocks[size_class] = superblock;
+    }
+    done += superblock->allocateUntouchedRun(count - done, results + done);
+  }
+}
+
+size_t rho::AllocatorSuperblock::allocateUntouchedRun(size_t max_count,
+                                                      void** results) {
+  unsigned block_size = blockSize();
+  unsigned num_blocks =
+      (superblockSize() - s_superblock_header_size) / block_size;
+  uint32_t first = m_next_untouched;
+  uint32_t end = first + std::min<size_t>(max_count, num_blocks - first);
+  // Tag the run as allocated a bitset entry at a time:
+  for (uint32_t block = first; block < end; ) {
+    unsigned bit = block & 63;
+    unsigned bits = std::min(64 - bit, end - block);
+    uint64_t mask = (bits == 64 ? ~uint64_t{0}
+                     : ((uint64_t{1} << bits) - 1) << bit);
+    m_free[block / 64] &= ~mask;
+    block += bits;
+  }
+  m_next_untouched = end;
+  if (m_next_untouched == num_blocks) {
+    GCNodeAllocator::s_superblocks[m_size_class] = nullptr;
+  }
+  uintptr_t block = firstBlockPointer() + first * block_size;
+  ASAN_UNPOISON_MEMORY_REGION(reinterpret_cast<void*>(block),
+                              (end - first) * block_size);
+  for (uint32_t index = first; index < end; ++index) {
+    *results++ = reinterpret_cast<void*>(block);
+    block += block_size;
+  }
+  return end - first;
+}
+
 void* rho::AllocatorSuperblock::allocateNextUntouched() {
   unsigned block_size = blockSize();
   unsigned num_blocks =
@@ -248,6 +355,112 @@ void rho::AllocatorSuperblock::applyToBlocks(std::function<void(void*)> fun)
   }
 }
 
+bool rho::AllocatorSuperblock::isIdle() const {
+  unsigned num_blocks =
+      (superblockSize() - s_superblock_header_size) / blockSize();
+  unsigned bitset_entries = (num_blocks + 63) / 64;
+  for (unsigned i = 0; i < bitset_entries; ++i) {
+    if (m_free[i] != ~0ull) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void rho::AllocatorSuperblock::releasePages() {
+#if defined(__unix__) || defined(__APPLE__)
+  uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  // Round up past the header, which stays resident:
+  uintptr_t start = (firstBlockPointer() + page_size - 1) & ~(page_size - 1);
+  uintptr_t end = endPointer() & ~(page_size - 1);
+  if (start < end) {
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+  }
+#endif
+}
+
+size_t rho::AllocatorSuperblock::releaseIdleSuperblocks(
+    unsigned min_idle_scans, size_t retained_bytes) {
+#ifdef HAVE_ADDRESS_SANITIZER
+  // Free blocks may be in the quarantine rather than the freelists.
+  return 0;
+#else
+  std::vector<AllocatorSuperblock*> candidates;
+  size_t idle_bytes = 0;
+  auto scan = [&](AllocatorSuperblock* superblock) {
+    if (superblock->m_idle_scans == s_released) {
+      return;
+    }
+    // Superblocks with untouched blocks are about to be used.
+    if (superblock->isIdle()
+        && GCNodeAllocator::s_superblocks[superblock->m_size_class]
+           != superblock) {
+      idle_bytes += superblock->superblockSize();
+      if (++superblock->m_idle_scans > min_idle_scans) {
+        candidates.push_back(superblock);
+      }
+    } else {
+      superblock->m_idle_scans = 0;
+    }
+  };
+  for (uintptr_t next = arena_superblock_start; next < arena_superblock_next;
+       next += s_small_superblock_size) {
+    scan(reinterpret_cast<AllocatorSuperblock*>(next));
+  }
+  for (AllocatorSuperblock* superblock : large_superblocks) {
+    scan(superblock);
+  }
+
+  // Select superblocks to release, keeping retained_bytes idle:
+  std::vector<AllocatorSuperblock*> selected;
+  size_t released = 0;
+  while (!candidates.empty() && idle_bytes > retained_bytes) {
+    AllocatorSuperblock* superblock = candidates.back();
+    candidates.pop_back();
+    superblock->m_idle_scans = s_released;
+    idle_bytes -= superblock->superblockSize();
+    released += superblock->superblockSize();
+    selected.push_back(superblock);
+  }
+  if (selected.empty()) {
+    return 0;
+  }
+
+  // Unlink the blocks of released superblocks from the freelists before
+  // their contents are discarded:
+  for (unsigned size_class = 0;
+       size_class < GCNodeAllocator::s_num_small_pools
+                    + GCNodeAllocator::s_num_medium_pools;
+       ++size_class) {
+    FreeListNode** link = &GCNodeAllocator::s_freelists[size_class];
+    while (*link) {
+      FreeListNode* node = *link;
+      if (node->m_superblock
+          && node->m_superblock->m_idle_scans == s_released) {
+        *link = node->m_next;
+      } else {
+        link = &node->m_next;
+      }
+    }
+  }
+
+  for (AllocatorSuperblock* superblock : selected) {
+    superblock->releasePages();
+    if (superblock->m_size_class < GCNodeAllocator::s_num_small_pools) {
+      released_arena_superblocks.push_back(superblock);
+    } else {
+      released_large_superblocks.push_back(superblock);
+    }
+  }
+  return released;
+#endif  // HAVE_ADDRESS_SANITIZER
+}
+
+size_t rho::AllocatorSuperblock::releasedBytes() {
+  return released_arena_superblocks.size() * s_small_superblock_size
+      + released_large_superblocks.size() * s_large_superblock_size;
+}
+
 void rho::AllocatorSuperblock::debugPrintSmallSuperblocks() {
   uintptr_t next_superblock = arena_superblock_start;
   while (next_superblock < arena_superblock_next) {
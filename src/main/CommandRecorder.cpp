@@ -0,0 +1,334 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file CommandRecorder.cpp
+ *
+ * Implementation of class CommandRecorder, and the recordCommand
+ * and bindingDigests builtins.
+ */
+
+#include "rho/CommandRecorder.hpp"
+
+#include "Defn.h"
+#include "Internal.h"
+#include "rho/ContentHash.hpp"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+using namespace rho;
+
+CommandRecorder* CommandRecorder::s_current = nullptr;
+Frame::monitor CommandRecorder::s_old_read_monitor = nullptr;
+Frame::monitor CommandRecorder::s_old_write_monitor = nullptr;
+bool CommandRecorder::s_reading = false;
+
+CommandRecorder::CommandRecorder(Environment* env)
+    : m_outer(s_current), m_read_active(false)
+{
+    if (!m_outer) {
+	s_old_read_monitor = Frame::setReadMonitor(monitorRead);
+	s_old_write_monitor = Frame::setWriteMonitor(monitorWrite);
+    }
+    for (Environment* e : scope(env)) {
+	const Frame* frame = e->frame();
+	m_scope.push_back(Monitored{GCRoot<Environment>(e),
+				    frame->isReadMonitored(),
+				    frame->isWriteMonitored()});
+	frame->enableReadMonitoring(true);
+	frame->enableWriteMonitoring(true);
+    }
+    s_current = this;
+}
+
+CommandRecorder::~CommandRecorder()
+{
+    for (const Monitored& m : m_scope) {
+	const Frame* frame = m.env->frame();
+	frame->enableReadMonitoring(m.was_read_monitored);
+	frame->enableWriteMonitoring(m.was_write_monitored);
+    }
+    s_current = m_outer;
+    if (!m_outer) {
+	Frame::setReadMonitor(s_old_read_monitor);
+	Frame::setWriteMonitor(s_old_write_monitor);
+    }
+}
+
+int CommandRecorder::depth(const Frame* frame) const
+{
+    for (std::size_t i = 0; i < m_scope.size(); ++i)
+	if (m_scope[i].env->frame() == frame)
+	    return int(i);
+    return -1;
+}
+
+void CommandRecorder::monitorRead(const Frame::Binding& bdg)
+{
+    if (s_reading)
+	return;
+    for (CommandRecorder* r = s_current; r; r = r->m_outer)
+	r->readBinding(bdg);
+    if (s_old_read_monitor && wasMonitored(bdg.frame(), true))
+	s_old_read_monitor(bdg);
+}
+
+void CommandRecorder::monitorWrite(const Frame::Binding& bdg)
+{
+    for (CommandRecorder* r = s_current; r; r = r->m_outer)
+	r->writeBinding(bdg);
+    if (s_old_write_monitor && wasMonitored(bdg.frame(), false))
+	s_old_write_monitor(bdg);
+}
+
+void CommandRecorder::noteFileRead(const char* path)
+{
+    if (!s_current || !path || !*path)
+	return;
+    std::string file = R_ExpandFileName(path);
+#ifdef HAVE_UNISTD_H
+    if (file[0] != '/') {
+	char buf[PATH_MAX];
+	if (getcwd(buf, PATH_MAX))
+	    file = std::string(buf) + "/" + file;
+    }
+#endif
+    for (CommandRecorder* r = s_current; r; r = r->m_outer)
+	r->m_files.insert(file);
+}
+
+void CommandRecorder::readBinding(const Frame::Binding& bdg)
+{
+    int d = depth(bdg.frame());
+    if (d < 0)
+	return;
+    Key key(bdg.symbol(), d);
+    if (m_written_keys.count(key) || !m_read_keys.insert(key).second)
+	return;
+    if (bdg.isActive()) {
+	m_read_active = true;
+	return;
+    }
+    s_reading = true;
+    RObject* value = bdg.rawValue();
+    s_reading = false;
+    // The value is now shared with this CommandRecorder:
+    if (value && value->sexptype() != PROMSXP)
+	SET_NAMED(value, NAMEDMAX);
+    m_reads.push_back(Read{bdg.symbol(), unsigned(d), GCRoot<>(value)});
+}
+
+std::vector<Environment*> CommandRecorder::scope(Environment* env)
+{
+    std::vector<Environment*> ans;
+    for (; env; env = env->enclosingEnvironment()) {
+	if (env == Environment::base() || env == Environment::empty()
+	    || (env != Environment::global()
+		&& (R_IsPackageEnv(env) || R_IsNamespaceEnv(env))))
+	    break;
+	ans.push_back(env);
+	if (env == Environment::global())
+	    break;
+    }
+    return ans;
+}
+
+bool CommandRecorder::wasMonitored(const Frame* frame, bool read)
+{
+    const Monitored* outermost = nullptr;
+    for (const CommandRecorder* r = s_current; r; r = r->m_outer) {
+	int d = r->depth(frame);
+	if (d >= 0)
+	    outermost = &r->m_scope[d];
+    }
+    if (!outermost)
+	return true;
+    return read ? outermost->was_read_monitored
+	: outermost->was_write_monitored;
+}
+
+void CommandRecorder::writeBinding(const Frame::Binding& bdg)
+{
+    int d = depth(bdg.frame());
+    if (d < 0)
+	return;
+    Key key(bdg.symbol(), d);
+    if (m_written_keys.insert(key).second)
+	m_writes.push_back(key);
+}
+
+// ***** Builtins *****
+
+// The value of a binding as seen by the commands reading it:
+static RObject* bindingValue(RObject* value)
+{
+    if (value && TYPEOF(value) == PROMSXP && PRVALUE(value) != R_UnboundValue)
+	return PRVALUE(value);
+    return value;
+}
+
+// The depth in the scope of the binding, and the digest of its
+// value, which together identify the value read:
+static SEXP digestString(unsigned int depth, RObject* value)
+{
+    std::string ans = std::to_string(depth) + ":"
+	+ ContentHash::digest(value).hex();
+    return mkChar(ans.c_str());
+}
+
+/* .Internal(recordCommand(fun, envir)):
+ *
+ * Calls fun() while recording the bindings of envir and its scope
+ * that are read and written, and the files opened for reading.  The
+ * result is a list with components 'value' (the value of fun()),
+ * 'reads' (the depths and digests of the bindings read, named by
+ * symbol), 'writes' (the values of the bindings written),
+ * 'writeDepths', 'removed' (the names of bindings written and
+ * subsequently removed), 'removedDepths', 'files' and 'active' (true
+ * if an active binding was read or written).  The depth of a binding
+ * is the number of environments enclosing envir to be passed through
+ * to reach it.
+ */
+SEXP attribute_hidden do_recordcommand(/*const*/ Expression* call, const BuiltInFunction* op, RObject* fun_, RObject* envir_)
+{
+    if (TYPEOF(fun_) != CLOSXP)
+	error(_("invalid '%s' argument"), "fun");
+    if (TYPEOF(envir_) != ENVSXP)
+	error(_("invalid '%s' argument"), "envir");
+    Environment* env = static_cast<Environment*>(envir_);
+    std::vector<Environment*> envs = CommandRecorder::scope(env);
+    GCStackRoot<> value;
+    CommandRecorder::ReadVector reads;
+    CommandRecorder::WriteVector writes;
+    std::set<std::string> files;
+    bool active;
+    {
+	CommandRecorder recorder(env);
+	GCStackRoot<> expr(lang1(fun_));
+	value = eval(expr, R_GlobalEnv);
+	reads = recorder.bindingsRead();
+	writes = recorder.bindingsWritten();
+	files = recorder.filesRead();
+	active = recorder.readActiveBinding();
+    }
+
+    // Digests are computed only now, as serialization may itself
+    // read bindings:
+    GCStackRoot<> rdigests(allocVector(STRSXP, reads.size()));
+    GCStackRoot<> rnames(allocVector(STRSXP, reads.size()));
+    for (std::size_t i = 0; i < reads.size(); ++i) {
+	const CommandRecorder::Read& read = reads[i];
+	SET_STRING_ELT(rnames, i, PRINTNAME(const_cast<Symbol*>(read.symbol)));
+	SET_STRING_ELT(rdigests, i,
+		       digestString(read.depth, bindingValue(read.value)));
+    }
+    setAttrib(rdigests, R_NamesSymbol, rnames);
+
+    CommandRecorder::WriteVector removed;
+    std::vector<std::pair<CommandRecorder::WriteVector::value_type, RObject*> >
+	written;
+    for (const auto& write : writes) {
+	Frame::Binding* bdg = envs[write.second]->frame()->binding(write.first);
+	if (!bdg)
+	    removed.push_back(write);
+	else {
+	    if (bdg->isActive())
+		active = true;
+	    written.push_back(std::make_pair(write,
+					     bindingValue(bdg->rawValue())));
+	}
+    }
+    GCStackRoot<> wvalues(allocVector(VECSXP, written.size()));
+    GCStackRoot<> wnames(allocVector(STRSXP, written.size()));
+    GCStackRoot<> wdepths(allocVector(INTSXP, written.size()));
+    for (std::size_t i = 0; i < written.size(); ++i) {
+	RObject* wvalue = written[i].second;
+	if (wvalue)
+	    SET_NAMED(wvalue, NAMEDMAX);
+	SET_VECTOR_ELT(wvalues, i, wvalue);
+	SET_STRING_ELT(wnames, i,
+		       PRINTNAME(const_cast<Symbol*>(written[i].first.first)));
+	INTEGER(wdepths)[i] = int(written[i].first.second);
+    }
+    setAttrib(wvalues, R_NamesSymbol, wnames);
+
+    GCStackRoot<> rm(allocVector(STRSXP, removed.size()));
+    GCStackRoot<> rmdepths(allocVector(INTSXP, removed.size()));
+    for (std::size_t i = 0; i < removed.size(); ++i) {
+	SET_STRING_ELT(rm, i, PRINTNAME(const_cast<Symbol*>(removed[i].first)));
+	INTEGER(rmdepths)[i] = int(removed[i].second);
+    }
+
+    GCStackRoot<> fpaths(allocVector(STRSXP, files.size()));
+    R_xlen_t i = 0;
+    for (const std::string& file : files)
+	SET_STRING_ELT(fpaths, i++, mkChar(file.c_str()));
+
+    static const char* names[] = {"value", "reads", "writes", "writeDepths",
+				  "removed", "removedDepths", "files",
+				  "active", ""};
+    GCStackRoot<> ans(mkNamed(VECSXP, names));
+    SET_VECTOR_ELT(ans, 0, value);
+    SET_VECTOR_ELT(ans, 1, rdigests);
+    SET_VECTOR_ELT(ans, 2, wvalues);
+    SET_VECTOR_ELT(ans, 3, wdepths);
+    SET_VECTOR_ELT(ans, 4, rm);
+    SET_VECTOR_ELT(ans, 5, rmdepths);
+    SET_VECTOR_ELT(ans, 6, fpaths);
+    SET_VECTOR_ELT(ans, 7, ScalarLogical(active));
+    return ans;
+}
+
+/* .Internal(bindingDigests(names, envir)): for each name, the depth
+ * and digest, as recorded by recordCommand, of the binding a command
+ * evaluated in envir would now find in the scope of envir, or NA if
+ * there is none.
+ */
+SEXP attribute_hidden do_bindingdigests(/*const*/ Expression* call, const BuiltInFunction* op, RObject* names_, RObject* envir_)
+{
+    if (!isString(names_))
+	error(_("invalid '%s' argument"), "names");
+    if (TYPEOF(envir_) != ENVSXP)
+	error(_("invalid '%s' argument"), "envir");
+    std::vector<Environment*> envs
+	= CommandRecorder::scope(static_cast<Environment*>(envir_));
+    R_xlen_t n = XLENGTH(names_);
+    GCStackRoot<> ans(allocVector(STRSXP, n));
+    for (R_xlen_t i = 0; i < n; ++i) {
+	SET_STRING_ELT(ans, i, NA_STRING);
+	SEXP name = STRING_ELT(names_, i);
+	if (name == NA_STRING)
+	    continue;
+	const Symbol* sym = Symbol::obtain(translateChar(name));
+	for (std::size_t d = 0; d < envs.size(); ++d) {
+	    Frame::Binding* bdg = envs[d]->frame()->binding(sym);
+	    if (bdg) {
+		if (!bdg->isActive())
+		    SET_STRING_ELT(ans, i, digestString(d, bindingValue(bdg->rawValue())));
+		break;
+	    }
+	}
+    }
+    return ans;
+}
@@ -0,0 +1,259 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file ContentHash.cpp
+ *
+ * Implementation of class ContentHash.  The XXH64 lanes follow the
+ * xxHash specification by Yann Collet.
+ */
+
+#include "rho/ContentHash.hpp"
+
+#include "Defn.h"
+#include "rho/RObject.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace rho;
+
+namespace {
+    const std::uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    const std::uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    const std::uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    const std::uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    // Seeds of the two lanes:
+    const std::uint64_t seeds[2] = {0, 0x5DEECE66DULL};
+
+    inline std::uint64_t rotl(std::uint64_t x, int n)
+    {
+	return (x << n) | (x >> (64 - n));
+    }
+
+    inline std::uint64_t read64(const unsigned char* p)
+    {
+	std::uint64_t ans = 0;
+	for (int i = 7; i >= 0; --i)
+	    ans = (ans << 8) | p[i];
+	return ans;
+    }
+
+    inline std::uint64_t read32(const unsigned char* p)
+    {
+	return std::uint64_t(p[0]) | std::uint64_t(p[1]) << 8
+	    | std::uint64_t(p[2]) << 16 | std::uint64_t(p[3]) << 24;
+    }
+
+    inline std::uint64_t xxhRound(std::uint64_t acc, std::uint64_t input)
+    {
+	acc += input * PRIME2;
+	return rotl(acc, 31) * PRIME1;
+    }
+
+    inline std::uint64_t xxhMerge(std::uint64_t acc, std::uint64_t v)
+    {
+	acc ^= xxhRound(0, v);
+	return acc * PRIME1 + PRIME4;
+    }
+
+    // Destination of a serialization.  Its first skip bytes, the
+    // serialization header recording the version of R that wrote it,
+    // are discarded.  If hash is null, the bytes are only counted.
+    struct Sink {
+	ContentHash* hash;
+	std::size_t skip;
+	std::size_t count;
+    };
+
+    void outBytes(R_outpstream_t stream, const void* buf, int length)
+    {
+	Sink* sink = static_cast<Sink*>(stream->data);
+	const unsigned char* p = static_cast<const unsigned char*>(buf);
+	std::size_t n = std::size_t(length);
+	sink->count += n;
+	std::size_t skipped = std::min(sink->skip, n);
+	sink->skip -= skipped;
+	if (sink->hash)
+	    sink->hash->update(p + skipped, n - skipped);
+    }
+
+    void outChar(R_outpstream_t stream, int c)
+    {
+	unsigned char ch = static_cast<unsigned char>(c);
+	outBytes(stream, &ch, 1);
+    }
+
+    // External pointers all serialize alike, so their addresses are
+    // hashed instead:
+    SEXP persistentName(SEXP s, SEXP data)
+    {
+	if (TYPEOF(s) != EXTPTRSXP)
+	    return R_NilValue;
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "extptr:%p", R_ExternalPtrAddr(s));
+	return mkString(buf);
+    }
+
+    void serializeTo(Sink* sink, const RObject* object)
+    {
+	R_outpstream_st stream;
+	R_InitOutPStream(&stream, sink, R_pstream_binary_format, 2,
+			 outChar, outBytes, persistentName, R_NilValue);
+	R_Serialize(const_cast<RObject*>(object), &stream);
+    }
+
+    // Length of the serialization header, found as the length of the
+    // serialization of NULL less the four bytes of its type code.
+    std::size_t headerBytes()
+    {
+	static std::size_t ans = 0;
+	if (ans == 0) {
+	    Sink sink = {nullptr, 0, 0};
+	    serializeTo(&sink, nullptr);
+	    ans = sink.count - 4;
+	}
+	return ans;
+    }
+
+    void serializeInto(ContentHash* hash, const RObject* object)
+    {
+	Sink sink = {hash, headerBytes(), 0};
+	serializeTo(&sink, object);
+    }
+}
+
+std::string ContentHash::Digest::hex() const
+{
+    char buf[33];
+    std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+		  static_cast<unsigned long long>(hi),
+		  static_cast<unsigned long long>(lo));
+    return buf;
+}
+
+ContentHash::ContentHash()
+    : m_total(0), m_buflen(0)
+{
+    for (int l = 0; l < 2; ++l) {
+	std::uint64_t seed = seeds[l];
+	m_lanes[l].seed = seed;
+	m_lanes[l].v[0] = seed + PRIME1 + PRIME2;
+	m_lanes[l].v[1] = seed + PRIME2;
+	m_lanes[l].v[2] = seed;
+	m_lanes[l].v[3] = seed - PRIME1;
+    }
+}
+
+// Consume length bytes, a multiple of 32, into both lanes.
+void ContentHash::stripes(const unsigned char* data, std::size_t length)
+{
+    for (int l = 0; l < 2; ++l) {
+	std::uint64_t v1 = m_lanes[l].v[0], v2 = m_lanes[l].v[1],
+	    v3 = m_lanes[l].v[2], v4 = m_lanes[l].v[3];
+	for (const unsigned char* p = data; p < data + length; p += 32) {
+	    v1 = xxhRound(v1, read64(p));
+	    v2 = xxhRound(v2, read64(p + 8));
+	    v3 = xxhRound(v3, read64(p + 16));
+	    v4 = xxhRound(v4, read64(p + 24));
+	}
+	m_lanes[l].v[0] = v1;
+	m_lanes[l].v[1] = v2;
+	m_lanes[l].v[2] = v3;
+	m_lanes[l].v[3] = v4;
+    }
+}
+
+void ContentHash::update(const void* data, std::size_t length)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    m_total += length;
+    if (m_buflen) {
+	std::size_t add = std::min(32 - m_buflen, length);
+	std::memcpy(m_buffer + m_buflen, p, add);
+	m_buflen += add;
+	p += add;
+	length -= add;
+	if (m_buflen < 32)
+	    return;
+	stripes(m_buffer, 32);
+	m_buflen = 0;
+    }
+    std::size_t whole = length & ~std::size_t(31);
+    stripes(p, whole);
+    m_buflen = length - whole;
+    std::memcpy(m_buffer, p + whole, m_buflen);
+}
+
+void ContentHash::update(const RObject* object)
+{
+    serializeInto(this, object);
+}
+
+ContentHash::Digest ContentHash::digest() const
+{
+    std::uint64_t h[2];
+    for (int l = 0; l < 2; ++l) {
+	const Lane& lane = m_lanes[l];
+	std::uint64_t acc;
+	if (m_total >= 32) {
+	    acc = rotl(lane.v[0], 1) + rotl(lane.v[1], 7)
+		+ rotl(lane.v[2], 12) + rotl(lane.v[3], 18);
+	    for (int i = 0; i < 4; ++i)
+		acc = xxhMerge(acc, lane.v[i]);
+	} else
+	    acc = lane.seed + PRIME5;
+	acc += m_total;
+	const unsigned char* p = m_buffer;
+	const unsigned char* end = m_buffer + m_buflen;
+	for (; end - p >= 8; p += 8) {
+	    acc ^= xxhRound(0, read64(p));
+	    acc = rotl(acc, 27) * PRIME1 + PRIME4;
+	}
+	if (end - p >= 4) {
+	    acc ^= read32(p) * PRIME1;
+	    acc = rotl(acc, 23) * PRIME2 + PRIME3;
+	    p += 4;
+	}
+	for (; p < end; ++p) {
+	    acc ^= *p * PRIME5;
+	    acc = rotl(acc, 11) * PRIME1;
+	}
+	acc ^= acc >> 33;
+	acc *= PRIME2;
+	acc ^= acc >> 29;
+	acc *= PRIME3;
+	acc ^= acc >> 32;
+	h[l] = acc;
+    }
+    return Digest{h[0], h[1]};
+}
+
+ContentHash::Digest ContentHash::digest(const RObject* object)
+{
+    ContentHash hash;
+    hash.update(object);
+    return hash.digest();
+}
@@ -0,0 +1,141 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file FileBackedVector.cpp
+ *
+ * Implementation of class FileMapping, and the mmapVector builtin.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "rho/FileBackedVector.hpp"
+
+#include "Defn.h"
+#include "Internal.h"
+#include "rho/IntVector.hpp"
+#include "rho/LogicalVector.hpp"
+#include "rho/RealVector.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef Unix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace rho;
+
+FileMapping::FileMapping(const char* path, std::size_t offset,
+			 std::size_t bytes, std::size_t granule)
+    : m_base(nullptr), m_length(0), m_data(nullptr), m_size(0)
+{
+#ifdef Unix
+    if (offset % granule != 0)
+	Rf_error(_("offset must be a multiple of %d bytes"), int(granule));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+	Rf_error(_("cannot open file '%s': %s"), path, strerror(errno));
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+	int err = errno;
+	close(fd);
+	Rf_error(_("cannot open file '%s': %s"), path, strerror(err));
+    }
+    std::size_t filesize = std::size_t(sb.st_size);
+    if (offset > filesize) {
+	close(fd);
+	Rf_error(_("offset is beyond the end of file '%s'"), path);
+    }
+    if (bytes == std::size_t(-1))
+	bytes = (filesize - offset)/granule*granule;
+    else if (bytes > filesize - offset) {
+	close(fd);
+	Rf_error(_("file '%s' is too short"), path);
+    }
+    if (bytes != 0) {
+	// mmap() requires a page-aligned file offset:
+	std::size_t pagesize = std::size_t(sysconf(_SC_PAGESIZE));
+	std::size_t skip = offset % pagesize;
+	m_length = bytes + skip;
+	void* base = mmap(nullptr, m_length, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE, fd, off_t(offset - skip));
+	if (base == MAP_FAILED) {
+	    int err = errno;
+	    close(fd);
+	    Rf_error(_("cannot map file '%s': %s"), path, strerror(err));
+	}
+	m_base = base;
+	m_data = static_cast<char*>(base) + skip;
+	m_size = bytes;
+    }
+    // The mapping remains valid after the descriptor is closed:
+    close(fd);
+#else
+    Rf_error(_("memory-mapped files are not supported on this platform"));
+#endif
+}
+
+FileMapping::~FileMapping()
+{
+#ifdef Unix
+    if (m_base)
+	munmap(m_base, m_length);
+#endif
+}
+
+// ***** Builtin *****
+
+/* .Internal(mmapVector(file, mode, length, offset)) */
+SEXP attribute_hidden do_mmapvector(/*const*/ Expression* call, const BuiltInFunction* op, RObject* file_, RObject* mode_, RObject* length_, RObject* offset_)
+{
+    if (!isString(file_) || LENGTH(file_) != 1 || STRING_ELT(file_, 0) == NA_STRING)
+	error(_("invalid '%s' argument"), "file");
+    if (!isString(mode_) || LENGTH(mode_) != 1)
+	error(_("invalid '%s' argument"), "mode");
+    double length = asReal(length_), offset = asReal(offset_);
+    if (!R_FINITE(offset) || offset < 0)
+	error(_("invalid '%s' argument"), "offset");
+    if (!ISNA(length) && (!R_FINITE(length) || length < 0))
+	error(_("invalid '%s' argument"), "length");
+#ifdef WORDS_BIGENDIAN
+    error(_("memory-mapped vectors require a little-endian platform"));
+#endif
+    const char* path = R_ExpandFileName(translateChar(STRING_ELT(file_, 0)));
+    const char* mode = CHAR(STRING_ELT(mode_, 0));
+    std::size_t off = std::size_t(offset);
+    std::size_t len = ISNA(length) ? std::size_t(-1) : std::size_t(length);
+
+    if (streql(mode, "double"))
+	return FileBackedVector<double, REALSXP>::create(path, off, len);
+    else if (streql(mode, "integer"))
+	return FileBackedVector<int, INTSXP>::create(path, off, len);
+    else if (streql(mode, "logical"))
+	return FileBackedVector<Logical, LGLSXP>::create(path, off, len);
+    error(_("invalid '%s' argument"), "mode");
+    return nullptr;  // -Wall
+}
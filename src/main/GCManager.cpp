@@ -31,13 +31,18 @@
 
 #include "rho/GCManager.hpp"
 
+#include <chrono>
 #include <cstdarg>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include "Defn.h"
 #include "R_ext/Print.h"
 #include "rho/GCNode.hpp"
+#include "rho/AllocationTable.hpp"
+#include "rho/GCNodeAllocator.hpp"
+#include "rho/HeapSizingPolicy.hpp"
 #include "rho/WeakRef.hpp"
 
 using namespace rho;
@@ -49,6 +54,9 @@ size_t GCManager::s_min_threshold = s_threshold;
 size_t GCManager::s_gclite_threshold = s_threshold;
 bool GCManager::s_gc_is_running = false;
 bool GCManager::s_gc_pending = false;
+HeapSizingPolicy* GCManager::s_policy = nullptr;
+std::deque<GCManager::Event> GCManager::s_events;
+std::FILE* GCManager::s_event_log = nullptr;
 size_t GCManager::s_max_bytes = 0;
 size_t GCManager::s_max_nodes = 0;
 
@@ -60,6 +68,40 @@ void (*GCManager::s_post_gc)() = nullptr;
 namespace {
     unsigned int gc_count = 0;
 
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last_gc_end = Clock::now();
+
+    void addPhaseTimes(GCManager::Event* event)
+    {
+	const GCNode::PhaseTimes& phases = GCNode::lastPhaseTimes();
+	event->root_scan += phases.root_scan;
+	event->mark += phases.mark;
+	event->sweep += phases.sweep;
+    }
+
+    void writeEvent(std::FILE* file, const GCManager::Event& event)
+    {
+	fprintf(file, "{\"gc\":%u,\"time\":%.6f,\"kind\":\"%s\","
+		"\"trigger\":\"%s\",\"pause\":%.9g,"
+		"\"root_scan\":%.9g,\"mark\":%.9g,\"sweep\":%.9g,"
+		"\"bytes_before\":%zu,\"bytes_after\":%zu,"
+		"\"nodes_before\":%zu,\"nodes_after\":%zu,"
+		"\"released_bytes\":%zu,\"table_buckets\":%u,"
+		"\"insert_collisions\":%u,\"search_collisions\":%u,"
+		"\"erase_collisions\":%u,\"freelists\":[",
+		event.number, event.time, event.full ? "full" : "lite",
+		event.trigger, event.pause,
+		event.root_scan, event.mark, event.sweep,
+		event.bytes_before, event.bytes_after,
+		event.nodes_before, event.nodes_after,
+		event.released_bytes, event.table_buckets,
+		event.insert_collisions, event.search_collisions,
+		event.erase_collisions);
+	for (size_t i = 0; i < event.freelists.size(); ++i)
+	    fprintf(file, i ? ",%zu" : "%zu", event.freelists[i]);
+	fputs("]}\n", file);
+	fflush(file);
+    }
 
 #ifdef DEBUG_GC
     // This ought to go in GCNode.
@@ -83,6 +125,7 @@ void GCManager::gc(bool force_full_collection)
 	s_gc_pending = true;
 	return;
     }
+    bool deferred = s_gc_pending;
     s_gc_pending = false;
 
     // Prevent recursion:
@@ -96,24 +139,75 @@ void GCManager::gc(bool force_full_collection)
 
     if (s_pre_gc) (*s_pre_gc)();
 
+    HeapSizingPolicy::Collection collection;
+    Clock::time_point start = Clock::now();
+    collection.bytes_before = MemoryBank::bytesAllocated();
+    collection.mutator_seconds
+	= std::chrono::duration<double>(start - last_gc_end).count();
+
+    Event event;
+    event.number = gc_count;
+    event.time = std::chrono::duration<double>(
+	std::chrono::system_clock::now().time_since_epoch()).count();
+    event.trigger = (force_full_collection ? "explicit"
+		     : deferred ? "deferred" : "allocation");
+    event.root_scan = event.mark = event.sweep = 0;
+    event.bytes_before = collection.bytes_before;
+    event.nodes_before = GCNode::numNodes();
+
     GCNode::gc(false);
+    addPhaseTimes(&event);
 
-    if (force_full_collection || MemoryBank::bytesAllocated() > s_threshold) {
+    collection.full = (force_full_collection
+		       || MemoryBank::bytesAllocated() > s_threshold);
+    if (collection.full) {
 	GCNode::gc(true);
-	s_threshold = std::max(size_t(0.8*double(s_threshold)),
-			       std::max(s_min_threshold,
-					size_t(1.2*MemoryBank::bytesAllocated())));
+	addPhaseTimes(&event);
+	GCNodeAllocator::releaseFreeMemory();
     }
 
-    s_gclite_threshold = std::max(size_t(0.8*double(s_gclite_threshold)),
-			       std::max(s_min_threshold,
-					size_t(1.2*MemoryBank::bytesAllocated())));
+    last_gc_end = Clock::now();
+    collection.bytes_after = MemoryBank::bytesAllocated();
+    collection.gc_seconds
+	= std::chrono::duration<double>(last_gc_end - start).count();
+    heapSizingPolicy()->adjustThresholds(collection, s_min_threshold,
+					 &s_gclite_threshold, &s_threshold);
+
+    event.full = collection.full;
+    event.pause = collection.gc_seconds;
+    event.bytes_after = collection.bytes_after;
+    event.nodes_after = GCNode::numNodes();
+    event.released_bytes = GCNodeAllocator::releasedBytes();
+    const AllocationTable* table = GCNodeAllocator::allocationTable();
+    event.table_buckets = table->numBuckets();
+    event.insert_collisions = table->insertCollisions();
+    event.search_collisions = table->searchCollisions();
+    event.erase_collisions = table->eraseCollisions();
+    if (collection.full)
+	GCNodeAllocator::freelistLengths(&event.freelists);
+    if (s_event_log)
+	writeEvent(s_event_log, event);
+    if (s_events.size() == maxEvents)
+	s_events.pop_front();
+    s_events.push_back(std::move(event));
 
     if (s_post_gc) (*s_post_gc)();
 
     s_gc_is_running = false;
 }
 
+void GCManager::clearEvents()
+{
+    s_events.clear();
+}
+
+HeapSizingPolicy* GCManager::heapSizingPolicy()
+{
+    if (!s_policy)
+	s_policy = new GrowthHeapPolicy;
+    return s_policy;
+}
+
 void GCManager::resetMaxTallies()
 {
     s_max_bytes = MemoryBank::bytesAllocated();
@@ -125,6 +219,24 @@ void GCManager::setGCThreshold(size_t initial_threshold)
     s_min_threshold = s_gclite_threshold = s_threshold = initial_threshold;
 }
 
+bool GCManager::setEventLog(const char* path)
+{
+    if (s_event_log) {
+	fclose(s_event_log);
+	s_event_log = nullptr;
+    }
+    if (!path || !*path)
+	return true;
+    s_event_log = fopen(path, "a");
+    return s_event_log != nullptr;
+}
+
+void GCManager::setHeapSizingPolicy(HeapSizingPolicy* policy)
+{
+    delete s_policy;
+    s_policy = (policy ? policy : new GrowthHeapPolicy);
+}
+
 std::ostream* GCManager::setReporting(std::ostream* os)
 {
     std::ostream* ans = s_os;
@@ -32,6 +32,7 @@
 #include "rho/GCNode.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
@@ -54,6 +55,33 @@ using namespace rho;
 vector<const GCNode*>* GCNode::s_moribund = 0;
 unsigned int GCNode::s_num_nodes = 0;
 bool GCNode::s_on_stack_bits_correct = false;
+GCNode::PhaseTimes GCNode::s_phase_times = {0, 0, 0};
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // Start of the current phase of garbage collection:
+    Clock::time_point phase_start;
+
+    double secondsSince(Clock::time_point* start)
+    {
+	Clock::time_point now = Clock::now();
+	double ans = std::chrono::duration<double>(now - *start).count();
+	*start = now;
+	return ans;
+    }
+
+    // Data registered by GCNode::registerExternalData(), keyed by its
+    // start, with its end and owner:
+    typedef std::map<uintptr_t, std::pair<uintptr_t, const GCNode*> >
+    ExternalDataMap;
+
+    ExternalDataMap* externalData()
+    {
+	static ExternalDataMap* data = new ExternalDataMap;
+	return data;
+    }
+}
 
 // Used to update reference count bits of a GCNode. The array element at index
 // 2N + 1 is XORed with the current refcount bits to compute the updated reference
@@ -87,6 +115,16 @@ HOT_FUNCTION void* GCNode::operator new(size_t bytes) {
     return result;
 }
 
+void GCNode::allocateBatch(size_t bytes, size_t count, void** results) {
+    GCManager::maybeGC();
+    MemoryBank::notifyAllocation(bytes, count);
+    GCNodeAllocator::allocateBatch(bytes, count, results);
+    for (size_t i = 0; i < count; ++i) {
+        new (results[i])GCNode(
+            static_cast<CreateAMinimallyInitializedGCNode*>(nullptr));
+    }
+}
+
 GCNode::GCNode(CreateAMinimallyInitializedGCNode*)
     : m_refcount_flags(s_decinc_refcount[1]) {
 }
@@ -128,6 +166,8 @@ void GCNode::gc(bool markSweep) {
     }
     GCManager::GCInhibitor inhibitor;
 
+    s_phase_times = {0, 0, 0};
+    phase_start = Clock::now();
     ProtectStack::protectAll();
     incRefCount(R_Srcref);
 
@@ -145,15 +185,19 @@ void GCNode::markSweepGC() {
     // any new stack roots.  To ensure correctness, this function must not call
     // any code that depends on normal operation of the garbage collector.
     s_on_stack_bits_correct = true;
+    s_phase_times.root_scan = secondsSince(&phase_start);
 
     mark();
+    s_phase_times.mark = secondsSince(&phase_start);
     sweep();
+    s_phase_times.sweep = secondsSince(&phase_start);
 
     s_on_stack_bits_correct = false;
 }
 
 void GCNode::gclite() {
     s_on_stack_bits_correct = true;
+    s_phase_times.root_scan = secondsSince(&phase_start);
 
     while (!s_moribund->empty()) {
         // Last in, first out, for cache efficiency:
@@ -166,6 +210,7 @@ void GCNode::gclite() {
             delete node;
         }
     }
+    s_phase_times.sweep = secondsSince(&phase_start);
 
     s_on_stack_bits_correct = false;
 }
@@ -269,7 +314,30 @@ void rho::initializeMemorySubsystem() {
 // Returns nullptr if the candidate pointer is not inside a GCNode,
 // otherwise returns the pointer to the enclosign GCNode.
 GCNode* GCNode::asGCNode(void* candidate_pointer) {
-    return GCNodeAllocator::lookupPointer(candidate_pointer);
+    GCNode* node = GCNodeAllocator::lookupPointer(candidate_pointer);
+    if (node)
+        return node;
+    ExternalDataMap* data = externalData();
+    if (data->empty())
+        return nullptr;
+    uintptr_t candidate = reinterpret_cast<uintptr_t>(candidate_pointer);
+    ExternalDataMap::const_iterator it = data->upper_bound(candidate);
+    if (it == data->begin())
+        return nullptr;
+    --it;
+    if (candidate > it->second.first)
+        return nullptr;
+    return const_cast<GCNode*>(it->second.second);
+}
+
+void GCNode::registerExternalData(const void* begin, const void* end,
+                                  const GCNode* node) {
+    (*externalData())[reinterpret_cast<uintptr_t>(begin)]
+        = std::make_pair(reinterpret_cast<uintptr_t>(end), node);
+}
+
+void GCNode::unregisterExternalData(const void* begin) {
+    externalData()->erase(reinterpret_cast<uintptr_t>(begin));
 }
 
 GCNode::InternalData GCNode::storeInternalData() const {
@@ -27,16 +27,35 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <limits>
 #include <map>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #include "rho/AddressSanitizer.hpp"
 #include "rho/AllocationTable.hpp"
+#include "rho/AllocatorSuperblock.hpp"
 #include "rho/GCNodeAllocator.hpp"
 
+// Transparent huge pages are only supported on Linux.
+// HAVE_ADDRESS_SANITIZER is defined by AddressSanitizer.hpp:
+#if defined(__linux__) && defined(MADV_HUGEPAGE) \
+    && !defined(HAVE_ADDRESS_SANITIZER)
+#define HUGE_PAGES_SUPPORTED
+#endif
+
 #ifdef HAVE_ADDRESS_SANITIZER
 // Quarantine free lists are used to store freed objects for a while before
 // they can be reused. Allocations are poisoned while in the quarantine. This
@@ -60,6 +79,12 @@ uintptr_t rho::GCNodeAllocator::s_heap_end = 0;
 // Free lists head pointers.
 rho::FreeListNode* rho::GCNodeAllocator::s_freelists[s_num_freelists];
 
+bool rho::GCNodeAllocator::s_use_huge_pages = false;
+bool rho::GCNodeAllocator::s_populate_huge_pages = false;
+
+unsigned rho::GCNodeAllocator::s_release_min_idle_calls = 2;
+std::size_t rho::GCNodeAllocator::s_release_retained_bytes = 16 << 20;
+
 #ifdef ALLOCATION_CHECK
 // Helper function for allocator consistency checking.
 // An additional allocation map is added which shadows the state of the
@@ -159,6 +184,12 @@ static unsigned next_log2_32(unsigned size) {
  * and initialize the hashtable.
  */
 void rho::GCNodeAllocator::initialize() {
+#ifdef HUGE_PAGES_SUPPORTED
+  const char* env = getenv("R_HUGEPAGES");
+  s_use_huge_pages = env && strcmp(env, "yes") == 0;
+  env = getenv("R_HUGEPAGES_POPULATE");
+  s_populate_huge_pages = s_use_huge_pages && env && strcmp(env, "yes") == 0;
+#endif
   AllocatorSuperblock::allocateArena();
 
   for (int i = 0; i < s_num_small_pools + s_num_medium_pools; ++i) {
@@ -221,7 +252,7 @@ void* rho::GCNodeAllocator::allocate(size_t bytes) {
       if (size_log2 < s_num_medium_pools) {
         result = AllocatorSuperblock::allocateLarge(size_log2);
       } else {
-        result = new double[(1L << size_log2) / sizeof(double)];
+        result = allocateLargeBlock(size_log2);
         GCNodeAllocator::s_alloctable->insert(result, size_log2);
       }
       // Only update heap bounds if allocating a new block.
@@ -257,6 +288,50 @@ void* rho::GCNodeAllocator::allocate(size_t bytes) {
   return result;
 }
 
+void rho::GCNodeAllocator::allocateBatch(std::size_t bytes, std::size_t count,
+                                         void** results) {
+  std::size_t done = 0;
+#if !defined(HAVE_ADDRESS_SANITIZER) && !defined(ALLOCATION_CHECK)
+  // The redzones and allocation map of these configurations are only
+  // maintained by allocate(), which is used for everything here that
+  // does not come from a freelist or a run of untouched superblock
+  // blocks.
+  if (bytes <= s_maximum_small_block_size) {
+    unsigned size_class = std::max<unsigned>((bytes + 7) / 8, 4);
+    while (done < count) {
+      void* result = removeFromFreelist(size_class);
+      if (!result) {
+        break;
+      }
+      results[done++] = result;
+    }
+    done += AllocatorSuperblock::allocateBlocks(size_class * 8,
+                                                count - done, results + done);
+  } else {
+    unsigned size_log2 = next_log2_32(bytes);
+    if (size_log2 < s_num_medium_pools) {
+      unsigned size_class =
+          AllocatorSuperblock::sizeClassFromSizeLog2(size_log2);
+      while (done < count) {
+        void* result = removeFromFreelist(size_class);
+        if (!result) {
+          break;
+        }
+        results[done++] = result;
+      }
+      AllocatorSuperblock::allocateLargeBlocks(size_log2, count - done,
+                                               results + done);
+      for (; done < count; ++done) {
+        updateHeapBounds(results[done], 1 << size_log2);
+      }
+    }
+  }
+#endif
+  for (; done < count; ++done) {
+    results[done] = allocate(bytes);
+  }
+}
+
 void rho::GCNodeAllocator::free(void* pointer) {
 #ifdef HAVE_ADDRESS_SANITIZER
   // Adjust for redzone to find the true start of the allocation.
@@ -303,6 +378,27 @@ void rho::GCNodeAllocator::free(void* pointer) {
   }
 }
 
+std::size_t rho::GCNodeAllocator::allocationSize(const void* pointer) {
+  void* start = const_cast<void*>(pointer);
+#ifdef HAVE_ADDRESS_SANITIZER
+  start = offsetPointer(start, -s_redzone_size);
+#endif
+  uintptr_t pointer_uint = reinterpret_cast<uintptr_t>(start);
+  AllocatorSuperblock* superblock =
+      AllocatorSuperblock::arenaSuperblockFromPointer(pointer_uint);
+  if (superblock) {
+    return superblock->blockSize();
+  }
+  AllocationTable::Allocation* allocation = s_alloctable->search(pointer_uint);
+  if (!allocation) {
+    return 0;
+  }
+  if (allocation->isSuperblock()) {
+    return allocation->asSuperblock()->blockSize();
+  }
+  return std::size_t(1) << allocation->sizeLog2();
+}
+
 void rho::GCNodeAllocator::applyToAllAllocations(
     std::function<void(void*)> fun) {
 #ifdef HAVE_ADDRESS_SANITIZER
@@ -368,7 +464,7 @@ void rho::GCNodeAllocator::addToFreelist(FreeListNode* free_node,
     // freelist.  This is to avoid the memory cost of keeping large allocations
     // around.  This may be changed in the future so that the freelist is used
     // again for large objects.
-    delete[] free_node;
+    freeLargeBlock(free_node, sizeLog2FromSizeClass(size_class));
   } else {
     free_node->m_next = s_freelists[size_class];
     s_freelists[size_class] = free_node;
@@ -414,6 +510,16 @@ void rho::GCNodeAllocator::printSummary() {
   s_alloctable->printSummary();
 }
 
+void rho::GCNodeAllocator::freelistLengths(std::vector<std::size_t>* lengths) {
+  lengths->assign(s_num_small_pools + s_num_medium_pools, 0);
+  for (unsigned size_class = 0; size_class < lengths->size(); ++size_class) {
+    for (FreeListNode* node = s_freelists[size_class]; node;
+         node = node->m_next) {
+      ++(*lengths)[size_class];
+    }
+  }
+}
+
 #ifdef ALLOCATION_CHECK
 
 namespace {
@@ -538,3 +644,81 @@ void rho::GCNodeAllocator::clearQuarantineBySizeClass(int size_class) {
 
 #endif // HAVE_ADDRESS_SANITIZER
 
+void* rho::GCNodeAllocator::allocateHugePages(unsigned size_log2) {
+#ifdef HUGE_PAGES_SUPPORTED
+  // Over-allocate by one huge page so that the region can be aligned.
+  std::size_t bytes = std::size_t{1} << size_log2;
+  std::size_t huge_page = std::size_t{1} << s_huge_page_log2;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* map = mmap(nullptr, bytes + huge_page, PROT_READ | PROT_WRITE,
+                   flags, -1, 0);
+  if (map == MAP_FAILED) {
+    return nullptr;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(map);
+  uintptr_t aligned = (start + huge_page - 1) & ~(huge_page - 1);
+  if (aligned > start) {
+    munmap(map, aligned - start);
+  }
+  uintptr_t end = start + bytes + huge_page;
+  if (end > aligned + bytes) {
+    munmap(reinterpret_cast<void*>(aligned + bytes), end - aligned - bytes);
+  }
+  void* result = reinterpret_cast<void*>(aligned);
+  madvise(result, bytes, MADV_HUGEPAGE);
+  if (s_populate_huge_pages) {
+    // Pre-fault by touching each huge page.  (MAP_POPULATE would fault the
+    // pages in before the madvise() above, and so use small pages unless
+    // huge pages are enabled system-wide.)
+    volatile char* bytes_start = static_cast<char*>(result);
+    for (std::size_t offset = 0; offset < bytes; offset += huge_page) {
+      bytes_start[offset] = 0;
+    }
+  }
+  return result;
+#else
+  return nullptr;
+#endif
+}
+
+void* rho::GCNodeAllocator::allocateLargeBlock(unsigned size_log2) {
+  if (s_use_huge_pages && size_log2 >= s_huge_page_log2) {
+    void* result = allocateHugePages(size_log2);
+    if (!result) {
+      throw std::bad_alloc();
+    }
+    return result;
+  }
+  return new double[(std::size_t{1} << size_log2) / sizeof(double)];
+}
+
+void rho::GCNodeAllocator::freeLargeBlock(void* pointer, unsigned size_log2) {
+#ifdef HUGE_PAGES_SUPPORTED
+  if (s_use_huge_pages && size_log2 >= s_huge_page_log2) {
+    munmap(pointer, std::size_t{1} << size_log2);
+    return;
+  }
+#endif
+  delete[] static_cast<double*>(pointer);
+}
+
+std::size_t rho::GCNodeAllocator::releaseFreeMemory() {
+  std::size_t released = AllocatorSuperblock::releaseIdleSuperblocks(
+      s_release_min_idle_calls, s_release_retained_bytes);
+#ifdef __GLIBC__
+  // Large allocations are returned to malloc() when freed, but glibc may
+  // keep the memory in its heap.
+  malloc_trim(0);
+#endif
+  return released;
+}
+
+std::size_t rho::GCNodeAllocator::releasedBytes() {
+  return AllocatorSuperblock::releasedBytes();
+}
+
+void rho::GCNodeAllocator::setReleasePolicy(unsigned min_idle_calls,
+    std::size_t retained_bytes) {
+  s_release_min_idle_calls = min_idle_calls;
+  s_release_retained_bytes = retained_bytes;
+}
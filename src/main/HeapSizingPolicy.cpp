@@ -0,0 +1,156 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file HeapSizingPolicy.cpp
+ *
+ * Implementations of class rho::HeapSizingPolicy.
+ */
+
+#include "rho/HeapSizingPolicy.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+using namespace rho;
+
+// ***** Class GrowthHeapPolicy *****
+
+void GrowthHeapPolicy::adjustThresholds(const Collection& collection,
+					std::size_t min_threshold,
+					std::size_t* gclite_threshold,
+					std::size_t* threshold)
+{
+    std::size_t target = std::max(min_threshold,
+				  std::size_t(1.2*collection.bytes_after));
+    if (collection.full)
+	*threshold = std::max(std::size_t(0.8*double(*threshold)), target);
+    *gclite_threshold = std::max(std::size_t(0.8*double(*gclite_threshold)),
+				 target);
+}
+
+// ***** Class PauseTimeHeapPolicy *****
+
+PauseTimeHeapPolicy::PauseTimeHeapPolicy(double gc_fraction,
+					 double pause_goal)
+    : m_gc_fraction(gc_fraction), m_pause_goal(pause_goal),
+      m_mutator_seconds(0), m_bytes_after_full(0),
+      m_lite_seconds_per_byte(0)
+{}
+
+void PauseTimeHeapPolicy::adjustThresholds(const Collection& collection,
+					   std::size_t min_threshold,
+					   std::size_t* gclite_threshold,
+					   std::size_t* threshold)
+{
+    const double bytes_after = double(collection.bytes_after);
+    m_mutator_seconds += collection.mutator_seconds;
+
+    if (!collection.full
+	&& collection.bytes_before > collection.bytes_after) {
+	double per_byte = collection.gc_seconds
+	    /double(collection.bytes_before - collection.bytes_after);
+	m_lite_seconds_per_byte = (m_lite_seconds_per_byte == 0 ? per_byte
+				   : 0.75*m_lite_seconds_per_byte
+				     + 0.25*per_byte);
+    }
+
+    if (collection.full) {
+	// Allow the heap to grow for long enough that this
+	// collection's cost is the target fraction of the run time:
+	double headroom = 0.2*bytes_after;
+	if (m_mutator_seconds > 0
+	    && collection.bytes_before > m_bytes_after_full) {
+	    double rate = double(collection.bytes_before - m_bytes_after_full)
+		/m_mutator_seconds;
+	    double interval = collection.gc_seconds
+		*(1.0 - m_gc_fraction)/m_gc_fraction;
+	    headroom = std::min(std::max(rate*interval, 0.1*bytes_after),
+				4.0*bytes_after);
+	}
+	*threshold = std::max(min_threshold,
+			      std::size_t(bytes_after + headroom));
+	m_mutator_seconds = 0;
+	m_bytes_after_full = collection.bytes_after;
+    }
+
+    double lite_headroom = (m_lite_seconds_per_byte > 0
+			    ? m_pause_goal/m_lite_seconds_per_byte
+			    : 0.2*bytes_after);
+    // Computed in double to avoid overflow if lite_headroom is huge:
+    double lite = std::min(bytes_after + lite_headroom, double(*threshold));
+    *gclite_threshold = std::max(min_threshold, std::size_t(lite));
+}
+
+// ***** Class CeilingHeapPolicy *****
+
+CeilingHeapPolicy::CeilingHeapPolicy(std::size_t ceiling)
+    : m_ceiling(ceiling)
+{}
+
+void CeilingHeapPolicy::adjustThresholds(const Collection& collection,
+					 std::size_t min_threshold,
+					 std::size_t* gclite_threshold,
+					 std::size_t* threshold)
+{
+    m_growth.adjustThresholds(collection, min_threshold,
+			      gclite_threshold, threshold);
+
+    // The ceiling takes precedence over min_threshold.  A minimum
+    // headroom prevents a collection on every allocation once the
+    // ceiling is reached:
+    std::size_t after = collection.bytes_after;
+    std::size_t remaining = (m_ceiling > after ? m_ceiling - after : 0);
+    std::size_t cap = after + std::max(remaining/2, m_ceiling/64);
+    *gclite_threshold = std::min(*gclite_threshold, cap);
+    *threshold = std::min(*threshold, cap);
+    if (remaining < m_ceiling/10)
+	*threshold = after;
+}
+
+std::size_t CeilingHeapPolicy::controlGroupLimit()
+{
+    static const char* const files[] = {
+	"/sys/fs/cgroup/memory.max",  // Version 2
+	"/sys/fs/cgroup/memory/memory.limit_in_bytes"  // Version 1
+    };
+    for (const char* file : files) {
+	std::ifstream is(file);
+	std::string value;
+	if (!(is >> value))
+	    continue;
+	if (value == "max")
+	    return 0;
+	try {
+	    unsigned long long limit = std::stoull(value);
+	    // Version 1 reports an unlimited group as a number near
+	    // the maximum representable page count:
+	    if (limit >= (1ULL << 60))
+		return 0;
+	    return std::size_t(limit);
+	} catch (...) {
+	    return 0;
+	}
+    }
+    return 0;
+}
@@ -0,0 +1,467 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  https://www.R-project.org/Licenses/
+ */
+
+/** @file HeapSnapshot.cpp
+ *
+ * Implementation of class HeapSnapshot, and the heap.snapshot and
+ * heap.retainers builtins.
+ */
+
+#include "rho/HeapSnapshot.hpp"
+
+#include "Defn.h"
+#include "Internal.h"
+#include "rho/Environment.hpp"
+#include "rho/Frame.hpp"
+#include "rho/GCManager.hpp"
+#include "rho/GCNodeAllocator.hpp"
+#include "rho/GCRoot.hpp"
+#include "rho/GCStackRoot.hpp"
+#include "rho/ProtectStack.hpp"
+#include "rho/Symbol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+using namespace rho;
+
+namespace {
+    const char signature[8] = {'R', 'H', 'O', 'H', 'E', 'A', 'P', '1'};
+
+    typedef std::unordered_map<const GCNode*, std::uint32_t> NodeIndex;
+
+    // Visitor appending the indices of the nodes it visits to a
+    // vector:
+    class IndexCollector : public GCNode::const_visitor {
+    public:
+	IndexCollector(const NodeIndex* index, std::vector<std::uint32_t>* out)
+	    : m_index(index), m_out(out)
+	{}
+
+	void operator()(const GCNode* node) override
+	{
+	    NodeIndex::const_iterator it = m_index->find(node);
+	    if (it != m_index->end())
+		m_out->push_back(it->second);
+	}
+    private:
+	const NodeIndex* m_index;
+	std::vector<std::uint32_t>* m_out;
+    };
+
+    std::string environmentName(Environment* env)
+    {
+	if (env == Environment::global())
+	    return "R_GlobalEnv";
+	if (env == Environment::base())
+	    return "package:base";
+	if (env == Environment::baseNamespace())
+	    return "namespace:base";
+	if (env == Environment::empty())
+	    return "R_EmptyEnv";
+	if (R_IsPackageEnv(env))
+	    return translateChar(STRING_ELT(R_PackageEnvName(env), 0));
+	if (R_IsNamespaceEnv(env))
+	    return std::string("namespace:")
+		+ translateChar(STRING_ELT(R_NamespaceEnvSpec(env), 0));
+	return std::string();
+    }
+
+    struct FileCloser {
+	void operator()(std::FILE* file) const
+	{
+	    std::fclose(file);
+	}
+    };
+    typedef std::unique_ptr<std::FILE, FileCloser> FilePtr;
+
+    template <typename T>
+    void writeArray(std::FILE* file, const std::vector<T>& v)
+    {
+	if (!v.empty())
+	    std::fwrite(v.data(), sizeof(T), v.size(), file);
+    }
+
+    template <typename T>
+    void readArray(std::FILE* file, std::vector<T>* v, std::uint64_t n,
+		   const char* path)
+    {
+	v->resize(n);
+	if (n != 0 && std::fread(v->data(), sizeof(T), n, file) != n)
+	    Rf_error(_("'%s' is truncated"), path);
+    }
+}
+
+HeapSnapshot::HeapSnapshot()
+{
+    GCManager::GCInhibitor inhibitor;
+
+    std::vector<const GCNode*> nodes;
+    GCNodeAllocator::applyToAllAllocations([&](void* pointer) {
+	    nodes.push_back(static_cast<GCNode*>(pointer));
+	});
+    NodeIndex index(nodes.size());
+    for (std::uint32_t i = 0; i < nodes.size(); ++i)
+	index[nodes[i]] = i;
+
+    m_types.reserve(nodes.size());
+    m_sizes.reserve(nodes.size());
+    m_edge_offsets.reserve(nodes.size() + 1);
+    IndexCollector edges(&index, &m_edges);
+    for (const GCNode* node : nodes) {
+	const RObject* robj = dynamic_cast<const RObject*>(node);
+	m_types.push_back(robj ? (unsigned char)(robj->sexptype())
+			  : s_internal_type);
+	m_sizes.push_back(GCNodeAllocator::allocationSize(node));
+	m_edge_offsets.push_back(m_edges.size());
+	node->visitReferents(&edges);
+    }
+    m_edge_offsets.push_back(m_edges.size());
+
+    // The roots visited by GCNode::mark().  GCStackRootBase::visitRoots()
+    // is the conservative scan of the C stack and registers, so nodes
+    // it finds are roots even if the words pointing to them are stale.
+    IndexCollector roots(&index, &m_roots);
+    GCRootBase::visitRoots(&roots);
+    GCStackRootBase::visitRoots(&roots);
+    ProtectStack::visitRoots(&roots);
+    if (R_Srcref)
+	roots(R_Srcref);
+    std::sort(m_roots.begin(), m_roots.end());
+    m_roots.erase(std::unique(m_roots.begin(), m_roots.end()),
+		  m_roots.end());
+
+    // Label named environments, and then the values bound in frames
+    // that are not otherwise labelled:
+    std::vector<bool> labelled(nodes.size());
+    std::vector<const Environment*> environments;
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+	if (m_types[i] != ENVSXP)
+	    continue;
+	const Environment* env = dynamic_cast<const Environment*>(nodes[i]);
+	if (!env)
+	    continue;
+	environments.push_back(env);
+	std::string name = environmentName(const_cast<Environment*>(env));
+	if (!name.empty()) {
+	    m_labels.emplace_back(i, name);
+	    labelled[i] = true;
+	}
+    }
+    for (const Environment* env : environments) {
+	const Frame* frame = env->frame();
+	if (!frame)
+	    continue;
+	frame->visitBindings([&](const Frame::Binding* binding) {
+		NodeIndex::const_iterator it = index.find(binding->rawValue());
+		if (it != index.end() && !labelled[it->second]) {
+		    m_labels.emplace_back(it->second,
+					  binding->symbol()->name()->stdstring());
+		    labelled[it->second] = true;
+		}
+	    });
+    }
+}
+
+void HeapSnapshot::dominators(std::vector<std::uint32_t>* idom,
+			      std::vector<std::uint32_t>* order) const
+{
+    // This is the iterative algorithm of Cooper, Harvey and Kennedy,
+    // "A Simple, Fast Dominance Algorithm" (2001).
+    const std::uint32_t n = std::uint32_t(numNodes());
+    const std::uint32_t root = n;
+    const std::uint32_t undefined = std::uint32_t(-1);
+    auto successors = [&](std::uint32_t node) {
+	return (node == root
+		? std::make_pair(m_roots.data(), m_roots.data() + m_roots.size())
+		: std::make_pair(m_edges.data() + m_edge_offsets[node],
+				 m_edges.data() + m_edge_offsets[node + 1]));
+    };
+
+    // Depth-first search from the virtual root, numbering the nodes
+    // in postorder:
+    std::vector<std::uint32_t> postorder_number(n + 1, undefined);
+    std::vector<std::uint32_t> postorder;
+    {
+	std::vector<bool> visited(n + 1);
+	std::vector<std::pair<std::uint32_t, const std::uint32_t*> > stack;
+	visited[root] = true;
+	stack.emplace_back(root, successors(root).first);
+	while (!stack.empty()) {
+	    std::uint32_t node = stack.back().first;
+	    const std::uint32_t*& next = stack.back().second;
+	    if (next != successors(node).second) {
+		std::uint32_t succ = *next++;
+		if (!visited[succ]) {
+		    visited[succ] = true;
+		    stack.emplace_back(succ, successors(succ).first);
+		}
+	    } else {
+		postorder_number[node] = std::uint32_t(postorder.size());
+		postorder.push_back(node);
+		stack.pop_back();
+	    }
+	}
+    }
+
+    // Predecessors of each reachable node:
+    std::vector<std::uint64_t> pred_offsets(n + 2, 0);
+    for (std::uint32_t node : postorder) {
+	auto succs = successors(node);
+	for (const std::uint32_t* s = succs.first; s != succs.second; ++s)
+	    ++pred_offsets[*s + 1];
+    }
+    for (std::uint32_t i = 0; i <= n; ++i)
+	pred_offsets[i + 1] += pred_offsets[i];
+    std::vector<std::uint32_t> preds(pred_offsets[n + 1]);
+    {
+	std::vector<std::uint64_t> fill(pred_offsets.begin(),
+					pred_offsets.end() - 1);
+	for (std::uint32_t node : postorder) {
+	    auto succs = successors(node);
+	    for (const std::uint32_t* s = succs.first; s != succs.second; ++s)
+		preds[fill[*s]++] = node;
+	}
+    }
+
+    idom->assign(n + 1, undefined);
+    (*idom)[root] = root;
+    auto intersect = [&](std::uint32_t a, std::uint32_t b) {
+	while (a != b) {
+	    while (postorder_number[a] < postorder_number[b])
+		a = (*idom)[a];
+	    while (postorder_number[b] < postorder_number[a])
+		b = (*idom)[b];
+	}
+	return a;
+    };
+    bool changed = true;
+    while (changed) {
+	changed = false;
+	// Reverse postorder, skipping the root (which comes last in
+	// postorder):
+	for (std::size_t k = postorder.size() - 1; k-- > 0; ) {
+	    std::uint32_t node = postorder[k];
+	    std::uint32_t new_idom = undefined;
+	    for (std::uint64_t p = pred_offsets[node];
+		 p < pred_offsets[node + 1]; ++p) {
+		std::uint32_t pred = preds[p];
+		if ((*idom)[pred] == undefined)
+		    continue;
+		new_idom = (new_idom == undefined ? pred
+			    : intersect(pred, new_idom));
+	    }
+	    if ((*idom)[node] != new_idom) {
+		(*idom)[node] = new_idom;
+		changed = true;
+	    }
+	}
+    }
+    order->assign(postorder.rbegin(), postorder.rend());
+}
+
+std::vector<HeapSnapshot::Retainer>
+HeapSnapshot::retainers(std::size_t max_count) const
+{
+    const std::uint32_t n = std::uint32_t(numNodes());
+    std::vector<std::uint32_t> idom, order;
+    dominators(&idom, &order);
+
+    // Accumulate retained sizes up the dominator tree, children
+    // before their dominators:
+    std::vector<std::uint64_t> retained(n + 1, 0);
+    for (std::size_t k = order.size(); k-- > 0; ) {
+	std::uint32_t node = order[k];
+	if (node == n)
+	    continue;
+	retained[node] += m_sizes[node];
+	retained[idom[node]] += retained[node];
+    }
+
+    std::vector<std::uint32_t> candidates;
+    for (std::uint32_t node : order)
+	if (node != n)
+	    candidates.push_back(node);
+    std::size_t count = std::min(max_count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count,
+		      candidates.end(),
+		      [&](std::uint32_t a, std::uint32_t b) {
+			  return retained[a] > retained[b];
+		      });
+
+    std::unordered_map<std::uint32_t, const std::string*> labels;
+    for (const auto& label : m_labels)
+	labels[label.first] = &label.second;
+
+    std::vector<Retainer> ans;
+    for (std::size_t i = 0; i < count; ++i) {
+	std::uint32_t node = candidates[i];
+	std::vector<const std::string*> path;
+	for (std::uint32_t v = node; v != n; v = idom[v]) {
+	    auto it = labels.find(v);
+	    if (it != labels.end())
+		path.push_back(it->second);
+	}
+	Retainer retainer;
+	retainer.node = node;
+	retainer.type = m_types[node];
+	retainer.size = m_sizes[node];
+	retainer.retained = retained[node];
+	for (auto it = path.rbegin(); it != path.rend(); ++it) {
+	    if (!retainer.path.empty())
+		retainer.path += '$';
+	    retainer.path += **it;
+	}
+	ans.push_back(std::move(retainer));
+    }
+    return ans;
+}
+
+std::uint64_t HeapSnapshot::totalSize() const
+{
+    std::uint64_t total = 0;
+    for (std::uint64_t size : m_sizes)
+	total += size;
+    return total;
+}
+
+void HeapSnapshot::write(const char* path) const
+{
+    FilePtr file(std::fopen(path, "wb"));
+    if (!file)
+	Rf_error(_("cannot open file '%s': %s"), path, strerror(errno));
+    const std::uint64_t counts[] = {
+	numNodes(), numEdges(), m_roots.size(), m_labels.size()
+    };
+    std::fwrite(signature, 1, sizeof(signature), file.get());
+    std::fwrite(counts, sizeof(std::uint64_t), 4, file.get());
+    writeArray(file.get(), m_types);
+    writeArray(file.get(), m_sizes);
+    writeArray(file.get(), m_edge_offsets);
+    writeArray(file.get(), m_edges);
+    writeArray(file.get(), m_roots);
+    for (const auto& label : m_labels) {
+	const std::uint32_t header[] = {
+	    label.first, std::uint32_t(label.second.size())
+	};
+	std::fwrite(header, sizeof(std::uint32_t), 2, file.get());
+	std::fwrite(label.second.data(), 1, label.second.size(), file.get());
+    }
+    if (std::ferror(file.get()))
+	Rf_error(_("error writing to file '%s'"), path);
+}
+
+HeapSnapshot HeapSnapshot::read(const char* path)
+{
+    FilePtr file(std::fopen(path, "rb"));
+    if (!file)
+	Rf_error(_("cannot open file '%s': %s"), path, strerror(errno));
+    char sig[sizeof(signature)];
+    std::uint64_t counts[4];
+    if (std::fread(sig, 1, sizeof(sig), file.get()) != sizeof(sig)
+	|| std::memcmp(sig, signature, sizeof(sig)) != 0
+	|| std::fread(counts, sizeof(std::uint64_t), 4, file.get()) != 4
+	|| counts[0] >= std::uint32_t(-1))
+	Rf_error(_("'%s' is not a heap snapshot"), path);
+
+    HeapSnapshot ans{Empty()};
+    readArray(file.get(), &ans.m_types, counts[0], path);
+    readArray(file.get(), &ans.m_sizes, counts[0], path);
+    readArray(file.get(), &ans.m_edge_offsets, counts[0] + 1, path);
+    readArray(file.get(), &ans.m_edges, counts[1], path);
+    readArray(file.get(), &ans.m_roots, counts[2], path);
+    if (ans.m_edge_offsets.back() != counts[1])
+	Rf_error(_("'%s' is not a heap snapshot"), path);
+    for (std::uint32_t edge : ans.m_edges)
+	if (edge >= counts[0])
+	    Rf_error(_("'%s' is not a heap snapshot"), path);
+    for (std::uint32_t root : ans.m_roots)
+	if (root >= counts[0])
+	    Rf_error(_("'%s' is not a heap snapshot"), path);
+    for (std::uint64_t i = 0; i < counts[3]; ++i) {
+	std::uint32_t header[2];
+	if (std::fread(header, sizeof(std::uint32_t), 2, file.get()) != 2)
+	    Rf_error(_("'%s' is truncated"), path);
+	std::string label(header[1], '\0');
+	if (header[1] != 0
+	    && std::fread(&label[0], 1, header[1], file.get()) != header[1])
+	    Rf_error(_("'%s' is truncated"), path);
+	ans.m_labels.emplace_back(header[0], std::move(label));
+    }
+    return ans;
+}
+
+// ***** Builtins *****
+
+/* .Internal(heap.snapshot(file)) */
+SEXP attribute_hidden do_heapsnapshot(/*const*/ Expression* call, const BuiltInFunction* op, RObject* file_)
+{
+    if (!isString(file_) || LENGTH(file_) != 1 || STRING_ELT(file_, 0) == NA_STRING)
+	error(_("invalid '%s' argument"), "file");
+    const char* path = R_ExpandFileName(translateChar(STRING_ELT(file_, 0)));
+    GCManager::gc();
+    HeapSnapshot snapshot;
+    snapshot.write(path);
+
+    static const char* names[] = {"nodes", "edges", "bytes", ""};
+    GCStackRoot<> ans(mkNamed(REALSXP, names));
+    REAL(ans)[0] = double(snapshot.numNodes());
+    REAL(ans)[1] = double(snapshot.numEdges());
+    REAL(ans)[2] = double(snapshot.totalSize());
+    return ans;
+}
+
+/* .Internal(heap.retainers(file, n)) */
+SEXP attribute_hidden do_heapretainers(/*const*/ Expression* call, const BuiltInFunction* op, RObject* file_, RObject* n_)
+{
+    if (!isString(file_) || LENGTH(file_) != 1 || STRING_ELT(file_, 0) == NA_STRING)
+	error(_("invalid '%s' argument"), "file");
+    int n = asInteger(n_);
+    if (n == NA_INTEGER || n < 0)
+	error(_("invalid '%s' argument"), "n");
+    const char* path = R_ExpandFileName(translateChar(STRING_ELT(file_, 0)));
+    std::vector<HeapSnapshot::Retainer> retainers
+	= HeapSnapshot::read(path).retainers(std::size_t(n));
+
+    static const char* names[] = {"type", "size", "retained", "path", ""};
+    int len = int(retainers.size());
+    GCStackRoot<> ans(mkNamed(VECSXP, names));
+    SET_VECTOR_ELT(ans, 0, allocVector(STRSXP, len));
+    SET_VECTOR_ELT(ans, 1, allocVector(REALSXP, len));
+    SET_VECTOR_ELT(ans, 2, allocVector(REALSXP, len));
+    SET_VECTOR_ELT(ans, 3, allocVector(STRSXP, len));
+    for (int i = 0; i < len; ++i) {
+	const HeapSnapshot::Retainer& r = retainers[i];
+	SET_STRING_ELT(VECTOR_ELT(ans, 0), i,
+		       mkChar(r.type == HeapSnapshot::s_internal_type
+			      ? "internal" : type2char(SEXPTYPE(r.type))));
+	REAL(VECTOR_ELT(ans, 1))[i] = double(r.size);
+	REAL(VECTOR_ELT(ans, 2))[i] = double(r.retained);
+	SET_STRING_ELT(VECTOR_ELT(ans, 3), i, mkChar(r.path.c_str()));
+    }
+    return ans;
+}
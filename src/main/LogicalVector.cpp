@@ -47,3 +47,18 @@ namespace rho {
 	return "logical";
     }
 }
+
+void rho::countLogicals(const Logical* begin, const Logical* end,
+			std::size_t* ntrue, std::size_t* nna)
+{
+    // Logical is layout-compatible with int (see Logical.hpp):
+    const int* p = reinterpret_cast<const int*>(begin);
+    const int* pend = reinterpret_cast<const int*>(end);
+    std::size_t t = 0, na = 0;
+    for (; p != pend; ++p) {
+	t += (*p == TRUE);
+	na += (*p == NA_LOGICAL);
+    }
+    *ntrue = t;
+    *nna = na;
+}
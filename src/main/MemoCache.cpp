@@ -0,0 +1,362 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2016 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+/** @file MemoCache.cpp
+ *
+ * Implementation of class MemoCache, and the memoCache, memoKey,
+ * memoGet, memoPut, memoCacheInfo and memoCacheClear builtins.
+ */
+
+#include "rho/MemoCache.hpp"
+
+#include "Defn.h"
+#include "Fileio.h"
+#include "Internal.h"
+#include "rho/ContentHash.hpp"
+#include "rho/GCStackRoot.hpp"
+
+#include <cctype>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+using namespace rho;
+
+namespace {
+    // Nominal bytes occupied by an object apart from its data:
+    const std::size_t header_bytes = 48;
+
+    struct FileCloser {
+	void operator()(FILE* fp) const
+	{
+	    std::fclose(fp);
+	}
+    };
+    typedef std::unique_ptr<FILE, FileCloser> FilePtr;
+}
+
+MemoCache::MemoCache(std::size_t budget, const std::string& directory,
+		     RObject* owner)
+    : m_budget(budget), m_directory(directory), m_owner(owner),
+      m_next_slot(0), m_bytes(0), m_hits(0), m_disk_hits(0), m_misses(0)
+{}
+
+void MemoCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_free_slots.clear();
+    m_next_slot = 0;
+    R_SetExternalPtrProtected(m_owner, R_NilValue);
+    m_bytes = 0;
+}
+
+RObject* MemoCache::values() const
+{
+    return R_ExternalPtrProtected(m_owner);
+}
+
+std::size_t MemoCache::newSlot(RObject* value)
+{
+    std::size_t slot;
+    if (!m_free_slots.empty()) {
+	slot = m_free_slots.back();
+	m_free_slots.pop_back();
+    } else {
+	slot = m_next_slot++;
+	RObject* old = values();
+	std::size_t length = (old == R_NilValue ? 0 : XLENGTH(old));
+	if (slot >= length) {
+	    GCStackRoot<> grown(allocVector(VECSXP,
+					    std::max<std::size_t>(16, 2*length)));
+	    for (std::size_t i = 0; i < length; ++i)
+		SET_VECTOR_ELT(grown, i, VECTOR_ELT(old, i));
+	    R_SetExternalPtrProtected(m_owner, grown);
+	}
+    }
+    SET_VECTOR_ELT(values(), slot, value);
+    return slot;
+}
+
+void MemoCache::discard(EntryList::iterator it)
+{
+    m_bytes -= it->bytes;
+    SET_VECTOR_ELT(values(), it->slot, R_NilValue);
+    m_free_slots.push_back(it->slot);
+    m_index.erase(it->key);
+    m_entries.erase(it);
+}
+
+void MemoCache::hold(const std::string& key, RObject* value)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+	discard(it->second);
+    std::size_t bytes = objectBytes(value);
+    if (bytes > m_budget)
+	return;
+    // The value is now shared with the cache:
+    SET_NAMED(value, NAMEDMAX);
+    m_entries.push_front(Entry{key, newSlot(value), bytes});
+    m_index[key] = m_entries.begin();
+    m_bytes += bytes;
+    while (m_bytes > m_budget)
+	discard(std::prev(m_entries.end()));
+}
+
+RObject* MemoCache::lookup(const std::string& key, bool* found)
+{
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	++m_hits;
+	*found = true;
+	return VECTOR_ELT(values(), it->second->slot);
+    }
+    if (!m_directory.empty()) {
+	GCStackRoot<> value(readFile(key, found));
+	if (*found) {
+	    ++m_disk_hits;
+	    hold(key, value);
+	    return value;
+	}
+    }
+    ++m_misses;
+    *found = false;
+    return nullptr;
+}
+
+void MemoCache::store(const std::string& key, RObject* value)
+{
+    hold(key, value);
+    if (!m_directory.empty())
+	writeFile(key, value);
+}
+
+std::size_t MemoCache::objectBytes(const RObject* object)
+{
+    RObject* x = const_cast<RObject*>(object);
+    std::size_t ans = 0;
+    switch (TYPEOF(x)) {
+    case NILSXP:
+    case ENVSXP:
+	return 0;
+    case LGLSXP:
+    case INTSXP:
+	ans = std::size_t(XLENGTH(x)) * sizeof(int);
+	break;
+    case REALSXP:
+	ans = std::size_t(XLENGTH(x)) * sizeof(double);
+	break;
+    case CPLXSXP:
+	ans = std::size_t(XLENGTH(x)) * sizeof(Rcomplex);
+	break;
+    case RAWSXP:
+	ans = std::size_t(XLENGTH(x));
+	break;
+    case STRSXP:
+	ans = std::size_t(XLENGTH(x)) * sizeof(SEXP);
+	for (R_xlen_t i = 0; i < XLENGTH(x); ++i)
+	    ans += std::size_t(LENGTH(STRING_ELT(x, i)));
+	break;
+    case VECSXP:
+    case EXPRSXP:
+	ans = std::size_t(XLENGTH(x)) * sizeof(SEXP);
+	for (R_xlen_t i = 0; i < XLENGTH(x); ++i)
+	    ans += objectBytes(VECTOR_ELT(x, i));
+	break;
+    case LISTSXP:
+    case LANGSXP:
+	for (; x != R_NilValue; x = CDR(x))
+	    ans += header_bytes + objectBytes(CAR(x)) + objectBytes(ATTRIB(x));
+	return ans;
+    default:
+	break;
+    }
+    return ans + header_bytes + objectBytes(ATTRIB(x));
+}
+
+std::string MemoCache::path(const std::string& key) const
+{
+    return m_directory + "/" + key + ".rds";
+}
+
+RObject* MemoCache::readFile(const std::string& key, bool* found) const
+{
+    FilePtr fp(R_fopen(path(key).c_str(), "rb"));
+    *found = bool(fp);
+    if (!fp)
+	return nullptr;
+    R_inpstream_st stream;
+    R_InitFileInPStream(&stream, fp.get(), R_pstream_any_format,
+			nullptr, R_NilValue);
+    return R_Unserialize(&stream);
+}
+
+// Values are written to a temporary file which is then renamed, so
+// that other sessions sharing the directory never see part of a file.
+void MemoCache::writeFile(const std::string& key, RObject* value) const
+{
+    std::string file = path(key), tmp = file + ".tmp";
+#ifdef HAVE_UNISTD_H
+    tmp += std::to_string(getpid());
+#endif
+    bool ok;
+    {
+	FilePtr fp(R_fopen(tmp.c_str(), "wb"));
+	if (!fp) {
+	    warning(_("cannot write to memoisation cache directory '%s'"),
+		    m_directory.c_str());
+	    return;
+	}
+	R_outpstream_st stream;
+	R_InitFileOutPStream(&stream, fp.get(), R_pstream_xdr_format, 0,
+			     nullptr, R_NilValue);
+	R_Serialize(value, &stream);
+	ok = (std::fflush(fp.get()) == 0 && !std::ferror(fp.get()));
+    }
+    if (!ok || std::rename(tmp.c_str(), file.c_str()) != 0) {
+	std::remove(tmp.c_str());
+	warning(_("cannot write to memoisation cache directory '%s'"),
+		m_directory.c_str());
+    }
+}
+
+// ***** Builtins *****
+
+static void memoCacheFinalizer(SEXP ptr)
+{
+    delete static_cast<MemoCache*>(R_ExternalPtrAddr(ptr));
+    R_ClearExternalPtr(ptr);
+}
+
+static MemoCache* memoCache(RObject* cache)
+{
+    if (TYPEOF(cache) != EXTPTRSXP || !inherits(cache, "memoCache"))
+	error(_("invalid '%s' argument"), "cache");
+    MemoCache* ans = static_cast<MemoCache*>(R_ExternalPtrAddr(cache));
+    if (!ans)
+	error(_("memoisation cache is no longer valid"));
+    return ans;
+}
+
+// Keys are used as file names, so are checked to be as memoKey
+// makes them.
+static std::string memoKey(RObject* key)
+{
+    if (!isString(key) || LENGTH(key) != 1 || STRING_ELT(key, 0) == NA_STRING)
+	error(_("invalid '%s' argument"), "key");
+    std::string ans = CHAR(STRING_ELT(key, 0));
+    bool ok = (ans.size() == 32);
+    for (char c : ans)
+	ok = ok && std::isxdigit(static_cast<unsigned char>(c));
+    if (!ok)
+	error(_("invalid '%s' argument"), "key");
+    return ans;
+}
+
+/* .Internal(memoCache(budget, dir)) */
+SEXP attribute_hidden do_memocache(/*const*/ Expression* call, const BuiltInFunction* op, RObject* budget_, RObject* dir_)
+{
+    double budget = asReal(budget_);
+    if (!R_FINITE(budget) || budget < 0)
+	error(_("invalid '%s' argument"), "budget");
+    std::string dir;
+    if (dir_ != R_NilValue) {
+	if (!isString(dir_) || LENGTH(dir_) != 1
+	    || STRING_ELT(dir_, 0) == NA_STRING)
+	    error(_("invalid '%s' argument"), "dir");
+	dir = R_ExpandFileName(translateChar(STRING_ELT(dir_, 0)));
+    }
+    GCStackRoot<> ans(R_MakeExternalPtr(nullptr, install("memoCache"),
+					R_NilValue));
+    R_SetExternalPtrAddr(ans, new MemoCache(std::size_t(budget), dir, ans));
+    R_RegisterCFinalizerEx(ans, memoCacheFinalizer, TRUE);
+    GCStackRoot<> klass(mkString("memoCache"));
+    classgets(ans, klass);
+    return ans;
+}
+
+/* .Internal(memoKey(fkey, args)) */
+SEXP attribute_hidden do_memokey(/*const*/ Expression* call, const BuiltInFunction* op, RObject* fkey_, RObject* args_)
+{
+    if (TYPEOF(args_) != VECSXP)
+	error(_("invalid '%s' argument"), "args");
+    ContentHash hash;
+    hash.update(fkey_);
+    hash.update(getAttrib(args_, R_NamesSymbol));
+    for (R_xlen_t i = 0; i < XLENGTH(args_); ++i)
+	hash.update(VECTOR_ELT(args_, i));
+    return mkString(hash.digest().hex().c_str());
+}
+
+/* .Internal(memoGet(cache, key)): list(value) if found, else NULL */
+SEXP attribute_hidden do_memoget(/*const*/ Expression* call, const BuiltInFunction* op, RObject* cache_, RObject* key_)
+{
+    MemoCache* cache = memoCache(cache_);
+    bool found;
+    GCStackRoot<> value(cache->lookup(memoKey(key_), &found));
+    if (!found)
+	return R_NilValue;
+    SEXP ans = allocVector(VECSXP, 1);
+    SET_VECTOR_ELT(ans, 0, value);
+    return ans;
+}
+
+/* .Internal(memoPut(cache, key, value)) */
+SEXP attribute_hidden do_memoput(/*const*/ Expression* call, const BuiltInFunction* op, RObject* cache_, RObject* key_, RObject* value_)
+{
+    MemoCache* cache = memoCache(cache_);
+    cache->store(memoKey(key_), value_);
+    return R_NilValue;
+}
+
+/* .Internal(memoCacheInfo(cache)) */
+SEXP attribute_hidden do_memocacheinfo(/*const*/ Expression* call, const BuiltInFunction* op, RObject* cache_)
+{
+    MemoCache* cache = memoCache(cache_);
+    static const char* names[] = {"entries", "bytes", "budget", "hits",
+				  "diskHits", "misses", "dir", ""};
+    GCStackRoot<> ans(mkNamed(VECSXP, names));
+    SET_VECTOR_ELT(ans, 0, ScalarReal(double(cache->size())));
+    SET_VECTOR_ELT(ans, 1, ScalarReal(double(cache->bytes())));
+    SET_VECTOR_ELT(ans, 2, ScalarReal(double(cache->budget())));
+    SET_VECTOR_ELT(ans, 3, ScalarReal(double(cache->hits())));
+    SET_VECTOR_ELT(ans, 4, ScalarReal(double(cache->diskHits())));
+    SET_VECTOR_ELT(ans, 5, ScalarReal(double(cache->misses())));
+    SET_VECTOR_ELT(ans, 6, cache->directory().empty() ? R_NilValue
+		   : mkString(cache->directory().c_str()));
+    return ans;
+}
+
+/* .Internal(memoCacheClear(cache)) */
+SEXP attribute_hidden do_memocacheclear(/*const*/ Expression* call, const BuiltInFunction* op, RObject* cache_)
+{
+    memoCache(cache_)->clear();
+    return R_NilValue;
+}
@@ -148,15 +148,17 @@ void MemoryBank::initialize()
     s_pools[9].initialize(24, 21);
 }
 
-void MemoryBank::notifyAllocation(size_t bytes)
+void MemoryBank::notifyAllocation(size_t bytes, size_t count)
 {
 #ifdef R_MEMORY_PROFILING
-    if (s_monitor && bytes >= s_monitor_threshold) s_monitor(bytes);
+    if (s_monitor && bytes >= s_monitor_threshold)
+	for (size_t i = 0; i < count; ++i)
+	    s_monitor(bytes);
 #endif
-    ++s_blocks_allocated;
-    s_bytes_allocated += bytes;
+    s_blocks_allocated += count;
+    s_bytes_allocated += bytes*count;
 #ifdef ALLOC_STATS
-    alloc_counts[get_bin_number(bytes)] += 1;
+    alloc_counts[get_bin_number(bytes)] += count;
 #endif
 }
 
@@ -30,7 +30,9 @@
 #include "rho/NodeStack.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <stdexcept>
 
 using namespace rho;
@@ -46,36 +48,63 @@ void NodeStack::Scope::nestingError()
 NodeStack::NodeStack(size_t initial_capacity)
     : m_protected_count(0), m_innermost_scope(0)
 {
-    m_vector.reserve(initial_capacity);
+    m_region.base = m_region.top = m_region.limit = m_region.floor = nullptr;
+    grow(std::max(initial_capacity, size_t(1)));
+}
+
+NodeStack::~NodeStack()
+{
+    resize(0);
+    delete [] m_region.base;
 }
 
 void NodeStack::eraseTopmost(RObject* node)
 {
 #ifndef NDEBUG
     if (m_innermost_scope
-	&& m_vector.size() == m_innermost_scope->startSize())
+	&& size() == m_innermost_scope->startSize())
 	throw std::logic_error("NodeStack::eraseTopmost(): "
 			       "too many pops in this scope.");
 #endif
-    std::vector<RObject*>::reverse_iterator rit
-	= find(m_vector.rbegin(), m_vector.rend(), node);
-    if (rit == m_vector.rend())
+    RObject** begin = m_region.base;
+    RObject** it = m_region.top;
+    while (it != begin && *(it - 1) != node)
+	--it;
+    if (it == begin)
 	throw std::invalid_argument("NodeStack::unprotectPtr:"
 				    " pointer not found.");
-    // See Josuttis p.267 for the need for -1 :
-    std::vector<RObject*>::iterator it = rit.base() - 1;
-    if (it - m_vector.begin() < int(m_protected_count)) {
+    --it;
+    if (it - begin < std::ptrdiff_t(m_protected_count)) {
 	GCNode::decRefCount(node);
 	--m_protected_count;
     }
-    m_vector.erase(it);
+    std::copy(it + 1, m_region.top, it);
+    --m_region.top;
+    setFloor();
+}
+
+void NodeStack::grow(size_t min_capacity)
+{
+    size_t capacity = size_t(m_region.limit - m_region.base);
+    if (min_capacity <= capacity)
+	return;
+    size_t new_capacity = std::max(min_capacity, 2*capacity);
+    RObject** storage = new RObject*[new_capacity];
+    size_t sz = size();
+    if (sz > 0)
+	std::memcpy(storage, m_region.base, sz*sizeof(RObject*));
+    delete [] m_region.base;
+    m_region.base = storage;
+    m_region.top = storage + sz;
+    m_region.limit = storage + new_capacity;
+    setFloor();
 }
 
 // Foll. is inlined under NDEBUG:
 #ifndef NDEBUG
 void NodeStack::pop(unsigned int count)
 {
-    size_t sz = m_vector.size();
+    size_t sz = size();
     if (count > sz)
 	throw std::out_of_range("NodeStack::pop(): count greater"
 				" than current stack size.");
@@ -88,24 +117,23 @@ void NodeStack::pop(unsigned int count)
 
 void NodeStack::protectAll()
 {
-    std::vector<RObject*>::iterator start
-	= m_vector.begin() + std::ptrdiff_t(m_protected_count);
-    std::vector<RObject*>::iterator end = m_vector.end();
-    for (std::vector<RObject*>::iterator it = start; it != end; ++it)
+    for (RObject** it = m_region.base + m_protected_count;
+	 it != m_region.top; ++it)
 	GCNode::incRefCount(*it);
-    m_protected_count = m_vector.size();
+    m_protected_count = size();
+    setFloor();
 }
 
 // Foll. is inlined under NDEBUG:
 #ifndef NDEBUG
 void NodeStack::retarget(RObject* node, size_t index)
 {
-    if (index >= m_vector.size())
+    if (index >= size())
 	throw std::out_of_range("NodeStack::retarget():"
 				" index out of range.");
     if (index < m_protected_count)
-	retarget_aux(m_vector[index], node);
-    m_vector[index] = node;
+	retarget_aux(m_region.base[index], node);
+    m_region.base[index] = node;
 }
 #else
 namespace rho {
@@ -124,20 +152,33 @@ void NodeStack::retarget_aux(RObject* oldnode, RObject* newnode)
 
 void NodeStack::resize_aux(size_t new_size)
 {
-    m_vector.resize(m_protected_count);
-    while (m_vector.size() > new_size) {
-	RObject* node = m_vector.back();
-	GCNode::decRefCount(node);
-	m_vector.pop_back();
+    size_t sz = size();
+    if (new_size > sz) {
+	grow(new_size);
+	std::fill(m_region.top, m_region.base + new_size, nullptr);
+    } else if (new_size < m_protected_count) {
+	for (RObject** it = m_region.base + m_protected_count;
+	     it != m_region.base + new_size; )
+	    GCNode::decRefCount(*--it);
+	m_protected_count = new_size;
     }
-    m_protected_count = new_size;
+    m_region.top = m_region.base + new_size;
+    setFloor();
+}
+
+void NodeStack::setFloor()
+{
+    size_t floor = m_protected_count;
+#ifndef NDEBUG
+    if (m_innermost_scope)
+	floor = std::max(floor, m_innermost_scope->startSize());
+#endif
+    m_region.floor = m_region.base + floor;
 }
 
 void NodeStack::visitRoots(GCNode::const_visitor* v)
 {
-    std::vector<RObject*>::iterator vecend = m_vector.end();
-    for (std::vector<RObject*>::iterator it = m_vector.begin();
-	 it != vecend; ++it) {
+    for (RObject** it = m_region.base; it != m_region.top; ++it) {
 	RObject* n = *it;
 	if (n)
 	    (*v)(n);
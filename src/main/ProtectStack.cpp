@@ -49,9 +49,12 @@ namespace rho {
 
 NodeStack* ProtectStack::s_stack = nullptr;
 
+R_StackRegion* R_PPStackRegion = nullptr;
+
 void ProtectStack::initialize()
 {
     s_stack = new NodeStack(64);
+    R_PPStackRegion = s_stack->region();
 }
 
 void ProtectStack::restoreSize(size_t new_size)
@@ -57,17 +57,17 @@ SEXP R_BlankString = nullptr;
 // String::Comparator::operator()(const String*, const String*) is in
 // sort.cpp
 
-String::String(char* character_storage,
-	       const std::string& text, cetype_t encoding, bool isAscii)
-    : VectorBase(CHARSXP, text.size()),
+String::String(char* character_storage, const char* text,
+	       std::size_t length, cetype_t encoding, bool isAscii)
+    : VectorBase(CHARSXP, length),
       m_key_val_pr(nullptr),
       m_data(character_storage),
       m_symbol(nullptr),
       m_encoding(encoding),
       m_ascii(isAscii)
 {
-    memcpy(character_storage, text.data(), text.size());
-    character_storage[text.size()] = '\0';  // Null terminated.
+    memcpy(character_storage, text, length);
+    character_storage[length] = '\0';  // Null terminated.
     assert(m_data);
 
     switch(m_encoding) {
@@ -81,19 +81,20 @@ String::String(char* character_storage,
     }
 }
 
-String* String::create(const std::string& text, cetype_t encoding, bool isAscii)
+String* String::create(const char* text, std::size_t length,
+		       cetype_t encoding, bool isAscii)
 {
-    size_t size = sizeof(String) + text.size() + 1;
+    size_t size = sizeof(String) + length + 1;
     void* storage = GCNode::operator new(size);
     char* character_storage = (char*)storage + sizeof(String);
-    String* result = new(storage) String(character_storage, text, encoding,
-					 isAscii);
+    String* result = new(storage) String(character_storage, text, length,
+					 encoding, isAscii);
     return result;
 }
 
 String* String::createNA()
 {
-    return String::create("NA", CE_NATIVE, true);
+    return String::create("NA", 2, CE_NATIVE, true);
 }
 
 String::~String()
@@ -153,7 +154,16 @@ bool rho::isASCII(const std::string& str)
     return it == str.end();
 }
 
-String* String::obtain(const std::string& str, cetype_t encoding)
+bool rho::isASCII(const char* text, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; ++i)
+	if (text[i] & 0x80)
+	    return false;
+    return true;
+}
+
+String* String::obtain(const char* text, std::size_t length,
+		       cetype_t encoding)
 {
     // This will be checked again when we actually construct the
     // String, but we precheck now so that we don't create an
@@ -167,21 +177,24 @@ String* String::obtain(const std::string& str, cetype_t encoding)
     default:
         Rf_error("unknown encoding: %d", encoding);
     }
-    bool ascii = rho::isASCII(str);
+    bool ascii = rho::isASCII(text, length);
     if (ascii)
 	encoding = CE_NATIVE;
-    std::pair<map::iterator, bool> pr
-	= getCache()->insert(map::value_type(key(str, encoding), nullptr));
-    map::iterator it = pr.first;
-    if (pr.second) {
-	try {
-	    map::value_type& val = *it;
-	    val.second = String::create(str, encoding, ascii);
-	    val.second->m_key_val_pr = &*it;
-	} catch (...) {
-	    getCache()->erase(it);
-	    throw;
-	}
+    // Look the string up first, so that a hit allocates no map node;
+    // on a miss the key is moved into the cache, so that the text is
+    // copied only into the key and into the String itself:
+    key k(std::string(text, length), encoding);
+    map::iterator it = getCache()->find(k);
+    if (it != getCache()->end())
+	return (*it).second;
+    it = getCache()->emplace(std::move(k), nullptr).first;
+    try {
+	map::value_type& val = *it;
+	val.second = String::create(text, length, encoding, ascii);
+	val.second->m_key_val_pr = &*it;
+    } catch (...) {
+	getCache()->erase(it);
+	throw;
     }
     return (*it).second;
 }
@@ -228,6 +241,5 @@ SEXP Rf_mkCharLenCE(const char* text, int length, cetype_t encoding)
     default:
 	Rf_error(_("unknown encoding: %d"), encoding);
     }
-    std::string str(text, length);
-    return String::obtain(str, encoding);
+    return String::obtain(text, length, encoding);
 }
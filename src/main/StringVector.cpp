@@ -30,7 +30,9 @@
 #include "rho/StringVector.hpp"
 #include "Defn.h"
 
+#include <cmath>
 #include <iostream>
+#include <unordered_set>
 
 using namespace rho;
 
@@ -55,6 +57,39 @@ namespace rho {
     }
 }
 
+int StringDictionary::encode(const String* str, bool* is_new)
+{
+    auto it = m_codes.find(str);
+    if (it != m_codes.end()) {
+	*is_new = false;
+	return it->second;
+    }
+    if (m_entries.size() >= m_max_size)
+	return -1;
+    int code = int(m_entries.size());
+    m_codes.emplace(str, code);
+    m_entries.push_back(str);
+    *is_new = true;
+    return code;
+}
+
+bool StringDictionary::mayHaveFewValues(const StringVector* sv,
+					std::size_t max_size)
+{
+    const std::size_t sample = 4096;
+    std::size_t n = sv->size();
+    if (n < minLength)
+	return false;
+    std::unordered_set<const String*> seen;
+    std::size_t step = n / sample;
+    for (std::size_t k = 0; k < sample; ++k)
+	seen.insert((*sv)[k * step]);
+    // Expected number of distinct values in the sample if sv had
+    // max_size equally common values:
+    double expected = -double(max_size) * std::expm1(-double(sample)/max_size);
+    return seen.size() <= expected;
+}
+
 namespace {
     void indent(std::ostream& os, std::size_t margin)
     {
@@ -223,25 +223,32 @@ void Subscripting::Indices::initialize(const LogicalVector* raw_indices,
     if (rawsize == 0)
 	return;
     m_min_lhssize = std::max(range_size, rawsize);
-    // Determine size of answer:
-    std::size_t anssize = 0;
-    for (std::size_t i = 0; i < m_min_lhssize; ++i)
-    {
-	Logical included = (*raw_indices)[i%rawsize];
-	if (included.isTrue() || included.isNA())
-	    ++anssize;
+    // Determine size of answer.  The subscripts are recycled in whole
+    // passes over raw_indices, followed by a partial pass:
+    const Logical* raw = &(*raw_indices)[0];
+    std::size_t npasses = m_min_lhssize/rawsize;
+    std::size_t tail = m_min_lhssize%rawsize;
+    std::size_t ntrue, nna, anssize;
+    countLogicals(raw, raw + rawsize, &ntrue, &nna);
+    anssize = npasses*(ntrue + nna);
+    if (tail) {
+	countLogicals(raw, raw + tail, &ntrue, &nna);
+	anssize += ntrue + nna;
     }
     // Create Indices vector:
     resize(anssize);
     m_max_index = 0;
     std::size_t iout = 0;
-    for (std::size_t iin = 0; iin < m_min_lhssize; ++iin) {
-	Logical logical = (*raw_indices)[iin % rawsize];
-	if (logical.isNA())
-	    (*this)[iout++] = 0;
-	else if (logical.isTrue()) {
-	    m_max_index = iin + 1;
-	    (*this)[iout++] = m_max_index;
+    for (std::size_t base = 0; base < m_min_lhssize; base += rawsize) {
+	std::size_t n = std::min(rawsize, m_min_lhssize - base);
+	for (std::size_t i = 0; i < n; ++i) {
+	    Logical logical = raw[i];
+	    if (logical.isNA())
+		(*this)[iout++] = 0;
+	    else if (logical.isTrue()) {
+		m_max_index = base + i + 1;
+		(*this)[iout++] = m_max_index;
+	    }
 	}
     }
 }
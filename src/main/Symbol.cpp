@@ -111,6 +111,10 @@ RObject* Symbol::evaluate(Environment* env)
     else {
 	Frame::Binding* bdg = env->findBinding(this);
 	if (bdg) {
+	    // forcedValue() invokes the read monitor only when it
+	    // forces a Promise:
+	    if (bdg->frame()->isReadMonitored() && !bdg->isPromise())
+		bdg->rawValue();
             val = bdg->forcedValue();
             if (bdg->isPromise()) {
                 if (NAMED(val) < 2)
@@ -31,6 +31,8 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include "rho/CommandTerminated.hpp"
 #include "rho/Environment.hpp"
@@ -202,6 +204,35 @@ WeakRef::WRList* WeakRef::getTombstone()
     return tombstone;
 }
 
+// Marker which, whenever it marks the key of a WeakRef awaiting
+// processing by markThru(), moves that WeakRef to the work list.
+class WeakRef::EphemeronMarker : public GCNode::Marker {
+public:
+    typedef std::unordered_multimap<const GCNode*, WeakRef*> KeyIndex;
+
+    EphemeronMarker(KeyIndex* unmarked_keys, std::vector<WeakRef*>* work)
+	: m_unmarked_keys(unmarked_keys), m_work(work)
+    {}
+
+    void operator()(const GCNode* node) override
+    {
+	if (node->isMarked())
+	    return;
+	if (!m_unmarked_keys->empty()) {
+	    auto range = m_unmarked_keys->equal_range(node);
+	    if (range.first != range.second) {
+		for (auto it = range.first; it != range.second; ++it)
+		    m_work->push_back(it->second);
+		m_unmarked_keys->erase(range.first, range.second);
+	    }
+	}
+	Marker::operator()(node);
+    }
+private:
+    KeyIndex* m_unmarked_keys;
+    std::vector<WeakRef*>* m_work;
+};
+
 void WeakRef::markThru()
 {
     WeakRef::check();
@@ -213,25 +244,25 @@ void WeakRef::markThru()
     // Step 2-3 of algorithm.  Mark the value and R finalizer if the
     // key is marked.
     {
-	unsigned int marks_applied;
-	do {
-	    GCNode::CountingMarker marker;
-	    WRList::iterator lit = live->begin();
-	    while (lit != live->end()) {
-		WeakRef* wr = *lit++;
-		RObject* key = wr->key();
-		if (key->isMarked()) {
-		    RObject* value = wr->value();
-		    if (value)
-			marker(value);
-		    FunctionBase* Rfinalizer = wr->m_Rfinalizer;
-		    if (Rfinalizer)
-			marker(Rfinalizer);
-		    wr->transfer(live, &newlive);
-		}
-	    }
-	    marks_applied = marker.marksApplied();
-	} while (marks_applied > 0);
+	EphemeronMarker::KeyIndex unmarked_keys;
+	std::vector<WeakRef*> work;
+	for (WeakRef* wr: *live) {
+	    if (wr->key()->isMarked())
+		work.push_back(wr);
+	    else unmarked_keys.emplace(wr->key(), wr);
+	}
+	EphemeronMarker marker(&unmarked_keys, &work);
+	while (!work.empty()) {
+	    WeakRef* wr = work.back();
+	    work.pop_back();
+	    RObject* value = wr->value();
+	    if (value)
+		marker(value);
+	    FunctionBase* Rfinalizer = wr->m_Rfinalizer;
+	    if (Rfinalizer)
+		marker(Rfinalizer);
+	    wr->transfer(live, &newlive);
+	}
     }
     // Step 4 of algorithm.  Process references with unmarked keys.
     {
@@ -290,10 +321,10 @@ void WeakRef::runExitFinalizers()
     runFinalizers();
 }
 
-bool WeakRef::runFinalizers()
+bool WeakRef::runFinalizers(std::size_t max_count)
 {
     WRList* finalization_pending = getFinalizationPending();
-    if (finalization_pending->empty())
+    if (finalization_pending->empty() || max_count == 0)
 	return false;
 
     // Prevent this function from running again when already in progress.
@@ -305,7 +336,8 @@ bool WeakRef::runFinalizers()
 	WeakRef::check();
 
 	WRList::iterator lit = finalization_pending->begin();
-	while (lit != finalization_pending->end()) {
+	for (std::size_t count = 0;
+	     count < max_count && lit != finalization_pending->end(); ++count) {
 	    WeakRef* wr = *lit++;
 	    GCStackRoot<> topExp(R_CurrentExpr);
 	    size_t savestack = ProtectStack::size();
@@ -95,6 +95,7 @@
 #include "basedecl.h"
 #include <cstdarg>
 
+#include "rho/CommandRecorder.hpp"
 #include "rho/ProvenanceTracker.hpp"
 #include "rho/RAllocStack.hpp"
 
@@ -1474,9 +1475,238 @@ typedef struct gzconn {
 } *Rgzconn;
 
 
+/* Read-ahead for gzfile connections.
+
+   When a large compressed file is opened for reading, a background
+   thread decompresses it ahead of the reader into a ring buffer, so
+   that inflating the data overlaps with whatever R does with it.
+   The thread only calls R_gzread_quiet(), which does not use the R
+   API; any warning it records is given by the reader on reaching the
+   point in the data at which decompression failed.
+
+   The reader takes data from the ring in blocks, which it keeps in a
+   buffer of its own so that reading a character at a time does not
+   involve the lock.  Seeking stops the thread and discards what has
+   been read ahead; it is restarted by the next read. */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+/* Size of the ring buffer */
+#define GZ_AHEAD_SIZE (4 << 20)
+/* Largest amount decompressed into the ring at a time */
+#define GZ_AHEAD_CHUNK (256 << 10)
+/* Size of the reader's own buffer */
+#define GZ_AHEAD_LOCAL (64 << 10)
+/* Smallest compressed file for which read-ahead is used */
+#define GZ_AHEAD_MIN_FILE (1 << 20)
+
+namespace {
+    class GzReadAhead {
+    public:
+	explicit GzReadAhead(gzFile fp)
+	    : m_fp(fp), m_ring(GZ_AHEAD_SIZE), m_local(GZ_AHEAD_LOCAL)
+	{}
+
+	~GzReadAhead()
+	{
+	    stop();
+	}
+
+	// Read up to len bytes, returning the number read, which is
+	// less than len only at the end of the data or on error.
+	size_t read(void* ptr, size_t len);
+
+	// Read one character, or return R_EOF.
+	int getc()
+	{
+	    if (m_lpos == m_lend && !refill())
+		return R_EOF;
+	    return m_local[m_lpos++];
+	}
+
+	// Position of the reader in the uncompressed data.
+	Rz_off_t tell() const
+	{
+	    Rz_off_t unread = Rz_off_t(m_lend - m_lpos);
+	    if (!m_running)
+		return R_gztell(m_fp) - unread;
+	    return m_base + Rz_off_t(m_consumed) - unread;
+	}
+
+	// Move the reader to position target in the uncompressed data.
+	// Returns -1 on failure, as R_gzseek.
+	int seek(Rz_off_t target);
+    private:
+	gzFile m_fp;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_filled, m_drained;
+	std::vector<unsigned char> m_ring;
+	size_t m_head = 0, m_count = 0;  // in the ring
+	std::vector<unsigned char> m_local;
+	size_t m_lpos = 0, m_lend = 0;   // in the reader's buffer
+	Rz_off_t m_base = 0;  // file position when the thread started
+	size_t m_consumed = 0;  // bytes taken from the ring since then
+	bool m_running = false, m_stop = false, m_eof = false;
+	int m_failed = Z_OK;
+
+	bool start();
+	void stop();
+	void produce();
+	size_t take(unsigned char* out, size_t len, bool all);
+	bool refill();
+    };
+
+    bool GzReadAhead::start()
+    {
+	if (m_running)
+	    return true;
+	m_base = R_gztell(m_fp);
+	m_head = m_count = m_consumed = 0;
+	m_stop = m_eof = false;
+	m_failed = Z_OK;
+	try {
+	    m_thread = std::thread(&GzReadAhead::produce, this);
+	} catch (...) {
+	    return false;
+	}
+	m_running = true;
+	return true;
+    }
+
+    // Stop the thread, leaving the file positioned after the data
+    // read ahead, which is discarded.
+    void GzReadAhead::stop()
+    {
+	if (m_running) {
+	    {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	    }
+	    m_drained.notify_one();
+	    m_thread.join();
+	    m_running = false;
+	}
+	m_lpos = m_lend = 0;
+    }
+
+    int GzReadAhead::seek(Rz_off_t target)
+    {
+	Rz_off_t pos = tell();
+	if (target >= pos) {
+	    // Forward seeks decompress and discard the data anyway, so
+	    // take it from the ring.
+	    Rz_off_t skip = target - pos;
+	    while (skip > 0) {
+		if (m_lpos == m_lend && !refill())
+		    break;
+		size_t n = std::min(size_t(skip), m_lend - m_lpos);
+		m_lpos += n;
+		skip -= n;
+	    }
+	    return 0;
+	}
+	stop();
+	return R_gzseek(m_fp, target, SEEK_SET);
+    }
+
+    void GzReadAhead::produce()
+    {
+	const size_t size = m_ring.size();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stop && !m_eof) {
+	    m_drained.wait(lock, [&]{ return m_stop || m_count < size; });
+	    if (m_stop)
+		break;
+	    size_t tail = (m_head + m_count) % size;
+	    size_t n = std::min(std::min(size - m_count, size - tail),
+				size_t(GZ_AHEAD_CHUNK));
+	    // The free part of the ring belongs to this thread.
+	    lock.unlock();
+	    int failed = Z_OK;
+	    int got = R_gzread_quiet(m_fp, &m_ring[tail], unsigned(n),
+				     &failed);
+	    lock.lock();
+	    if (got > 0)
+		m_count += got;
+	    if (failed != Z_OK && m_failed == Z_OK)
+		m_failed = failed;
+	    if (got <= 0)
+		m_eof = true;
+	    m_filled.notify_one();
+	}
+    }
+
+    // Take data from the ring: len bytes if all is true (or up to the
+    // end of the data), otherwise at least one.
+    size_t GzReadAhead::take(unsigned char* out, size_t len, bool all)
+    {
+	const size_t size = m_ring.size();
+	size_t done = 0;
+	int failed = Z_OK;
+	{
+	    std::unique_lock<std::mutex> lock(m_mutex);
+	    while (done < len && (all || done == 0)) {
+		m_filled.wait(lock, [&]{ return m_count > 0 || m_eof; });
+		if (m_count == 0) {
+		    std::swap(failed, m_failed);
+		    break;
+		}
+		size_t n = std::min(std::min(len - done, m_count),
+				    size - m_head);
+		// The filled part of the ring belongs to the reader.
+		lock.unlock();
+		memcpy(out + done, &m_ring[m_head], n);
+		lock.lock();
+		m_head = (m_head + n) % size;
+		m_count -= n;
+		m_consumed += n;
+		done += n;
+		m_drained.notify_one();
+	    }
+	}
+	R_gzwarn(failed);
+	return done;
+    }
+
+    bool GzReadAhead::refill()
+    {
+	m_lpos = 0;
+	if (start())
+	    m_lend = take(m_local.data(), m_local.size(), false);
+	else {
+	    int res = R_gzread(m_fp, m_local.data(), unsigned(m_local.size()));
+	    m_lend = res > 0 ? res : 0;
+	}
+	return m_lend > 0;
+    }
+
+    size_t GzReadAhead::read(void* ptr, size_t len)
+    {
+	unsigned char* out = static_cast<unsigned char*>(ptr);
+	size_t done = std::min(len, m_lend - m_lpos);
+	memcpy(out, &m_local[m_lpos], done);
+	m_lpos += done;
+	if (done == len)
+	    return done;
+	if (!start()) {
+	    int res = R_gzread(m_fp, out + done, unsigned(len - done));
+	    return done + (res > 0 ? res : 0);
+	}
+	return done + take(out + done, len - done, true);
+    }
+}
+
 typedef struct gzfileconn {
     gzFile fp;
     int compress;
+    GzReadAhead *ahead; /* or nullptr */
 } *Rgzfileconn;
 
 static Rboolean gzfile_open(Rconnection con)
@@ -1489,7 +1719,10 @@ static Rboolean gzfile_open(Rconnection con)
     /* Must open as binary */
     if(strchr(con->mode, 'w')) snprintf(mode, 6, "wb%1d", gzcon->compress);
     else if (con->mode[0] == 'a') snprintf(mode, 6, "ab%1d", gzcon->compress);
-    else strcpy(mode, "rb");
+    else {
+	strcpy(mode, "rb");
+	CommandRecorder::noteFileRead(con->description);
+    }
     errno = 0; /* precaution */
     fp = R_gzopen(R_ExpandFileName(con->description), mode);
     if(!fp) {
@@ -1498,6 +1731,12 @@ static Rboolean gzfile_open(Rconnection con)
 	return FALSE;
     }
     (static_cast<Rgzfileconn>((con->connprivate)))->fp = fp;
+    if (mode[0] == 'r' && std::thread::hardware_concurrency() > 1) {
+	struct stat sb;
+	if (stat(R_ExpandFileName(con->description), &sb) == 0
+	    && sb.st_size >= GZ_AHEAD_MIN_FILE)
+	    gzcon->ahead = new GzReadAhead(fp);
+    }
     con->isopen = TRUE;
     con->canwrite = RHOCONSTRUCT(Rboolean, (con->mode[0] == 'w' || con->mode[0] == 'a'));
     con->canread = RHOCONSTRUCT(Rboolean, !con->canwrite);
@@ -1509,16 +1748,20 @@ static Rboolean gzfile_open(Rconnection con)
 
 static void gzfile_close(Rconnection con)
 {
-    R_gzclose((static_cast<Rgzfileconn>((con->connprivate)))->fp);
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
+    delete gzcon->ahead;
+    gzcon->ahead = nullptr;
+    R_gzclose(gzcon->fp);
     con->isopen = FALSE;
 }
 
 static int gzfile_fgetc_internal(Rconnection con)
 {
-    gzFile fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    Rgzfileconn gzcon = static_cast<Rgzfileconn>(con->connprivate);
     unsigned char c;
 
-    return R_gzread(fp, &c, 1) == 1 ? c : R_EOF;
+    if (gzcon->ahead) return gzcon->ahead->getc();
+    return R_gzread(gzcon->fp, &c, 1) == 1 ? c : R_EOF;
 }
 
 /* This can only seek forwards when writing (when it writes nul bytes).
@@ -1526,7 +1769,8 @@ static int gzfile_fgetc_internal(Rconnection con)
 static double gzfile_seek(Rconnection con, double where, int origin, int rw)
 {
     gzFile  fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
-    Rz_off_t pos = R_gztell(fp);
+    GzReadAhead *ahead = (static_cast<Rgzfileconn>((con->connprivate)))->ahead;
+    Rz_off_t pos = ahead ? ahead->tell() : R_gztell(fp);
     int res, whence = SEEK_SET;
 
     if (ISNA(where)) return double( pos);
@@ -1536,7 +1780,11 @@ static double gzfile_seek(Rconnection con, double where, int origin, int rw)
     case 3: error(_("whence = \"end\" is not implemented for gzfile connections"));
     default: whence = SEEK_SET;
     }
-    res = R_gzseek(fp, z_off_t( where), whence);
+    if (ahead)
+	res = ahead->seek(whence == SEEK_CUR ? pos + Rz_off_t(where)
+			  : Rz_off_t(where));
+    else
+	res = R_gzseek(fp, z_off_t( where), whence);
     if(res == -1)
 	warning(_("seek on a gzfile connection returned an internal error"));
     return double( pos);
@@ -1551,9 +1799,11 @@ static size_t gzfile_read(void *ptr, size_t size, size_t nitems,
 			Rconnection con)
 {
     gzFile fp = (static_cast<Rgzfileconn>((con->connprivate)))->fp;
+    GzReadAhead *ahead = (static_cast<Rgzfileconn>((con->connprivate)))->ahead;
     /* uses 'unsigned' for len */
     if (double( size) * double( nitems) > UINT_MAX)
 	error(_("too large a block specified"));
+    if (ahead) return ahead->read(ptr, size*nitems)/size;
     return R_gzread(fp, ptr, static_cast<unsigned int>(size*nitems))/size;
 }
 
@@ -1602,6 +1852,7 @@ static Rconnection newgzfile(const char *description, const char *mode,
 	error(_("allocation of gzfile connection failed"));
     }
     static_cast<Rgzfileconn>(newconn->connprivate)->compress = compress;
+    static_cast<Rgzfileconn>(newconn->connprivate)->ahead = nullptr;
     return newconn;
 }
 
@@ -2517,6 +2768,7 @@ typedef struct rawconn {
     /* replace nbytes by TRUELENGTH in due course? */
     size_t pos, nbytes; /* current pos and number of bytes
 			   (same pos for read and write) */
+    Rboolean shared; /* data has been returned by rawConnectionValue */
 } *Rrawconn;
 
 
@@ -2528,6 +2780,7 @@ static void raw_init(Rconnection con, SEXP raw)
     R_PreserveObject(thisconn->data);
     thisconn->nbytes = XLENGTH(thisconn->data);
     thisconn->pos = 0;
+    thisconn->shared = FALSE;
 }
 
 static Rboolean raw_open(Rconnection con)
@@ -2552,6 +2805,8 @@ static void raw_resize(Rrawconn thisconn, size_t needed)
     size_t nalloc = 64;
     SEXP tmp;
 
+    /* After a seek() back, the bytes beyond pos must be kept too */
+    if (needed < thisconn->nbytes) needed = thisconn->nbytes;
     if (needed > 8192) nalloc = size_t(1.2*double(needed)); /* 20% over-allocation */
     else while(nalloc < needed) nalloc *= 2;  /* use powers of 2 if small */
     PROTECT(tmp = allocVector(RAWSXP, nalloc));
@@ -2559,6 +2814,7 @@ static void raw_resize(Rrawconn thisconn, size_t needed)
     R_ReleaseObject(thisconn->data);
     thisconn->data = tmp;
     R_PreserveObject(thisconn->data);
+    thisconn->shared = FALSE;
     UNPROTECT(1);
 }
 
@@ -2568,10 +2824,12 @@ static size_t raw_write(const void *ptr, size_t size, size_t nitems,
     Rrawconn thisconn = RHO_S_CAST(Rrawconn, con->connprivate);
     size_t freespace = XLENGTH(thisconn->data) - thisconn->pos, bytes = size*nitems;
 
-    if (double( size) * double( nitems) + double( thisconn->pos) > R_LEN_T_MAX)
+    if (double( size) * double( nitems) + double( thisconn->pos) > R_XLEN_T_MAX)
 	error(_("attempting to add too many elements to raw vector"));
-    /* resize may fail, when this will give an error */
-    if(bytes >= freespace) raw_resize(thisconn, bytes + thisconn->pos);
+    /* resize may fail, when this will give an error.  The data must
+       also be copied if rawConnectionValue() has handed it out. */
+    if(bytes >= freespace || thisconn->shared)
+	raw_resize(thisconn, bytes + thisconn->pos);
     /* the source just might be this raw vector */
     memmove(RAW(thisconn->data) + thisconn->pos, ptr, bytes);
     thisconn->pos += bytes;
@@ -2591,7 +2849,7 @@ static size_t raw_read(void *ptr, size_t size, size_t nitems,
     Rrawconn thisconn = RHO_S_CAST(Rrawconn, con->connprivate);
     size_t available = thisconn->nbytes - thisconn->pos, request = size*nitems, used;
 
-    if (double( size) * double( nitems) + double( thisconn->pos) > R_LEN_T_MAX)
+    if (double( size) * double( nitems) + double( thisconn->pos) > R_XLEN_T_MAX)
 	error(_("too large a block specified"));
     used = (request < available) ? request : available;
     memmove(ptr, RAW(thisconn->data) + thisconn->pos, used);
@@ -2721,8 +2979,13 @@ SEXP attribute_hidden do_rawconvalue(/*const*/ Expression* call, const BuiltInFu
     if(!con->canwrite)
 	error(_("'con' is not an output rawConnection"));
     thisconn = RHO_S_CAST(Rrawconn, con->connprivate);
-    ans = allocVector(RAWSXP, thisconn->nbytes); /* later, use TRUELENGTH? */
-    memcpy(RAW(ans), RAW(thisconn->data), thisconn->nbytes);
+    /* Return the connection's own vector, trimmed to the bytes
+       written, rather than a copy; any later write copies it first. */
+    ans = thisconn->data;
+    if(XLENGTH(ans) > R_xlen_t(thisconn->nbytes))
+	SETLENGTH(ans, thisconn->nbytes);
+    SET_NAMED(ans, 2);
+    thisconn->shared = TRUE;
     return ans;
 }
 
@@ -2734,10 +2997,18 @@ typedef struct textconn {
     char save; /* pushback */
 } *Rtextconn;
 
+/* Complete lines are accumulated in 'pending', and are only appended
+   to 'data', and 'data' assigned to the variable, when the
+   connection is flushed or closed, when the value is asked for, or
+   when 'pending' is full: appending each line to 'data' as it was
+   written would make capturing n lines take O(n^2) time.  'data' and
+   'pending' are both preserved. */
 typedef struct outtextconn {
-    size_t len;  /* number of lines */
+    size_t len;  /* number of lines, including those pending */
     SEXP namesymbol;
     SEXP data;
+    SEXP pending;
+    size_t npending;
     char *lastline;
     int lastlinelength; /* buffer size */
 } *Routtextconn;
@@ -2857,23 +3128,84 @@ static SEXP mkCharLocal(const char *s)
     return mkCharCE(s, ienc);
 }
 
+/* Append the pending lines to the character vector of output. */
+static SEXP outtext_value(Routtextconn thisconn)
+{
+    if(thisconn->npending > 0) {
+	SEXP tmp;
+	R_xlen_t i, n = XLENGTH(thisconn->data);
+	PROTECT(tmp = allocVector(STRSXP, thisconn->len));
+	for(i = 0; i < n; i++)
+	    SET_STRING_ELT(tmp, i, STRING_ELT(thisconn->data, i));
+	for(size_t j = 0; j < thisconn->npending; j++)
+	    SET_STRING_ELT(tmp, n + j, STRING_ELT(thisconn->pending, j));
+	SET_NAMED(tmp, 2);
+	R_ReleaseObject(thisconn->data);
+	R_PreserveObject(tmp);
+	thisconn->data = tmp;
+	thisconn->npending = 0;
+	UNPROTECT(1);
+    }
+    return thisconn->data;
+}
+
+/* Write the output so far to the variable, if there is one.  The
+   binding is locked while the connection is open. */
+static void outtext_flush_value(Rconnection con)
+{
+    Routtextconn thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
+    SEXP env = VECTOR_ELT(OutTextData, ConnIndex(con));
+
+    if(thisconn->npending == 0) return;
+    outtext_value(thisconn);
+    if(thisconn->namesymbol) {
+	if(findVarInFrame3(env, thisconn->namesymbol, FALSE)
+	   != R_UnboundValue) R_unLockBinding(thisconn->namesymbol, env);
+	defineVar(thisconn->namesymbol, thisconn->data, env);
+	R_LockBinding(thisconn->namesymbol, env);
+    }
+}
+
+static int outtext_fflush(Rconnection con)
+{
+    outtext_flush_value(con);
+    return 0;
+}
+
+/* When the buffer of pending lines is full they are written out, and
+   the buffer is enlarged to at least the number of lines so far, so
+   that the copying is linear in the number of lines written. */
+static void outtext_append(Rconnection con, SEXP line)
+{
+    Routtextconn thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
+    size_t capacity = XLENGTH(thisconn->pending);
+    if(thisconn->npending == capacity) {
+	PROTECT(line);
+	outtext_flush_value(con);
+	if(capacity < thisconn->len) {
+	    SEXP tmp = allocVector(STRSXP, thisconn->len);
+	    R_ReleaseObject(thisconn->pending);
+	    R_PreserveObject(tmp);
+	    thisconn->pending = tmp;
+	}
+	UNPROTECT(1);
+    }
+    SET_STRING_ELT(thisconn->pending, thisconn->npending++, line);
+    thisconn->len++;
+}
+
 static void outtext_close(Rconnection con)
 {
     Routtextconn thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
     int idx = ConnIndex(con);
-    SEXP tmp, env = VECTOR_ELT(OutTextData, idx);
+    SEXP env = VECTOR_ELT(OutTextData, idx);
 
+    if(strlen(thisconn->lastline) > 0)
+	outtext_append(con, mkCharLocal(thisconn->lastline));
+    outtext_flush_value(con);
     if(thisconn->namesymbol &&
        findVarInFrame3(env, thisconn->namesymbol, FALSE) != R_UnboundValue)
 	R_unLockBinding(thisconn->namesymbol, env);
-    if(strlen(thisconn->lastline) > 0) {
-	PROTECT(tmp = xlengthgets(thisconn->data, ++thisconn->len));
-	SET_STRING_ELT(tmp, thisconn->len - 1, mkCharLocal(thisconn->lastline));
-	if(thisconn->namesymbol) defineVar(thisconn->namesymbol, tmp, env);
-	SET_NAMED(tmp, 2);
-	thisconn->data = tmp;
-	UNPROTECT(1);
-    }
 }
 
 static void outtext_destroy(Rconnection con)
@@ -2881,11 +3213,12 @@ static void outtext_destroy(Rconnection con)
     Routtextconn thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
     int idx = ConnIndex(con);
     /* OutTextData is preserved, and that implies that the environment
-       we are writing it and hence the character vector is protected.
+       we are writing it to is protected.
        However, this could be quite expensive.
     */
     SET_VECTOR_ELT(OutTextData, idx, R_NilValue);
-    if(!thisconn->namesymbol) R_ReleaseObject(thisconn->data);
+    R_ReleaseObject(thisconn->data);
+    R_ReleaseObject(thisconn->pending);
     free(thisconn->lastline); free(thisconn);
 }
 
@@ -2898,7 +3231,6 @@ static int text_vfprintf(Rconnection con, const char *format, va_list ap)
     const void *vmax = nullptr;
     int res = 0, buffree,
 	already = int( strlen(thisconn->lastline)); // we do not allow longer lines
-    SEXP tmp;
 
     va_list aq;
     va_copy(aq, ap);
@@ -2939,23 +3271,8 @@ static int text_vfprintf(Rconnection con, const char *format, va_list ap)
     for(p = b; ; p = q+1) {
 	q = Rf_strchr(p, '\n');
 	if(q) {
-	    int idx = ConnIndex(con);
-	    SEXP env = VECTOR_ELT(OutTextData, idx);
 	    *q = '\0';
-	    PROTECT(tmp = xlengthgets(thisconn->data, ++thisconn->len));
-	    SET_STRING_ELT(tmp, thisconn->len - 1, mkCharLocal(p));
-	    if(thisconn->namesymbol) {
-		if(findVarInFrame3(env, thisconn->namesymbol, FALSE)
-		   != R_UnboundValue) R_unLockBinding(thisconn->namesymbol, env);
-		defineVar(thisconn->namesymbol, tmp, env);
-		R_LockBinding(thisconn->namesymbol, env);
-	    } else {
-		R_ReleaseObject(thisconn->data);
-		R_PreserveObject(tmp);
-	    }
-	    thisconn->data = tmp;
-	    SET_NAMED(tmp, 2);
-	    UNPROTECT(1);
+	    outtext_append(con, mkCharLocal(p));
 	} else {
 	    /* retain the last line */
 	    if(RHOCONSTRUCT(int, strlen(p)) >= thisconn->lastlinelength) {
@@ -2980,6 +3297,8 @@ static int text_vfprintf(Rconnection con, const char *format, va_list ap)
     return res;
 }
 
+#define PENDING_LINES 64
+
 static void outtext_init(Rconnection con, SEXP stext, const char *mode, int idx)
 {
     Routtextconn thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
@@ -2987,9 +3306,7 @@ static void outtext_init(Rconnection con, SEXP stext, const char *mode, int idx)
 
     if(stext == R_NilValue) {
 	thisconn->namesymbol = nullptr;
-	    /* create variable pointed to by con->description */
 	val = allocVector(STRSXP, 0);
-	R_PreserveObject(val);
     } else {
 	thisconn->namesymbol = install(con->description);
 	if(strcmp(mode, "w") == 0) {
@@ -3013,8 +3330,13 @@ static void outtext_init(Rconnection con, SEXP stext, const char *mode, int idx)
 	    R_LockBinding(thisconn->namesymbol, VECTOR_ELT(OutTextData, idx));
 	}
     }
+    R_PreserveObject(val);
     thisconn->len = LENGTH(val);
     thisconn->data = val;
+    val = allocVector(STRSXP, PENDING_LINES);
+    R_PreserveObject(val);
+    thisconn->pending = val;
+    thisconn->npending = 0;
     thisconn->lastline[0] = '\0';
     thisconn->lastlinelength = LAST_LINE_LEN;
 }
@@ -3046,6 +3368,7 @@ static Rconnection newouttext(const char *description, SEXP stext,
     newconn->close = &outtext_close;
     newconn->destroy = &outtext_destroy;
     newconn->vfprintf = &text_vfprintf;
+    newconn->fflush = &outtext_fflush;
     newconn->seek = &text_seek;
     newconn->connprivate = RHO_NO_CAST(void*) malloc(sizeof(struct outtextconn));
     if(!newconn->connprivate) {
@@ -3132,6 +3455,7 @@ SEXP attribute_hidden do_textconvalue(/*const*/ Expression* call, const BuiltInF
     if(!con->canwrite)
 	error(_("'con' is not an output textConnection"));
     thisconn = RHO_S_CAST(Routtextconn, con->connprivate);
+    outtext_flush_value(con);
     return thisconn->data;
 }
 
@@ -3199,6 +3523,587 @@ SEXP attribute_hidden do_sockconn(/*const*/ Expression* call, const BuiltInFunct
     return ans;
 }
 
+/* ------------------- socket event loop  --------------------- */
+
+/* An event loop serving many socket connections at once, for a
+   process acting as a server for local workers.  Listening sockets,
+   and the sockets of connections that have callbacks or queued
+   output, are registered with epoll where it is available, so the
+   cost of waiting does not grow with the number of idle clients;
+   elsewhere poll() is used.  With epoll, the epoll descriptor is
+   itself an input handler, so events are also dispatched whenever R
+   services its input handlers: at the prompt, in Sys.sleep() and in
+   socketSelect().
+
+   Output queued by socketQueue() is not written at once.  Everything
+   queued for a connection is written with a single sendmsg() when
+   the loop next finds the socket writable.
+
+   Sockets accepted by a listener become non-blocking socket
+   connections, so that a read callback can read what has arrived
+   without waiting for more. */
+
+#ifdef Unix
+#include <R_ext/eventloop.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#ifdef __linux__
+# include <sys/epoll.h>
+# define HAVE_EPOLL
+#endif
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SockLoopActivity 10
+#define SOCKLOOP_READ 1
+#define SOCKLOOP_WRITE 2
+#define SOCKLOOP_MAXIOV 64
+
+typedef struct sockwatch {
+    int fd;
+    GCRoot<> conobj; /* the R connection object, or R_NilValue for a
+			listening socket */
+    Rconnection con;
+    int port;
+    GCRoot<> accept, read, drained; /* callbacks, or R_NilValue */
+    std::deque<std::string> queue;
+    size_t offset;  /* bytes of queue.front() already written */
+    size_t queued;  /* bytes awaiting writing */
+    int events;     /* events registered with epoll */
+    bool paused;    /* listener not accepting, as no connection was free */
+} *Rsockwatch;
+
+static std::map<int, Rsockwatch> SockWatches;
+/* Connections with data already in their input buffer, for which
+   the operating system will report nothing more: */
+static std::vector<int> SockBuffered;
+static Rboolean SockLoopBusy = FALSE;
+#ifdef HAVE_EPOLL
+static int SockLoopFd = -1;
+static InputHandler *SockLoopHandler = nullptr;
+static void sockloop_input_handler(void *data);
+#endif
+
+static void sockloop_set(GCRoot<> *slot, SEXP fun)
+{
+    if(fun != R_NilValue && !isFunction(fun))
+	error(_("invalid callback"));
+    *slot = fun;
+}
+
+static Rsockwatch sockloop_watch(int fd)
+{
+    std::map<int, Rsockwatch>::iterator it = SockWatches.find(fd);
+    return it == SockWatches.end() ? nullptr : it->second;
+}
+
+static Rsockwatch sockloop_add(int fd, SEXP conobj, Rconnection con)
+{
+#ifdef HAVE_EPOLL
+    if(SockLoopFd < 0) {
+	SockLoopFd = epoll_create1(EPOLL_CLOEXEC);
+	if(SockLoopFd < 0)
+	    error(_("cannot create socket event loop: %s"), strerror(errno));
+	SockLoopHandler = addInputHandler(R_InputHandlers, SockLoopFd,
+					  &sockloop_input_handler,
+					  SockLoopActivity);
+    }
+#endif
+    Rsockwatch w = new sockwatch;
+    w->fd = fd;
+    w->conobj = conobj;
+    w->con = con;
+    w->port = 0;
+    w->accept = w->read = w->drained = R_NilValue;
+    w->offset = w->queued = 0;
+    w->events = 0;
+    w->paused = false;
+    SockWatches[fd] = w;
+    return w;
+}
+
+/* Register with epoll the events the loop needs to know about. */
+static void sockloop_update(Rsockwatch w)
+{
+    int events = 0;
+    if((w->accept != R_NilValue && !w->paused) || w->read != R_NilValue)
+	events |= SOCKLOOP_READ;
+    if(w->queued > 0)
+	events |= SOCKLOOP_WRITE;
+#ifdef HAVE_EPOLL
+    if(events == w->events) return;
+    struct epoll_event ev;
+    ev.events = ((events & SOCKLOOP_READ) ? EPOLLIN : 0)
+	| ((events & SOCKLOOP_WRITE) ? EPOLLOUT : 0);
+    ev.data.fd = w->fd;
+    int op = (w->events == 0 ? EPOLL_CTL_ADD
+	      : (events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD));
+    if(epoll_ctl(SockLoopFd, op, w->fd, &ev) < 0
+       && !(op == EPOLL_CTL_ADD && errno == EEXIST))
+	warning(_("cannot watch socket: %s"), strerror(errno));
+#endif
+    w->events = events;
+}
+
+static void sockloop_remove(Rsockwatch w)
+{
+#ifdef HAVE_EPOLL
+    if(w->events) {
+	struct epoll_event ev;
+	epoll_ctl(SockLoopFd, EPOLL_CTL_DEL, w->fd, &ev);
+    }
+#endif
+    SockWatches.erase(w->fd);
+    delete w;
+}
+
+/* Called when a socket connection is closed.  This frees a
+   connection, so listeners paused for want of one accept again. */
+static void sockloop_forget(Rconnection con)
+{
+    Rsockconn scp = RHO_S_CAST(Rsockconn, con->connprivate);
+    Rsockwatch w = sockloop_watch(scp->fd);
+    if(w && w->con == con) sockloop_remove(w);
+    for(std::map<int, Rsockwatch>::iterator it = SockWatches.begin();
+	it != SockWatches.end(); ++it)
+	if(it->second->paused) {
+	    it->second->paused = false;
+	    sockloop_update(it->second);
+	}
+}
+
+static void sockloop_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0
+       || fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)
+	error(_("cannot make socket non-blocking: %s"), strerror(errno));
+}
+
+static Rsockwatch sockloop_conwatch(SEXP sock)
+{
+    if(!inherits(sock, "sockconn"))
+	error(_("not a socket connection"));
+    Rconnection con = getConnection(asInteger(sock));
+    if(strcmp(con->connclass, "sockconn") != 0 || !con->isopen)
+	error(_("not an open socket connection"));
+    Rsockconn scp = RHO_S_CAST(Rsockconn, con->connprivate);
+    Rsockwatch w = sockloop_watch(scp->fd);
+    if(w && w->con != con) {
+	/* a stale entry for a descriptor since reused */
+	sockloop_remove(w);
+	w = nullptr;
+    }
+    if(!w) {
+	sockloop_nonblocking(scp->fd);
+	con->blocking = FALSE;
+	w = sockloop_add(scp->fd, sock, con);
+    }
+    return w;
+}
+
+/* Make a socket connection for a socket returned by accept(), as
+   sock_open() does for a blocking server socket. */
+static SEXP sockloop_newconn(int fd, const char *host, int port)
+{
+    SEXP ans, connclass;
+    Rconnection con;
+    int ncon;
+
+    try {
+	sockloop_nonblocking(fd);
+	ncon = NextConnection();
+	con = R_newsock(host, port, 1, "a+b", 60);
+    }
+    catch (...) {
+	close(fd);
+	throw;
+    }
+    Connections[ncon] = con;
+    Rsockconn scp = RHO_S_CAST(Rsockconn, con->connprivate);
+    scp->fd = fd;
+    scp->pstart = scp->pend = scp->inbuf;
+    sprintf(con->description, "<-%s:%d", host, port);
+    con->isopen = TRUE;
+    con->text = FALSE;
+    con->blocking = FALSE;
+    set_iconv(con);
+    con->save = -1000;
+    con->ex_ptr = PROTECT(R_MakeExternalPtr(con->id, install("connection"), R_NilValue));
+
+    PROTECT(ans = ScalarInteger(ncon));
+    PROTECT(connclass = allocVector(STRSXP, 2));
+    SET_STRING_ELT(connclass, 0, mkChar("sockconn"));
+    SET_STRING_ELT(connclass, 1, mkChar("connection"));
+    classgets(ans, connclass);
+    setAttrib(ans, R_ConnIdSymbol, RHO_S_CAST(SEXP, con->ex_ptr));
+    R_RegisterCFinalizerEx(RHO_S_CAST(SEXP, con->ex_ptr), conFinalizer, FALSE);
+    UNPROTECT(3);
+    return ans;
+}
+
+static void sockloop_call(SEXP fun, SEXP arg)
+{
+    SEXP call;
+    PROTECT(call = lang2(fun, arg));
+    eval(call, R_GlobalEnv);
+    UNPROTECT(1);
+}
+
+/* Write as much of the queued output as the socket will take.
+   Returns TRUE if the queue has just been emptied. */
+static Rboolean sockloop_flush(Rsockwatch w)
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    if(w->queued == 0) return FALSE;
+    while(w->queued > 0) {
+	struct iovec iov[SOCKLOOP_MAXIOV];
+	struct msghdr msg;
+	size_t off = w->offset;
+	int n = 0;
+	for(std::deque<std::string>::iterator it = w->queue.begin();
+	    it != w->queue.end() && n < SOCKLOOP_MAXIOV; ++it, ++n) {
+	    iov[n].iov_base = const_cast<char *>(it->data()) + off;
+	    iov[n].iov_len = it->size() - off;
+	    off = 0;
+	}
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = n;
+	ssize_t res = sendmsg(w->fd, &msg, flags);
+	if(res < 0) {
+	    if(errno == EINTR) continue;
+	    if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+	    warning(_("discarding output to socket: %s"), strerror(errno));
+	    w->queue.clear();
+	    w->offset = w->queued = 0;
+	    break;
+	}
+	w->queued -= res;
+	size_t done = res;
+	while(done > 0) {
+	    size_t left = w->queue.front().size() - w->offset;
+	    if(done < left) {
+		w->offset += done;
+		break;
+	    }
+	    done -= left;
+	    w->queue.pop_front();
+	    w->offset = 0;
+	}
+    }
+    return RHOCONSTRUCT(Rboolean, w->queued == 0);
+}
+
+static int sockloop_accept(Rsockwatch w)
+{
+    int ncalls = 0, lfd = w->fd;
+    for(;;) {
+	struct sockaddr_in peer;
+	socklen_t len = sizeof(peer);
+	int fd = accept(lfd, reinterpret_cast<struct sockaddr *>(&peer), &len);
+	if(fd < 0) {
+	    if(errno == EINTR) continue;
+	    break;  /* EAGAIN: no more pending connections */
+	}
+	SEXP con;
+	try {
+	    con = sockloop_newconn(fd, inet_ntoa(peer.sin_addr), w->port);
+	}
+	catch (...) {
+	    /* Otherwise the error would recur each time round the loop,
+	       as the listener would still be readable. */
+	    w->paused = true;
+	    sockloop_update(w);
+	    throw;
+	}
+	PROTECT(con);
+	sockloop_call(w->accept, con);
+	UNPROTECT(1);
+	ncalls++;
+	/* the callback may have stopped the listener */
+	if(sockloop_watch(lfd) != w) break;
+    }
+    return ncalls;
+}
+
+/* Act on the events reported for a socket, returning the number of
+   callbacks run. */
+static int sockloop_dispatch(int fd, int events)
+{
+    Rsockwatch w = sockloop_watch(fd);
+    int ncalls = 0;
+
+    if(!w) return 0;
+    if(w->con == nullptr)
+	return (events & SOCKLOOP_READ) ? sockloop_accept(w) : 0;
+    if(events & SOCKLOOP_WRITE) {
+	if(sockloop_flush(w) && w->drained != R_NilValue) {
+	    sockloop_call(w->drained, w->conobj);
+	    ncalls++;
+	}
+	if(sockloop_watch(fd) != w) return ncalls;
+	sockloop_update(w);
+    }
+    if((events & SOCKLOOP_READ) && w->read != R_NilValue) {
+	sockloop_call(w->read, w->conobj);
+	ncalls++;
+	if(sockloop_watch(fd) == w && w->read != R_NilValue) {
+	    Rsockconn scp = RHO_S_CAST(Rsockconn, w->con->connprivate);
+	    if(scp->pstart < scp->pend) SockBuffered.push_back(fd);
+	}
+    }
+    return ncalls;
+}
+
+/* Wait up to timeout seconds (indefinitely if negative) for events,
+   and dispatch them.  Returns the number of callbacks run. */
+static int sockloop_run(double timeout)
+{
+    std::vector<std::pair<int, int> > ready;
+    double used = 0.0;
+
+    if(SockLoopBusy)
+	error(_("the socket event loop is already running"));
+    if(SockWatches.empty()) return 0;
+    if(!SockBuffered.empty()) timeout = 0;
+    for(;;) {
+	/* wait in slices, so that the wait can be interrupted */
+	int wait = 100;
+	if(timeout >= 0) {
+	    double left = timeout - used;
+	    wait = (left <= 0.0) ? 0 : (left < 0.1 ? int(1e3 * left) : 100);
+	}
+#ifdef HAVE_EPOLL
+	struct epoll_event evs[64];
+	int n = epoll_wait(SockLoopFd, evs, 64, wait);
+	if(n < 0 && errno != EINTR)
+	    error(_("socket event loop failed: %s"), strerror(errno));
+	for(int i = 0; i < n; i++) {
+	    int events = 0;
+	    if(evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+		events |= SOCKLOOP_READ;
+	    if(evs[i].events & (EPOLLOUT | EPOLLERR))
+		events |= SOCKLOOP_WRITE;
+	    ready.push_back(std::make_pair(int(evs[i].data.fd), events));
+	}
+#else
+	std::vector<struct pollfd> fds;
+	for(std::map<int, Rsockwatch>::iterator it = SockWatches.begin();
+	    it != SockWatches.end(); ++it) {
+	    sockloop_update(it->second);
+	    if(it->second->events == 0) continue;
+	    struct pollfd p;
+	    p.fd = it->first;
+	    p.events = ((it->second->events & SOCKLOOP_READ) ? POLLIN : 0)
+		| ((it->second->events & SOCKLOOP_WRITE) ? POLLOUT : 0);
+	    p.revents = 0;
+	    fds.push_back(p);
+	}
+	int n = poll(fds.empty() ? nullptr : &fds[0], fds.size(), wait);
+	if(n < 0 && errno != EINTR)
+	    error(_("socket event loop failed: %s"), strerror(errno));
+	for(size_t i = 0; n > 0 && i < fds.size(); i++) {
+	    int events = 0;
+	    if(fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+		events |= SOCKLOOP_READ;
+	    if(fds[i].revents & (POLLOUT | POLLERR))
+		events |= SOCKLOOP_WRITE;
+	    if(events) ready.push_back(std::make_pair(fds[i].fd, events));
+	}
+#endif
+	for(size_t i = 0; i < SockBuffered.size(); i++)
+	    ready.push_back(std::make_pair(SockBuffered[i], SOCKLOOP_READ));
+	SockBuffered.clear();
+	if(!ready.empty()) break;
+	used += wait * 1e-3;
+	if(timeout >= 0 && used >= timeout) return 0;
+	R_CheckUserInterrupt();
+    }
+
+    int ncalls = 0;
+    SockLoopBusy = TRUE;
+    try {
+	for(size_t i = 0; i < ready.size(); i++)
+	    ncalls += sockloop_dispatch(ready[i].first, ready[i].second);
+    }
+    catch (...) {
+	SockLoopBusy = FALSE;
+	throw;
+    }
+    SockLoopBusy = FALSE;
+    return ncalls;
+}
+
+#ifdef HAVE_EPOLL
+static void sockloop_run_(void *data)
+{
+    sockloop_run(0);
+}
+
+/* Dispatch events when R services its input handlers.  Callbacks
+   are run as by the prompt, so an error does not escape into the
+   code that was waiting. */
+/* The loop is driven from R's input handlers rather than from
+   R_ProcessEvents(): the latter is also reached through
+   R_CheckUserInterrupt() in the middle of arbitrary C code, where it
+   is not safe to run R callbacks. */
+static void sockloop_input_handler(void *data)
+{
+    if(SockLoopBusy) return;
+    R_ToplevelExec(sockloop_run_, nullptr);
+}
+#endif
+
+/* socketListen(port, accept) */
+SEXP attribute_hidden do_socklisten(/*const*/ Expression* call, const BuiltInFunction* op, RObject* port_, RObject* accept_)
+{
+    int port = asInteger(port_), one = 1;
+    struct sockaddr_in addr;
+    SEXP ans, klass;
+
+    if(port == NA_INTEGER || port < 0 || port > 65535)
+	error(_("invalid '%s' argument"), "port");
+    if(!isFunction(accept_))
+	error(_("invalid '%s' argument"), "accept");
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+	error(_("cannot create socket: %s"), strerror(errno));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<unsigned short>(port));
+    if(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0
+       || listen(fd, SOMAXCONN) < 0) {
+	int err = errno;
+	close(fd);
+	error(_("cannot listen on port %d: %s"), port, strerror(err));
+    }
+    try {
+	sockloop_nonblocking(fd);
+    }
+    catch (...) {
+	close(fd);
+	throw;
+    }
+
+    PROTECT(ans = ScalarInteger(fd));
+    PROTECT(klass = mkString("socketListener"));
+    classgets(ans, klass);
+    Rsockwatch w = sockloop_add(fd, R_NilValue, nullptr);
+    w->port = port;
+    sockloop_set(&w->accept, accept_);
+    sockloop_update(w);
+    UNPROTECT(2);
+    return ans;
+}
+
+/* socketUnlisten(listener) */
+SEXP attribute_hidden do_sockunlisten(/*const*/ Expression* call, const BuiltInFunction* op, RObject* listener_)
+{
+    Rsockwatch w = nullptr;
+    if(inherits(listener_, "socketListener"))
+	w = sockloop_watch(asInteger(listener_));
+    if(!w || w->con != nullptr)
+	error(_("not an active socket listener"));
+    int fd = w->fd;
+    sockloop_remove(w);
+    close(fd);
+    return R_NilValue;
+}
+
+/* socketCallbacks(con, read, drained) */
+SEXP attribute_hidden do_sockcallbacks(/*const*/ Expression* call, const BuiltInFunction* op, RObject* con_, RObject* read_, RObject* drained_)
+{
+    Rsockwatch w = sockloop_conwatch(con_);
+    sockloop_set(&w->read, read_);
+    sockloop_set(&w->drained, drained_);
+    sockloop_update(w);
+    return R_NilValue;
+}
+
+/* socketQueue(con, data) */
+SEXP attribute_hidden do_sockqueue(/*const*/ Expression* call, const BuiltInFunction* op, RObject* con_, RObject* data_)
+{
+    std::string chunk;
+
+    if(TYPEOF(data_) == RAWSXP)
+	chunk.assign(reinterpret_cast<const char *>(RAW(data_)), XLENGTH(data_));
+    else if(isString(data_)) {
+	const void *vmax = vmaxget();
+	for(R_xlen_t i = 0; i < XLENGTH(data_); i++) {
+	    chunk += translateChar(STRING_ELT(data_, i));
+	    chunk += '\n';
+	}
+	vmaxset(vmax);
+    } else
+	error(_("invalid '%s' argument"), "data");
+    Rsockwatch w = sockloop_conwatch(con_);
+    if(!chunk.empty()) {
+	w->queued += chunk.size();
+	w->queue.push_back(std::string());
+	w->queue.back().swap(chunk);
+	sockloop_update(w);
+    }
+    return ScalarReal(double(w->queued));
+}
+
+/* socketRunEvents(timeout) */
+SEXP attribute_hidden do_sockrunevents(/*const*/ Expression* call, const BuiltInFunction* op, RObject* timeout_)
+{
+    double timeout = asReal(timeout_);
+    if(ISNAN(timeout))
+	error(_("invalid '%s' argument"), "timeout");
+    return ScalarInteger(sockloop_run(timeout));
+}
+
+#else /* not Unix */
+
+static void sockloop_forget(Rconnection con)
+{
+}
+
+static void NORET sockloop_unsupported(void)
+{
+    error(_("socket event loops are not supported on this platform"));
+}
+
+SEXP attribute_hidden do_socklisten(/*const*/ Expression* call, const BuiltInFunction* op, RObject* port_, RObject* accept_)
+{
+    sockloop_unsupported();
+}
+
+SEXP attribute_hidden do_sockunlisten(/*const*/ Expression* call, const BuiltInFunction* op, RObject* listener_)
+{
+    sockloop_unsupported();
+}
+
+SEXP attribute_hidden do_sockcallbacks(/*const*/ Expression* call, const BuiltInFunction* op, RObject* con_, RObject* read_, RObject* drained_)
+{
+    sockloop_unsupported();
+}
+
+SEXP attribute_hidden do_sockqueue(/*const*/ Expression* call, const BuiltInFunction* op, RObject* con_, RObject* data_)
+{
+    sockloop_unsupported();
+}
+
+SEXP attribute_hidden do_sockrunevents(/*const*/ Expression* call, const BuiltInFunction* op, RObject* timeout_)
+{
+    sockloop_unsupported();
+}
+#endif
+
 /* ------------------- unz connections  --------------------- */
 
 /* see dounzip.c for the details */
@@ -3322,6 +4227,8 @@ SEXP attribute_hidden do_isseekable(/*const*/ Expression* call, const BuiltInFun
 
 static void con_close1(Rconnection con)
 {
+    if(con->isopen && strcmp(con->connclass, "sockconn") == 0)
+	sockloop_forget(con);
     if(con->isopen) con->close(con);
     if(con->isGzcon) {
 	Rgzconn priv = RHO_S_CAST(Rgzconn, con->connprivate);
@@ -4798,6 +5705,8 @@ switch_or_tee_stdout(int icon, int closeOnExit, int tee)
 		    con->close(con);
 		else if (SinkConsClose[R_SinkNumber + 1] == 2) /* destroy it */
 		    con_destroy(icon);
+		else /* e.g. so that a text connection updates its variable */
+		    con->fflush(con);
 	    }
 	}
     }
@@ -111,25 +111,56 @@ static void setFileTime(const char *fn, tm_unz tmu_date)
 }
 #endif
 
-#define BUF_SIZE 4096
+/* Extraction of several entries proceeds in two stages.  First the
+   entries are located, and the names of the files to be written are
+   worked out and their directories made, in the main thread.  Then
+   the files are decompressed and written by up to ZIP_THREADS
+   threads, each with its own handle on the zip file, which take
+   entries in turn.  The second stage does not use the R API; errors
+   are recorded in the entries and reported afterwards. */
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BUF_SIZE (1 << 20)
+/* Most threads used to extract files */
+#define ZIP_THREADS 8
+/* Extract in parallel only if the files hold at least this much */
+#define ZIP_PARALLEL_SIZE (4 << 20)
+
+namespace {
+    struct ZipEntry {
+	std::string outname;
+	unz64_file_pos pos;
+	unz_file_info64 info;
+	bool isdir;
+	int err;		/* result of extraction */
+	int errnum;		/* errno if the file could not be opened */
+    };
+}
+
+/* Set up *entry for the current file of uf, making any directories
+   needed. */
 static int
-extract_one(unzFile uf, const char *const dest, const char * const filename,
-	    SEXP names, int *nnames, int overwrite, int junk, int setTime)
+prepare_one(unzFile uf, const char *const dest, const char * const filename,
+	    int overwrite, int junk, ZipEntry *entry)
 {
     int err = UNZ_OK;
-    FILE *fout;
-    char  outname[PATH_MAX], dirs[PATH_MAX], buf[BUF_SIZE], *p, *pp;
+    char  outname[PATH_MAX], dirs[PATH_MAX], *p, *pp;
     char *fn, fn0[PATH_MAX];
 
-    err = unzOpenCurrentFile(uf);
-    if (err != UNZ_OK) return err;
     if (strlen(dest) > PATH_MAX - 1) return 1;
     strcpy(outname, dest);
     strcat(outname, FILESEP);
-    unz_file_info64 file_info;
     char filename_inzip[PATH_MAX];
-    err = unzGetCurrentFileInfo64(uf, &file_info, filename_inzip,
+    err = unzGetCurrentFileInfo64(uf, &entry->info, filename_inzip,
 				  sizeof(filename_inzip), nullptr, 0, nullptr, 0);
+    if (err != UNZ_OK) return err;
+    err = unzGetFilePos64(uf, &entry->pos);
+    if (err != UNZ_OK) return err;
     fn = filename_inzip; /* might be UTF-8 ... */
     if (filename) {
 	if (strlen(dest) + strlen(filename) > PATH_MAX - 2) return 1;
@@ -149,8 +180,11 @@ extract_one(unzFile uf, const char *const dest, const char * const filename,
 #ifdef Win32
     R_fixslash(outname); /* ensure path separator is / */
 #endif
+    entry->err = UNZ_OK;
+    entry->errnum = 0;
     p = outname + strlen(outname) - 1;
-    if (*p == '/') { /* Directories are stored with trailing slash */
+    entry->isdir = (*p == '/');
+    if (entry->isdir) { /* Directories are stored with trailing slash */
 	if (!junk) {
 	    *p = '\0';
 	    if (!R_FileExists(outname)) {
@@ -175,36 +209,46 @@ extract_one(unzFile uf, const char *const dest, const char * const filename,
 	    if (!R_FileExists(dirs)) R_mkdir(dirs);
 	    pp = p + 1;
 	}
-	/* Rprintf("extracting %s\n", outname); */
 	if (!overwrite && R_FileExists(outname)) {
 	    warning(_(" not overwriting file '%s"), outname);
 	}
-	fout = R_fopen(outname, "wb");
-	int serrno = errno;
-	if (!fout) {
-	    unzCloseCurrentFile(uf);
-	    error(_("cannot open file '%s': %s"), outname, strerror(serrno));
-	    return 3;		/* not reached */
-	}
-	while (1) {
-	    err = unzReadCurrentFile(uf, buf, BUF_SIZE);
-	    /* Rprintf("read %d bytes\n", err); */
-	    if (err <= 0) break;
-	    if (fwrite(buf, err, 1, fout) != 1) { err = -200; break; }
-	    if (err < BUF_SIZE) { err = 0; break; }
-	}
-	fclose(fout);
-	SET_STRING_ELT(names, (*nnames)++, mkChar(outname));
     }
-    unzCloseCurrentFile(uf);
-#ifdef Win32
-    if (setTime) setFileTime(outname, file_info.dosDate);
-#else
-    if (setTime) setFileTime(outname, file_info.tmu_date);
-#endif
+    entry->outname = outname;
     return err;
 }
 
+/* Write the file for *entry.  Does not use the R API. */
+static void extract_one(unzFile uf, ZipEntry *entry, char *buf)
+{
+    int err;
+    FILE *fout;
+
+    err = unzGoToFilePos64(uf, &entry->pos);
+    if (err == UNZ_OK) err = unzOpenCurrentFile(uf);
+    if (err != UNZ_OK) {
+	entry->err = err;
+	return;
+    }
+    /* Rprintf("extracting %s\n", outname); */
+    errno = 0;
+    fout = R_fopen(entry->outname.c_str(), "wb");
+    if (!fout) {
+	entry->errnum = errno;
+	entry->err = 3;
+	unzCloseCurrentFile(uf);
+	return;
+    }
+    while (1) {
+	err = unzReadCurrentFile(uf, buf, BUF_SIZE);
+	/* Rprintf("read %d bytes\n", err); */
+	if (err <= 0) break;
+	if (fwrite(buf, err, 1, fout) != 1) { err = -200; break; }
+	if (err < BUF_SIZE) { err = 0; break; }
+    }
+    fclose(fout);
+    unzCloseCurrentFile(uf);
+    entry->err = err;
+}
 
 static int
 zipunzip(const char *zipname, const char *dest, int nfiles, const char **files,
@@ -213,6 +257,8 @@ zipunzip(const char *zipname, const char *dest, int nfiles, const char **files,
     int   i, err = UNZ_OK;
     unzFile uf;
     SEXP names = *pnames;
+    std::vector<ZipEntry> entries;
+    ZPOS64_T total = 0;
 
     uf = unzOpen64(zipname);
     if (!uf) return 1;
@@ -221,6 +267,99 @@ zipunzip(const char *zipname, const char *dest, int nfiles, const char **files,
 	unzGetGlobalInfo64(uf, &gi);
 	for (i = 0; i < RHOCONSTRUCT(int, gi.number_entry); i++) {
 	    if (i > 0) if ((err = unzGoToNextFile(uf)) != UNZ_OK) break;
+	    entries.emplace_back();
+	    if ((err = prepare_one(uf, dest, nullptr, overwrite, junk,
+				   &entries.back())) != UNZ_OK) {
+		entries.pop_back();
+		break;
+	    }
+	    R_CheckUserInterrupt();
+	}
+    } else {
+	for (i = 0; i < nfiles; i++) {
+	    if ((err = unzLocateFile(uf, files[i], 1)) != UNZ_OK) break;
+	    entries.emplace_back();
+	    if ((err = prepare_one(uf, dest, files[i], overwrite, junk,
+				   &entries.back())) != UNZ_OK) {
+		entries.pop_back();
+		break;
+	    }
+	    R_CheckUserInterrupt();
+	}
+    }
+
+    /* Files written twice (e.g. with junkpaths = TRUE) are written
+       in order by one thread. */
+    std::vector<std::string> outnames;
+    size_t nfile = 0;
+    for (ZipEntry& entry : entries)
+	if (!entry.isdir) {
+	    nfile++;
+	    total += entry.info.uncompressed_size;
+	    outnames.push_back(entry.outname);
+	}
+    std::sort(outnames.begin(), outnames.end());
+    bool distinct =
+	std::adjacent_find(outnames.begin(), outnames.end()) == outnames.end();
+    size_t nthreads = std::thread::hardware_concurrency();
+    if (nthreads > ZIP_THREADS) nthreads = ZIP_THREADS;
+    if (nthreads > nfile) nthreads = nfile;
+    if (!distinct || total < ZIP_PARALLEL_SIZE || nthreads < 1)
+	nthreads = 1;
+
+    /* As when extracting serially, no entry after one that fails is
+       extracted: workers stop taking entries, and any entry taken
+       after the failed one is skipped. */
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failed(entries.size());
+    std::atomic<bool> stop(false);
+    auto work = [&](unzFile zf, bool main) {
+	std::vector<char> buf(BUF_SIZE);
+	size_t k;
+	while (!stop && (k = next++) < entries.size()) {
+	    if (k > failed) break;
+	    if (!entries[k].isdir) {
+		extract_one(zf, &entries[k], buf.data());
+		if (entries[k].err != UNZ_OK) {
+		    size_t f = failed;
+		    while (k < f && !failed.compare_exchange_weak(f, k))
+			;
+		    stop = true;
+		}
+	    }
+	    if (main && R_interrupts_pending) stop = true;
+	}
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < nthreads; t++) {
+	unzFile zf = unzOpen64(zipname);
+	if (!zf) break;
+	try {
+	    threads.emplace_back([&, zf]{ work(zf, false); unzClose(zf); });
+	} catch (...) {
+	    unzClose(zf);
+	    break;
+	}
+    }
+    work(uf, true);
+    for (std::thread& thread : threads)
+	thread.join();
+    unzClose(uf);
+    R_CheckUserInterrupt();
+
+    /* Report in the order of the entries */
+    size_t done = std::min(size_t(next), entries.size());
+    int rc = UNZ_OK;
+    for (size_t k = 0; k < done; k++) {
+	ZipEntry& entry = entries[k];
+	if (entry.err == 3)
+	    error(_("cannot open file '%s': %s"), entry.outname.c_str(),
+		  strerror(entry.errnum));
+	if (entry.err != UNZ_OK) {
+	    rc = entry.err;
+	    break;
+	}
+	if (!entry.isdir) {
 	    if (*nnames+1 >= LENGTH(names)) {
 		SEXP onames = names;
 		names = allocVector(STRSXP, 2*LENGTH(names));
@@ -228,29 +367,16 @@ zipunzip(const char *zipname, const char *dest, int nfiles, const char **files,
 		PROTECT(names);
 		copyVector(names, onames);
 	    }
-	    if ((err = extract_one(uf, dest, nullptr, names, nnames, 
-				   overwrite, junk, setTime)) != UNZ_OK) break;
-#ifdef Win32
-	    R_ProcessEvents();
-#else
-	    R_CheckUserInterrupt();
-#endif
+	    SET_STRING_ELT(names, (*nnames)++, mkChar(entry.outname.c_str()));
 	}
-    } else {
-	for (i = 0; i < nfiles; i++) {
-	    if ((err = unzLocateFile(uf, files[i], 1)) != UNZ_OK) break;
-	    if ((err = extract_one(uf, dest, files[i], names, nnames,
-				   overwrite, junk, setTime)) != UNZ_OK) break;
 #ifdef Win32
-	    R_ProcessEvents();
+	if (setTime) setFileTime(entry.outname.c_str(), entry.info.dosDate);
 #else
-	    R_CheckUserInterrupt();
+	if (setTime) setFileTime(entry.outname.c_str(), entry.info.tmu_date);
 #endif
-	}
     }
     *pnames = names;
-    unzClose(uf);
-    return err;
+    return rc != UNZ_OK ? rc : err;
 }
 
 static SEXP ziplist(const char *zipname)
@@ -1556,6 +1682,43 @@ extern int ZEXPORT unzGoToNextFile (unzFile  file)
     return err;
 }
 
+extern int ZEXPORT unzGetFilePos64(unzFile file, unz64_file_pos* file_pos)
+{
+    unz64_s* s;
+
+    if (file == nullptr || file_pos == nullptr)
+	return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if (!s->current_file_ok)
+	return UNZ_END_OF_LIST_OF_FILE;
+
+    file_pos->pos_in_zip_directory  = s->pos_in_central_dir;
+    file_pos->num_of_file           = s->num_file;
+    return UNZ_OK;
+}
+
+extern int ZEXPORT unzGoToFilePos64(unzFile file,
+				    const unz64_file_pos* file_pos)
+{
+    unz64_s* s;
+    int err;
+
+    if (file == nullptr || file_pos == nullptr)
+	return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+
+    /* jump to the right spot */
+    s->pos_in_central_dir = file_pos->pos_in_zip_directory;
+    s->num_file           = file_pos->num_of_file;
+
+    /* set the current file */
+    err = unz64local_GetCurrentFileInfoInternal(file,&s->cur_file_info,
+					       &s->cur_file_info_internal,
+                                               nullptr,0,nullptr,0,nullptr,0);
+    s->current_file_ok = (err == UNZ_OK);
+    return err;
+}
+
 
 /*
   Try locate the file szFileName in the zipfile.
@@ -27,6 +27,8 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+
 #include <Defn.h>
 #include <Internal.h>
 #include <R_ext/GraphicsEngine.h>
@@ -867,20 +869,89 @@ static void clipPolyline(int n, double *x, double *y,
     CScliplines(n, x, y, gc, clipToDevice, dd);
 }
 
+/****************************************************************
+ * Level-of-detail decimation
+ ****************************************************************
+ */
+
+/* With options(graphics.decimate = TRUE), polylines and points with
+ * many more vertices than the device can resolve are thinned before
+ * they reach the device callbacks.  The result is drawn in the same
+ * pixels, to the resolution of one device unit.
+ */
+Rboolean GEdecimating(void)
+{
+    static SEXP s_decimate = nullptr;
+    if (!s_decimate) s_decimate = install("graphics.decimate");
+    return RHOCONSTRUCT(Rboolean, asLogical(GetOption1(s_decimate)) == TRUE);
+}
+
+/* Replace each run of consecutive finite vertices lying in the same
+ * column, one device unit wide, by the first, lowest, highest and
+ * last of them, in their original order.  Because the path is
+ * connected, the vertices of a run cover the same span of the column
+ * either way.  A vertex with a non-finite coordinate ends a run and is
+ * passed through unchanged, so that the line is still broken there.
+ * The result (at most n vertices) is written to xout and yout, and
+ * its length returned.
+ */
+static int decimatePolyline(int n, const double *x, const double *y,
+			    double *xout, double *yout)
+{
+    int m = 0, i = 0;
+    while (i < n) {
+	if (!R_FINITE(x[i]) || !R_FINITE(y[i])) {
+	    xout[m] = x[i];
+	    yout[m++] = y[i++];
+	    continue;
+	}
+	double column = floor(x[i]);
+	int keep[4] = {i, i, i, i}, j;
+	for (j = i + 1; j < n && R_FINITE(x[j]) && R_FINITE(y[j])
+		 && floor(x[j]) == column; j++) {
+	    if (y[j] < y[keep[1]]) keep[1] = j;
+	    if (y[j] > y[keep[2]]) keep[2] = j;
+	}
+	keep[3] = j - 1;
+	std::sort(keep, keep + 4);
+	for (int k = 0; k < 4; k++) {
+	    if (k > 0 && keep[k] == keep[k - 1]) continue;
+	    xout[m] = x[keep[k]];
+	    yout[m++] = y[keep[k]];
+	}
+	i = j;
+    }
+    return m;
+}
+
+/* Fewer vertices than this are always drawn as given: */
+#define DECIMATE_MIN 1000
+
 /* Draw a series of line segments. */
 /* If the device canClip, R clips to the device extent and the device
    does all other clipping */
 void GEPolyline(int n, double *x, double *y, const pGEcontext gc, pGEDevDesc dd)
 {
+    const void *vmax = nullptr;
     if (gc->lwd == R_PosInf || gc->lwd < 0.0)
 	error(_("'lwd' must be non-negative and finite"));
     if (ISNAN(gc->lwd) || gc->lty == LTY_BLANK) return;
+    /* Dashed lines are not decimated, as that would move the dashes */
+    if (n > DECIMATE_MIN && gc->lty == LTY_SOLID && GEdecimating()) {
+	vmax = vmaxget();
+	double *xd = reinterpret_cast<double *>(R_alloc(n, sizeof(double)));
+	double *yd = reinterpret_cast<double *>(R_alloc(n, sizeof(double)));
+	n = decimatePolyline(n, x, y, xd, yd);
+	x = xd;
+	y = yd;
+    }
     if (dd->dev->canClip) {
 	clipPolyline(n, x, y, gc, 1, dd);  /* clips to device extent
 						  then draws */
     }
     else
 	clipPolyline(n, x, y, gc, 0, dd);
+    if (vmax) vmaxset(vmax);
 }
 
 /****************************************************************
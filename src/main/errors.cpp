@@ -54,6 +54,7 @@
 #include "rho/ListVector.hpp"
 #include "rho/ReturnException.hpp"
 #include "rho/StackChecker.hpp"
+#include "rho/WeakRef.hpp"
 #include "rho/strutil.hpp"
 
 using namespace std;
@@ -137,8 +138,10 @@ void R_CheckUserInterrupt(void)
 #endif
 
     /* finalizers are run here since this should only be called at
-       points where running random code should be sate */
-    R_RunPendingFinalizers();
+       points where running random code should be sate.  They are run
+       in batches, so that a collection that frees very many
+       finalizable objects does not stall this call. */
+    WeakRef::runFinalizers(WeakRef::finalizerBatchSize);
 }
 
 void onintr()
@@ -307,7 +310,7 @@ static void vwarningcall_dflt(SEXP call, const char *format, va_list ap)
 	return;
     }
 
-    w = asInteger(GetOption1(install("warn")));
+    w = R_GetOptionWarn();
 
     if( w == NA_INTEGER ) /* set to a sensible value */
 	w = 0;
@@ -281,7 +281,10 @@ static uLong getLong (gz_stream *s)
     return x;
 }
 
-static int R_gzread (gzFile file, voidp buf, unsigned len)
+/* As R_gzread below, but instead of giving warnings sets *failed to
+   Z_DATA_ERROR or Z_ERRNO, so that it can be used from other threads
+   than the main one. */
+static int R_gzread_quiet (gzFile file, voidp buf, unsigned len, int *failed)
 {
     gz_stream *s = (gz_stream*) file;
     Bytef *start = (Bytef*) buf; /* starting point for crc computation */
@@ -289,11 +292,8 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
 
     if (s == NULL || s->mode != 'r') return Z_STREAM_ERROR;
 
-    if (s->z_err == Z_DATA_ERROR) {
-	warning("invalid or incomplete compressed data");
-	return -1;
-    } else if(s->z_err == Z_ERRNO) {
-	warning("error reading the file");
+    if (s->z_err == Z_DATA_ERROR || s->z_err == Z_ERRNO) {
+	*failed = s->z_err;
 	return -1;
     }
     if (s->z_err == Z_STREAM_END) return 0;  /* EOF */
@@ -350,7 +350,7 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
             start = s->stream.next_out;
 
             if (getLong(s) != s->crc) {
-		warning("invalid or incomplete compressed data");
+		*failed = Z_DATA_ERROR;
                 s->z_err = Z_DATA_ERROR;
             } else {
                 (void)getLong(s);
@@ -371,15 +371,27 @@ static int R_gzread (gzFile file, voidp buf, unsigned len)
 
     if (len == s->stream.avail_out &&
         (s->z_err == Z_DATA_ERROR || s->z_err == Z_ERRNO)) {
-	if(s->z_err == Z_DATA_ERROR)
-	    warning("invalid or incomplete compressed data");
-	else if(s->z_err == Z_ERRNO)
-	    warning("error reading the file");
+	*failed = s->z_err;
 	return -1;
     }
     return (int)(len - s->stream.avail_out);
 }
 
+static void R_gzwarn (int failed)
+{
+    if (failed == Z_DATA_ERROR)
+	warning("invalid or incomplete compressed data");
+    else if (failed == Z_ERRNO)
+	warning("error reading the file");
+}
+
+static int R_gzread (gzFile file, voidp buf, unsigned len)
+{
+    int failed = Z_OK, res = R_gzread_quiet(file, buf, len, &failed);
+    R_gzwarn(failed);
+    return res;
+}
+
 /* for devPS.c */
 char *R_gzgets(gzFile file, char *buf, int len)
 {
@@ -219,17 +219,26 @@ SEXP attribute_hidden do_logic2(SEXP call, SEXP op, SEXP args, SEXP env)
 #define _OP_ALL 1
 #define _OP_ANY 2
 
+/* The values are scanned in blocks, without branching on each
+   element, stopping after the first block containing a deciding
+   value. */
+#define CHECK_BLOCK 1024
+
 static Logical checkValues(int op, int na_rm, int *x, R_xlen_t n)
 {
-    R_xlen_t i;
+    /* The value that decides the result: */
+    int decider = (op == _OP_ANY) ? TRUE : FALSE;
     int has_na = 0;
-    for (i = 0; i < n; i++) {
-//	if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
-        if (!na_rm && x[i] == NA_LOGICAL) has_na = 1;
-        else {
-            if (x[i] == TRUE && op == _OP_ANY) return true;
-            if (x[i] == FALSE && op == _OP_ALL) return false;
+    for (R_xlen_t start = 0; start < n; start += CHECK_BLOCK) {
+	R_xlen_t end = std::min(n, start + CHECK_BLOCK);
+	int found = 0, na = 0;
+	for (R_xlen_t i = start; i < end; i++) {
+	    found |= (x[i] == decider);
+	    na |= (x[i] == NA_LOGICAL);
 	}
+	if (found)
+	    return Logical(decider);
+	has_na |= (na & !na_rm);
     }
     switch (op) {
     case _OP_ANY:
@@ -241,6 +250,7 @@ static Logical checkValues(int op, int na_rm, int *x, R_xlen_t n)
     }
     return Logical::NA(); /* -Wall */
 }
+#undef CHECK_BLOCK
 
 /* all, any */
 SEXP attribute_hidden do_logic3(SEXP call, SEXP op, SEXP args, SEXP env)
@@ -42,6 +42,7 @@
 #include "rho/ExpressionVector.hpp"
 #include "rho/FunctionContext.hpp"
 #include "rho/GCManager.hpp"
+#include "rho/GCNodeAllocator.hpp"
 #include "rho/IntVector.hpp"
 #include "rho/Frame.hpp"
 #include "rho/LogicalVector.hpp"
@@ -55,6 +56,10 @@
 #include <R_ext/Rdynload.h>
 #include "Rdynpriv.h"
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h> /* for sysconf */
+#endif
+
 using namespace rho;
 
 #if defined(Win32)
@@ -185,6 +190,22 @@ void attribute_hidden get_current_mem(size_t *smallvsize,
     return;
 }
 
+/* Resident set size of the process in bytes, or -1 if unknown. */
+static double residentBytes(void)
+{
+#if defined(Unix) && defined(__linux__)
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+	unsigned long size, resident;
+	int n = fscanf(fp, "%lu %lu", &size, &resident);
+	fclose(fp);
+	if (n == 2)
+	    return double(resident) * double(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return -1;
+}
+
 SEXP attribute_hidden do_gc(/*const*/ Expression* call, const BuiltInFunction* op, RObject* verbose_, RObject* reset_)
 {
     std::ostream* report_os
@@ -193,7 +214,7 @@ SEXP attribute_hidden do_gc(/*const*/ Expression* call, const BuiltInFunction* o
     GCManager::gc();
     R_RunPendingFinalizers();
     GCManager::setReporting(report_os);
-    GCStackRoot<> value(allocVector(REALSXP, 6));
+    GCStackRoot<> value(allocVector(REALSXP, 8));
     REAL(value)[0] = GCNode::numNodes();
     REAL(value)[1] = NA_REAL;
     REAL(value)[2] = GCManager::maxNodes();
@@ -201,10 +222,67 @@ SEXP attribute_hidden do_gc(/*const*/ Expression* call, const BuiltInFunction* o
     REAL(value)[3] = 0.1*ceil(10. * MemoryBank::bytesAllocated()/Mega);
     REAL(value)[4] = 0.1*ceil(10. * GCManager::triggerLevel()/Mega);
     REAL(value)[5] = 0.1*ceil(10. * GCManager::maxBytes()/Mega);
+    double resident = residentBytes();
+    REAL(value)[6] = resident < 0 ? NA_REAL : 0.1*ceil(10. * resident/Mega);
+    REAL(value)[7] = 0.1*ceil(10. * GCNodeAllocator::releasedBytes()/Mega);
     if (reset_max) GCManager::resetMaxTallies();
     return value;
 }
 
+/* .Internal(gc.events(reset)): the records of recent collections, as a
+   list of columns which gc.events() turns into a data frame. */
+SEXP attribute_hidden do_gcevents(/*const*/ Expression* call, const BuiltInFunction* op, RObject* reset_)
+{
+    static const char* names[] = {
+	"gc", "time", "kind", "trigger", "pause", "root_scan", "mark",
+	"sweep", "bytes_before", "bytes_after", "nodes_before",
+	"nodes_after", "released_bytes", "table_buckets",
+	"insert_collisions", "search_collisions", "erase_collisions",
+	"freelists", ""
+    };
+    int reset = asLogical(reset_);
+    if (reset == NA_LOGICAL)
+	error(_("invalid '%s' argument"), "reset");
+
+    const std::deque<GCManager::Event>& events = GCManager::events();
+    R_xlen_t n = R_xlen_t(events.size());
+    GCStackRoot<> ans(mkNamed(VECSXP, names));
+    SET_VECTOR_ELT(ans, 0, allocVector(INTSXP, n));
+    SET_VECTOR_ELT(ans, 2, allocVector(STRSXP, n));
+    SET_VECTOR_ELT(ans, 3, allocVector(STRSXP, n));
+    SET_VECTOR_ELT(ans, 17, allocVector(VECSXP, n));
+    for (int col = 1; col < 17; ++col)
+	if (col != 2 && col != 3)
+	    SET_VECTOR_ELT(ans, col, allocVector(REALSXP, n));
+
+    R_xlen_t i = 0;
+    for (const GCManager::Event& event : events) {
+	INTEGER(VECTOR_ELT(ans, 0))[i] = int(event.number);
+	REAL(VECTOR_ELT(ans, 1))[i] = event.time;
+	SET_STRING_ELT(VECTOR_ELT(ans, 2), i,
+		       mkChar(event.full ? "full" : "lite"));
+	SET_STRING_ELT(VECTOR_ELT(ans, 3), i, mkChar(event.trigger));
+	const double values[] = {
+	    event.pause, event.root_scan, event.mark, event.sweep,
+	    double(event.bytes_before), double(event.bytes_after),
+	    double(event.nodes_before), double(event.nodes_after),
+	    double(event.released_bytes), double(event.table_buckets),
+	    double(event.insert_collisions), double(event.search_collisions),
+	    double(event.erase_collisions)
+	};
+	for (int k = 0; k < 13; ++k)
+	    REAL(VECTOR_ELT(ans, k + 4))[i] = values[k];
+	SEXP freelists = allocVector(REALSXP, event.freelists.size());
+	SET_VECTOR_ELT(VECTOR_ELT(ans, 17), i, freelists);
+	std::copy(event.freelists.begin(), event.freelists.end(),
+		  REAL(freelists));
+	++i;
+    }
+    if (reset)
+	GCManager::clearEvents();
+    return ans;
+}
+
 
 static double gctimes[5], gcstarttimes[5];
 static Rboolean gctime_enabled = FALSE;
@@ -369,6 +447,55 @@ SEXP allocVector3(SEXPTYPE type, R_xlen_t length, void*)
     return s;
 }
 
+/* Set elements first, ..., first + count - 1 of the generic vector
+   'list' to new vectors of the given type and length.  This is
+   equivalent to calling allocVector() for each element, but the
+   vectors are allocated in batches, which is faster when many small
+   vectors are required.
+*/
+void Rf_allocVectorsInList(SEXPTYPE type, R_xlen_t length, SEXP list,
+			   R_xlen_t first, R_xlen_t count)
+{
+    ListVector* lv = SEXP_downcast<ListVector*>(list);
+    if (first < 0 || count < 0 || std::size_t(first) > lv->size()
+	|| std::size_t(count) > lv->size() - std::size_t(first))
+	error(_("invalid range in vector allocation"));
+    ListVector::iterator out = lv->begin() + first;
+    // allocVector() reports lengths that are out of range:
+    if (length >= 0 && length <= R_XLEN_T_MAX) {
+	switch (type) {
+	case RAWSXP:
+	    RawVector::createBatch(length, count, out);
+	    return;
+	case LGLSXP:
+	    LogicalVector::createBatch(length, count, out);
+	    return;
+	case INTSXP:
+	    IntVector::createBatch(length, count, out);
+	    return;
+	case REALSXP:
+	    RealVector::createBatch(length, count, out);
+	    return;
+	case CPLXSXP:
+	    ComplexVector::createBatch(length, count, out);
+	    return;
+	case STRSXP:
+	    StringVector::createBatch(length, count, out);
+	    return;
+	case EXPRSXP:
+	    ExpressionVector::createBatch(length, count, out);
+	    return;
+	case VECSXP:
+	    ListVector::createBatch(length, count, out);
+	    return;
+	default:
+	    break;
+	}
+    }
+    for (R_xlen_t i = 0; i < count; ++i)
+	SET_VECTOR_ELT(list, first + i, allocVector(type, length));
+}
+
 static SEXP allocFormalsList(int nargs, ...) {
     SEXP res = R_NilValue;
     SEXP n;
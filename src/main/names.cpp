@@ -563,10 +563,13 @@ new BuiltInFunction("print.default",do_printdefault,0,	111,	9,	{PP_FUNCALL, PREC
 new BuiltInFunction("print.function",do_printfunction,0,	111,	-1,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("prmatrix",	do_prmatrix,	0,	111,	6,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("gc",		do_gc,		0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("gc.events",	do_gcevents,	0,	11,	1,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("gcinfo",	do_gcinfo,	0,	11,	1,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("gctorture",	do_gctorture,	0,	111,	1,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("gctorture2",	do_gctorture2,	0,	11,	3,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("memory.profile",do_memoryprofile, 0,	11,	0,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("heap.snapshot",do_heapsnapshot, 0,	11,	1,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("heap.retainers",do_heapretainers, 0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("split",	do_split,	0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("is.loaded",	do_isloaded,	0,	11,	-1,	{PP_FOREIGN, PREC_FN,	0}),
 new BuiltInFunction("recordGraphics", do_recordGraphics, 0, 211,     3,      {PP_FOREIGN, PREC_FN,	0}),
@@ -747,17 +750,35 @@ new BuiltInFunction("textConnection",do_textconnection,0,	11,     5,      {PP_FU
 new BuiltInFunction("textConnectionValue",do_textconvalue,0,11,    1,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("socketConnection",do_sockconn,0,	11,     7,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("sockSelect",do_sockselect,	0,	11,     3,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("socketListen",do_socklisten,	0,	11,     2,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("socketUnlisten",do_sockunlisten,0,	111,    1,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("socketCallbacks",do_sockcallbacks,0,	111,    3,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("socketQueue",do_sockqueue,	0,	111,    2,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("socketRunEvents",do_sockrunevents,0,	11,     1,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("getConnection",do_getconnection,0,	11,	1,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("getAllConnections",do_getallconnections,0,11, 0,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("summary.connection",do_sumconnection,0,11,    1,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("gzcon",	do_gzcon,	0,      11,     3,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("memCompress",do_memCompress,	0,	11,     2,      {PP_FUNCALL, PREC_FN,	0}),
 new BuiltInFunction("memDecompress",do_memDecompress,0,	11,     2,      {PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("mmapVector",do_mmapvector,	0,	11,     4,      {PP_FUNCALL, PREC_FN,	0}),
 
 /* Provenance Functions */
 new BuiltInFunction("provenance", do_provenance,   0,       0,     1,      {PP_FUNCALL, PREC_FN, 0}),
 new BuiltInFunction("provenance.graph", do_provenance_graph,0,11,  1,      {PP_FUNCALL, PREC_FN, 0}),
 
+/* Memoisation */
+new BuiltInFunction("memoCache",	do_memocache,	0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("memoKey",	do_memokey,	0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("memoGet",	do_memoget,	0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("memoPut",	do_memoput,	0,	111,	3,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("memoCacheInfo",do_memocacheinfo, 0,	11,	1,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("memoCacheClear",do_memocacheclear,0,	111,	1,	{PP_FUNCALL, PREC_FN,	0}),
+
+/* Incremental re-execution */
+new BuiltInFunction("recordCommand",do_recordcommand, 0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+new BuiltInFunction("bindingDigests",do_bindingdigests,0,	11,	2,	{PP_FUNCALL, PREC_FN,	0}),
+
 new BuiltInFunction("readDCF",	do_readDCF,	0,      11,     3,      {PP_FUNCALL, PREC_FN,	0}),
 
 
@@ -35,8 +35,15 @@
 
 #include "rho/ArgMatcher.hpp"
 #include "rho/Evaluator.hpp"
+#include "rho/GCManager.hpp"
+#include "rho/GCNodeAllocator.hpp"
+#include "rho/HeapSizingPolicy.hpp"
 #include "rho/StackChecker.hpp"
 
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+
 using namespace rho;
 
 /* Interface to the (polymorphous!)  options(...)  command.
@@ -98,13 +105,62 @@ static SEXP Options(void)
     return sOptions;
 }
 
-static SEXP FindTaggedItem(SEXP lst, SEXP tag)
-{
-    for ( ; lst != R_NilValue ; lst = CDR(lst)) {
-	if (TAG(lst) == tag)
-	    return lst;
+/* The options are kept in the pairlist .Options, which is what R code
+   sees.  So that C code can look options up without walking the list,
+   the cells of the list are indexed by tag.  The index is rebuilt
+   whenever .Options is found to be a different list from the one
+   indexed (as after InitOptions()), and options_version is advanced
+   whenever any option may have changed, so that callers can cache
+   values derived from options. */
+
+namespace {
+    typedef std::unordered_map<const RObject*, PairList*> OptionIndex;
+
+    OptionIndex& optionIndex()
+    {
+	static OptionIndex* index = new OptionIndex;
+	return *index;
+    }
+
+    // The list indexed.  It is protected so that its address cannot be
+    // reused by a new .Options while the index is stale.
+    GCRoot<>& indexedOptions()
+    {
+	static GCRoot<>* indexed = new GCRoot<>(nullptr);
+	return *indexed;
+    }
+
+    unsigned int options_version = 1;
+
+    SEXP OptionsList()
+    {
+	SEXP opt = SYMVALUE(Options());
+	if (!isList(opt)) error(_("corrupted options list"));
+	if (opt != indexedOptions()) {
+	    OptionIndex& index = optionIndex();
+	    index.clear();
+	    for (SEXP lst = opt; lst != R_NilValue; lst = CDR(lst))
+		index.emplace(TAG(lst), SEXP_downcast<PairList*>(lst));
+	    indexedOptions() = opt;
+	    ++options_version;
+	}
+	return opt;
     }
-    return R_NilValue;
+}
+
+/* The cell of .Options with the given tag, or R_NilValue. */
+static SEXP FindOption(SEXP tag)
+{
+    OptionsList();
+    const OptionIndex& index = optionIndex();
+    OptionIndex::const_iterator it = index.find(tag);
+    return (it == index.end() ? R_NilValue : it->second);
+}
+
+unsigned int attribute_hidden R_OptionsVersion(void)
+{
+    OptionsList();
+    return options_version;
 }
 
 static SEXP makeErrorCall(SEXP fun)
@@ -124,16 +180,32 @@ SEXP GetOption(SEXP tag, SEXP rho)
 
 SEXP GetOption1(SEXP tag)
 {
-    SEXP opt = SYMVALUE(Options());
-    if (!isList(opt)) error(_("corrupted options list"));
-    opt = FindTaggedItem(opt, tag);
-    return CAR(opt);
+    return CAR(FindOption(tag));
+}
+
+/* An option's value as converted by asInteger(), cached until the
+   options next change. */
+struct CachedOption {
+    const char* name;
+    unsigned int version;
+    int value;
+};
+
+static int cachedOption(CachedOption* cache)
+{
+    unsigned int version = R_OptionsVersion();
+    if (cache->version != version) {
+	SEXP value = GetOption1(install(cache->name));
+	cache->value = asInteger(value);
+	cache->version = version;
+    }
+    return cache->value;
 }
 
 int GetOptionWidth(void)
 {
-    int w;
-    w = asInteger(GetOption1(install("width")));
+    static CachedOption width = {"width", 0, 0};
+    int w = cachedOption(&width);
     if (w < R_MIN_WIDTH_OPT || w > R_MAX_WIDTH_OPT) {
 	warning(_("invalid printing width, used 80"));
 	return 80;
@@ -143,8 +215,8 @@ int GetOptionWidth(void)
 
 int GetOptionDigits(void)
 {
-    int d;
-    d = asInteger(GetOption1(install("digits")));
+    static CachedOption digits = {"digits", 0, 0};
+    int d = cachedOption(&digits);
     if (d < R_MIN_DIGITS_OPT || d > R_MAX_DIGITS_OPT) {
 	warning(_("invalid printing digits, used 7"));
 	return 7;
@@ -152,6 +224,20 @@ int GetOptionDigits(void)
     return d;
 }
 
+/* Value of options("warn"), or NA_INTEGER if it is not an integer. */
+int attribute_hidden R_GetOptionWarn(void)
+{
+    static CachedOption warn = {"warn", 0, 0};
+    return cachedOption(&warn);
+}
+
+/* Value of options("scipen"), or NA_INTEGER if it is not an integer. */
+int attribute_hidden R_GetOptionScipen(void)
+{
+    static CachedOption scipen = {"scipen", 0, 0};
+    return cachedOption(&scipen);
+}
+
 attribute_hidden
 int GetOptionCutoff(void)
 {
@@ -184,10 +270,9 @@ static SEXP SetOption(SEXP tag, SEXP value)
 {
     SEXP opt, old, t;
     PROTECT(value);
-    t = opt = SYMVALUE(Options());
-    if (!isList(opt))
-	error(_("corrupted options list"));
-    opt = FindTaggedItem(opt, tag);
+    t = OptionsList();
+    opt = FindOption(tag);
+    ++options_version;
 
     /* The option is being removed. */
     if (value == R_NilValue) {
@@ -195,6 +280,7 @@ static SEXP SetOption(SEXP tag, SEXP value)
 	    if (TAG(CDR(t)) == tag) {
 		old = CAR(CDR(t));
 		SETCDR(t, CDDR(t));
+		optionIndex().erase(tag);
 		UNPROTECT(1); /* value */
 		return old;
 	    }
@@ -209,6 +295,7 @@ static SEXP SetOption(SEXP tag, SEXP value)
 	SETCDR(t, allocList(1));
 	opt = CDR(t);
 	SET_TAG(opt, tag);
+	optionIndex().emplace(tag, SEXP_downcast<PairList*>(opt));
     }
     old = CAR(opt);
     SETCAR(opt, value);
@@ -289,7 +376,8 @@ void attribute_hidden InitOptions(void)
     v = CDR(v);
 
     SET_TAG(v, install("check.bounds"));
-    SETCAR(v, ScalarLogical(0));	/* no checking */
+    R_CheckBounds = FALSE;
+    SETCAR(v, ScalarLogical(R_CheckBounds));	/* no checking */
     v = CDR(v);
 
     p = getenv("R_KEEP_PKG_SOURCE");
@@ -347,6 +435,48 @@ SEXP attribute_hidden do_getOption(SEXP call, SEXP op, SEXP args, SEXP rho)
 }
 
 
+/* Install the heap sizing policy selected by options(gc.policy),
+   with the parameters given by the other gc.* options. */
+static void setHeapSizingPolicy(void)
+{
+    SEXP policy = GetOption1(install("gc.policy"));
+    const char *name = isString(policy) ? CHAR(STRING_ELT(policy, 0))
+	: "growth";
+    if (streql(name, "pause")) {
+	double fraction = 0.05, goal = 0.01;
+	SEXP v = GetOption1(install("gc.time.fraction"));
+	if (v != R_NilValue) fraction = asReal(v);
+	v = GetOption1(install("gc.pause.goal"));
+	if (v != R_NilValue) goal = asReal(v);
+	GCManager::setHeapSizingPolicy(new PauseTimeHeapPolicy(fraction, goal));
+    }
+    else if (streql(name, "ceiling")) {
+	double limit = 0.75 * CeilingHeapPolicy::controlGroupLimit();
+	SEXP v = GetOption1(install("gc.memory.limit"));
+	if (v != R_NilValue) limit = asReal(v);
+	if (limit > 0)
+	    GCManager::setHeapSizingPolicy(new CeilingHeapPolicy(size_t(limit)));
+	else {
+	    warning(_("no memory limit found: using the \"growth\" policy"));
+	    GCManager::setHeapSizingPolicy(nullptr);
+	}
+    }
+    else GCManager::setHeapSizingPolicy(nullptr);
+}
+
+/* Set the hysteresis for releasing free memory after garbage
+   collection from options(gc.release.delay, gc.release.retain). */
+static void setReleasePolicy(void)
+{
+    double delay = 2, retain = 16 * 1024 * 1024;
+    SEXP v = GetOption1(install("gc.release.delay"));
+    if (v != R_NilValue) delay = asReal(v);
+    v = GetOption1(install("gc.release.retain"));
+    if (v != R_NilValue) retain = asReal(v);
+    if (delay > 1e9) delay = 1e9;
+    GCNodeAllocator::setReleasePolicy(unsigned(delay), size_t(retain));
+}
+
 /* This needs to manage R_Visible */
 SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
 {
@@ -427,6 +557,7 @@ SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
     }
 
     R_Visible = FALSE;
+    bool gc_options_set = false, gc_release_options_set = false;
     for (int i = 0 ; i < n ; i++) { /* i-th argument */
 	SEXP argi = R_NilValue, namei = R_NilValue;
 	switch (TYPEOF(args)) {
@@ -506,7 +637,7 @@ SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
 		if (TYPEOF(argi) != LGLSXP || LENGTH(argi) != 1)
 		    error(_("invalid value for '%s'"), CHAR(namei));
 		int k = asLogical(argi);
-		/* R_CheckBounds = k; */
+		R_CheckBounds = RHOCONSTRUCT(Rboolean, k);
 		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarLogical(k)));
 	    }
 	    else if (streql(CHAR(namei), "warn")) {
@@ -651,6 +782,52 @@ SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
 		R_CBoundsCheck = RHOCONSTRUCT(Rboolean, k);
 		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarLogical(k)));
 	    }
+	    else if (streql(CHAR(namei), "gc.policy")) {
+		if (argi != R_NilValue
+		    && (!isString(argi) || LENGTH(argi) != 1
+			|| !(streql(CHAR(STRING_ELT(argi, 0)), "growth")
+			     || streql(CHAR(STRING_ELT(argi, 0)), "pause")
+			     || streql(CHAR(STRING_ELT(argi, 0)), "ceiling"))))
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		SET_VECTOR_ELT(value, i, SetOption(tag, duplicate(argi)));
+		gc_options_set = true;
+	    }
+	    else if (streql(CHAR(namei), "gc.time.fraction")
+		     || streql(CHAR(namei), "gc.pause.goal")
+		     || streql(CHAR(namei), "gc.memory.limit")) {
+		if (argi != R_NilValue) {
+		    double x = asReal(argi);
+		    if (!R_FINITE(x) || x <= 0
+			|| (streql(CHAR(namei), "gc.time.fraction") && x >= 1))
+			error(_("invalid value for '%s'"), CHAR(namei));
+		    argi = ScalarReal(x);
+		}
+		SET_VECTOR_ELT(value, i, SetOption(tag, argi));
+		gc_options_set = true;
+	    }
+	    else if (streql(CHAR(namei), "gc.release.delay")
+		     || streql(CHAR(namei), "gc.release.retain")) {
+		if (argi != R_NilValue) {
+		    double x = asReal(argi);
+		    if (!R_FINITE(x) || x < 0)
+			error(_("invalid value for '%s'"), CHAR(namei));
+		    argi = ScalarReal(x);
+		}
+		SET_VECTOR_ELT(value, i, SetOption(tag, argi));
+		gc_release_options_set = true;
+	    }
+	    else if (streql(CHAR(namei), "gc.events.file")) {
+		if (argi != R_NilValue
+		    && (!isString(argi) || LENGTH(argi) != 1
+			|| STRING_ELT(argi, 0) == NA_STRING))
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		const char* path = (argi == R_NilValue ? nullptr
+			: R_ExpandFileName(translateChar(STRING_ELT(argi, 0))));
+		if (!GCManager::setEventLog(path))
+		    warning(_("cannot open file '%s': %s"), path,
+			    strerror(errno));
+		SET_VECTOR_ELT(value, i, SetOption(tag, duplicate(argi)));
+	    }
 	    else {
 		SET_VECTOR_ELT(value, i, SetOption(tag, duplicate(argi)));
 	    }
@@ -665,11 +842,15 @@ SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
 		error(_("\"par.ask.default\" has been replaced by \"device.ask.default\""));
 	    }
 
-	    SET_VECTOR_ELT(value, i, duplicate(CAR(FindTaggedItem(options, install(tag)))));
+	    SET_VECTOR_ELT(value, i, duplicate(GetOption1(install(tag))));
 	    SET_STRING_ELT(names, i, STRING_ELT(argi, 0));
 	    R_Visible = TRUE;
 	}
     } /* for() */
+    if (gc_options_set)
+	setHeapSizingPolicy();
+    if (gc_release_options_set)
+	setReleasePolicy();
     setAttrib(value, R_NamesSymbol, names);
     UNPROTECT(2);
     return value;
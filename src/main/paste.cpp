@@ -41,19 +41,70 @@
 
 #include "Print.h"
 #include "RBufferUtils.h"
+#include <memory>
 #include <vector>
 
+using namespace rho;
 using namespace std;
 
 static R_StringBuffer cbuff = {nullptr, 0, MAXELTSIZE};
 
+/* Rows of paste() results at least this long have their text
+   assembled in parallel when R_num_math_threads allows. */
+#define R_PASTE_PARALLEL_MIN 100000
+
+namespace {
+    /* Whether row i of a paste() result is to be assembled in UTF-8
+     * or as bytes, given the elements of the arguments that make up
+     * that row and the encoding of the separator.
+     */
+    void pasteRowEncoding(const vector<const StringVector*>& xv,
+			  R_xlen_t i, bool sepUTF8, bool sepBytes,
+			  bool* use_UTF8, bool* use_Bytes)
+    {
+	R_xlen_t nx = R_xlen_t(xv.size());
+	*use_UTF8 = (nx > 1) && sepUTF8;
+	*use_Bytes = (nx > 1) && sepBytes;
+	for (R_xlen_t j = 0; j < nx; j++) {
+	    R_xlen_t k = xv[j]->size();
+	    if (k > 0) {
+		const String* cs = (*xv[j])[i % k];
+		if (cs->encoding() == CE_UTF8) *use_UTF8 = true;
+		if (cs->encoding() == CE_BYTES) *use_Bytes = true;
+	    }
+	}
+	if (*use_Bytes) *use_UTF8 = false;
+    }
+
+    /* The text of one element of a paste() argument, translated as
+     * its row requires.  Sets *len to the length of the text, taken
+     * from the String itself if no translation was needed.  Any
+     * translation is allocated with R_alloc().
+     */
+    const char* pasteText(const String* cs, bool use_UTF8, bool use_Bytes,
+			  size_t* len)
+    {
+	SEXP csx = const_cast<String*>(cs);
+	const char* s;
+	if (use_Bytes)
+	    s = cs->c_str();
+	else if (use_UTF8)
+	    s = translateCharUTF8(csx);
+	else
+	    s = translateChar(csx);
+	*len = (s == cs->c_str()) ? cs->size() : strlen(s);
+	return s;
+    }
+}
+
 /*
   .Internal(paste (args, sep, collapse))
   .Internal(paste0(args, collapse))
 
  * do_paste uses two passes to paste the arguments (in CAR(args)) together.
- * The first pass calculates the width of the paste buffer,
- * then it is alloc-ed and the second pass stuffs the information in.
+ * The first pass calculates the width of every element of the result,
+ * then a single buffer is alloc-ed and the second pass stuffs the
+ * information in.
  */
 
 /* Note that NA_STRING is not handled separately here.  This is
@@ -133,7 +184,26 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 	return (!isNull(collapse)) ? mkString("") : allocVector(STRSXP, 0);
 
     PROTECT(ans = allocVector(STRSXP, maxlen));
-
+    StringVector* sans = SEXP_downcast<StringVector*>(ans);
+
+    vector<const StringVector*> xv(nx);
+    for (j = 0; j < nx; j++)
+	xv[j] = SEXP_downcast<const StringVector*>(VECTOR_ELT(x, j));
+
+    /* The result is built in two passes over the rows.  The first
+     * pass decides the encoding of each element of the result and
+     * computes its width, and hence its offset within a single
+     * buffer holding the text of every element.  The second pass
+     * copies the text into that buffer, and the Strings are then
+     * obtained directly from their slices of it.  If no element
+     * needed translation, the second pass touches no R state, and
+     * is split across R_num_math_threads threads.
+     */
+    vector<R_xlen_t> offset(maxlen + 1);
+    vector<unsigned char> rowenc(maxlen);
+    bool anyTranslated = false;
+
+    offset[0] = 0;
     for (i = 0; i < maxlen; i++) {
 	/* Strategy for marking the encoding: if all inputs (including
 	 * the separator) are ASCII, so is the output and we don't
@@ -141,37 +211,34 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 	 * declared encoding, we should mark.
 	 * Need to be careful only to include separator if it is used.
 	 */
-	anyKnown = FALSE; allKnown = TRUE; use_UTF8 = FALSE; use_Bytes = FALSE;
+	pasteRowEncoding(xv, i, sepUTF8, sepBytes, &use_UTF8, &use_Bytes);
+	anyKnown = FALSE; allKnown = TRUE;
 	if(nx > 1) {
 	    allKnown = sepKnown || sepASCII;
 	    anyKnown = sepKnown;
-	    use_UTF8 = sepUTF8;
-	    use_Bytes = sepBytes;
 	}
 
 	pwidth = 0;
-	for (j = 0; j < nx; j++) {
-	    k = xlength(VECTOR_ELT(x, j));
-	    if (k > 0) {
-		SEXP cs = STRING_ELT(VECTOR_ELT(x, j), i % k);
-		if(IS_UTF8(cs)) use_UTF8 = TRUE;
-		if(IS_BYTES(cs)) use_Bytes = TRUE;
-	    }
-	}
-	if (use_Bytes) use_UTF8 = FALSE;
 	vmax = vmaxget();
 	for (j = 0; j < nx; j++) {
-	    k = xlength(VECTOR_ELT(x, j));
+	    k = xv[j]->size();
 	    if (k > 0) {
-		if(use_Bytes)
-		    pwidth += strlen(CHAR(STRING_ELT(VECTOR_ELT(x, j), i % k)));
-		else if(use_UTF8)
-		    pwidth += strlen(translateCharUTF8(STRING_ELT(VECTOR_ELT(x, j), i % k)));
-		else
-		    pwidth += strlen(translateChar(STRING_ELT(VECTOR_ELT(x, j), i % k)));
-		vmaxset(vmax);
+		const String* cs = (*xv[j])[i % k];
+		size_t len;
+		s = pasteText(cs, use_UTF8, use_Bytes, &len);
+		pwidth += len;
+		bool translated = (s != cs->c_str());
+		anyTranslated = anyTranslated || translated;
+		if (!use_UTF8) {
+		    bool ascii = translated ? strIsASCII(s) : cs->isASCII();
+		    bool known = (cs->encoding() == CE_LATIN1
+				  || cs->encoding() == CE_UTF8);
+		    allKnown = allKnown && (ascii || known);
+		    anyKnown = anyKnown || known;
+		}
 	    }
 	}
+	vmaxset(vmax);
 	if(use_sep) {
 	    if (use_UTF8 && !u_csep) {
 		u_csep = translateCharUTF8(sep);
@@ -181,35 +248,6 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 	}
 	if (pwidth > INT_MAX)
 	    error(_("result would exceed 2^31-1 bytes"));
-	cbuf = buf = static_cast<char*>(R_AllocStringBuffer(pwidth, &cbuff));
-	vmax = vmaxget();
-	for (j = 0; j < nx; j++) {
-	    k = xlength(VECTOR_ELT(x, j));
-	    if (k > 0) {
-		SEXP cs = STRING_ELT(VECTOR_ELT(x, j), i % k);
-		if (use_UTF8) {
-		    s = translateCharUTF8(cs);
-		    strcpy(buf, s);
-		    buf += strlen(s);
-		} else {
-		    s = use_Bytes ? CHAR(cs) : translateChar(cs);
-		    strcpy(buf, s);
-		    buf += strlen(s);
-		    allKnown = allKnown && (strIsASCII(s) || (ENC_KNOWN(cs)> 0));
-		    anyKnown = anyKnown || (ENC_KNOWN(cs)> 0);
-		}
-	    }
-	    if (sepw != 0 && j != nx - 1) {
-		if (use_UTF8) {
-		    strcpy(buf, u_csep);
-		    buf += u_sepw;
-		} else {
-		    strcpy(buf, csep);
-		    buf += sepw;
-		}
-	    }
-	    vmax = vmaxget();
-	}
 	ienc = CE_NATIVE;
 	if(use_UTF8) ienc = CE_UTF8;
 	else if(use_Bytes) ienc = CE_BYTES;
@@ -217,9 +255,61 @@ SEXP attribute_hidden do_paste(/*const*/ rho::Expression* call, const rho::Built
 	    if(known_to_be_latin1) ienc = CE_LATIN1;
 	    if(known_to_be_utf8) ienc = CE_UTF8;
 	}
-	SET_STRING_ELT(ans, i, mkCharCE(cbuf, ienc));
+	rowenc[i] = static_cast<unsigned char>(ienc);
+	offset[i + 1] = offset[i] + pwidth;
+    }
+
+    std::unique_ptr<char[]> text(new char[offset[maxlen] + 1]);
+    auto fillRow = [&](R_xlen_t row) {
+	bool row_UTF8, row_Bytes;
+	pasteRowEncoding(xv, row, sepUTF8, sepBytes, &row_UTF8, &row_Bytes);
+	char* p = text.get() + offset[row];
+	for (R_xlen_t jj = 0; jj < nx; jj++) {
+	    R_xlen_t kk = xv[jj]->size();
+	    if (kk > 0) {
+		size_t len;
+		const char* piece = pasteText((*xv[jj])[row % kk],
+					      row_UTF8, row_Bytes, &len);
+		memcpy(p, piece, len);
+		p += len;
+	    }
+	    if (sepw != 0 && jj != nx - 1) {
+		if (row_UTF8) {
+		    memcpy(p, u_csep, u_sepw);
+		    p += u_sepw;
+		} else {
+		    memcpy(p, csep, sepw);
+		    p += sepw;
+		}
+	    }
+	}
+    };
+    if (anyTranslated) {
+	for (i = 0; i < maxlen; i++) {
+	    vmax = vmaxget();
+	    fillRow(i);
+	    vmaxset(vmax);
+	}
+    } else {
+#ifdef _OPENMP
+	int nthreads;
+	if (R_num_math_threads > 0 && maxlen >= R_PASTE_PARALLEL_MIN)
+	    nthreads = R_num_math_threads;
+	else
+	    nthreads = 1;
+#pragma omp parallel for num_threads(nthreads) default(none) \
+    shared(fillRow, maxlen)
+#endif
+	for (R_xlen_t row = 0; row < maxlen; row++)
+	    fillRow(row);
     }
 
+    for (i = 0; i < maxlen; i++)
+	(*sans)[i] = String::obtain(text.get() + offset[i],
+				    size_t(offset[i + 1] - offset[i]),
+				    cetype_t(rowenc[i]));
+    text.reset();
+
     /* Now collapse, if required. */
 
     if(collapse != R_NilValue && (nx = XLENGTH(ans)) > 0) {
@@ -106,7 +106,7 @@ void PrintDefaults(void)
     R_print.quote = 1;
     R_print.right = Rprt_adj_left;
     R_print.digits = GetOptionDigits();
-    R_print.scipen = asInteger(GetOption1(install("scipen")));
+    R_print.scipen = R_GetOptionScipen();
     if (R_print.scipen == NA_INTEGER) R_print.scipen = 0;
     R_print.max = asInteger(GetOption1(install("max.print")));
     if (R_print.max == NA_INTEGER || R_print.max < 0) R_print.max = 99999;
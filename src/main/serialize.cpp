@@ -42,12 +42,14 @@
 
 #include <cstdarg>
 #include <vector>
+#include "rho/AdoptedVector.hpp"
 #include "rho/Closure.hpp"
 #include "rho/DottedArgs.hpp"
 #include "rho/ExpressionVector.hpp"
 #include "rho/ExternalPointer.hpp"
 #include "rho/GCStackRoot.hpp"
 #include "rho/Frame.hpp"
+#include "rho/RawVector.hpp"
 #include "rho/WeakRef.hpp"
 #include "sparsehash/dense_hash_map"
 
@@ -2384,10 +2386,16 @@ static SEXP CloseMemOutPStream(R_outpstream_t stream)
     if(mb->count > INT_MAX)
 	Rf_error(_("serialization is too large to store in a raw vector"));
 #endif
-    PROTECT(val = Rf_allocVector(RAWSXP, mb->count));
-    memcpy(RAW(val), mb->buf, mb->count);
-    free_mem_buffer(mb);
-    UNPROTECT(1);
+    /* The result adopts the buffer rather than copying it, which
+       would need twice the memory for a long serialization. */
+    unsigned char *buf = mb->buf;
+    if (mb->count < mb->size) {
+	unsigned char *tmp = RHO_S_CAST(unsigned char*,
+					realloc(buf, mb->count));
+	if (tmp != nullptr || mb->count == 0) buf = tmp;
+    }
+    mb->buf = nullptr;
+    val = AdoptedVector<Rbyte, RAWSXP>::create(buf, mb->count);
     return val;
 }
 
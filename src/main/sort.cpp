@@ -37,6 +37,8 @@
 #include "rho/Closure.hpp"
 #include "rho/RAllocStack.hpp"
 #include "rho/StringVector.hpp"
+#include <algorithm>
+#include <vector>
 
 // 'using namespace std' causes ambiguity of 'greater'
 using namespace rho;
@@ -456,6 +458,44 @@ static void ssort2(StringVector* sv, R_xlen_t n, Rboolean decreasing)
 	}
 }
 
+/* Character vectors of at least StringDictionary::minLength elements
+   with few distinct values are sorted by collecting their distinct
+   Strings in a StringDictionary, sorting just those, and writing each
+   out as many times as it occurred.  Returns false, leaving sv
+   unchanged, if sv is shorter than that or has more than
+   StringDictionary::maxSize distinct values. */
+static bool dictionarySort(StringVector* sv, R_xlen_t n, Rboolean decreasing)
+{
+    if (!StringDictionary::mayHaveFewValues(sv))
+	return false;
+    StringDictionary dict;
+    std::vector<R_xlen_t> counts;
+    bool is_new;
+    for (R_xlen_t i = 0; i < n; i++) {
+	int code = dict.encode((*sv)[i], &is_new);
+	if (code < 0)
+	    return false;
+	if (is_new)
+	    counts.push_back(0);
+	counts[code]++;
+    }
+    std::vector<int> codes(dict.size());
+    for (std::size_t c = 0; c < codes.size(); c++)
+	codes[c] = int(c);
+    std::sort(codes.begin(), codes.end(), [&](int l, int r) {
+	    int cmp = scmp(const_cast<String*>(dict[l]),
+			   const_cast<String*>(dict[r]), TRUE);
+	    return decreasing ? cmp > 0 : cmp < 0;
+	});
+    R_xlen_t i = 0;
+    for (int c : codes) {
+	String* str = const_cast<String*>(dict[c]);
+	for (R_xlen_t k = 0; k < counts[c]; k++)
+	    (*sv)[i++] = str;
+    }
+    return true;
+}
+
 /* The meat of sort.int() */
 void sortVector(SEXP s, Rboolean decreasing)
 {
@@ -475,7 +515,8 @@ void sortVector(SEXP s, Rboolean decreasing)
 	case STRSXP:
 	    {
 		StringVector* sv = static_cast<StringVector*>(s);
-		ssort2(sv, n, decreasing);
+		if (!dictionarySort(sv, n, decreasing))
+		    ssort2(sv, n, decreasing);
 		break;
 	    }
 	default:
@@ -44,7 +44,7 @@
 
 SEXP attribute_hidden do_split(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::RObject* x_, rho::RObject* f_)
 {
-    SEXP x, f, counts, vec, nm, nmj;
+    SEXP x, f, counts, vec, nm_vec, nm, nmj;
     Rboolean have_names;
 
     x = x_;
@@ -76,14 +76,24 @@ SEXP attribute_hidden do_split(/*const*/ rho::Expression* call, const rho::Built
     /* Allocate a generic vector to hold the results. */
     /* The i-th element will hold the split-out data */
     /* for the ith group. */
+    /* Runs of groups of equal size are allocated together, which */
+    /* is much faster when there are many small groups. */
     PROTECT(vec = allocVector(VECSXP, nlevs));
+    PROTECT(nm_vec = allocVector(VECSXP, have_names ? nlevs : 0));
+    for (int i = 0; i < nlevs; ) {
+	int n = INTEGER(counts)[i], j = i + 1;
+	while (j < nlevs && INTEGER(counts)[j] == n) j++;
+	allocVectorsInList(TYPEOF(x), n, vec, i, j - i);
+	if(have_names)
+	    allocVectorsInList(STRSXP, n, nm_vec, i, j - i);
+	i = j;
+    }
     for (R_xlen_t i = 0;  i < nlevs; i++) {
-	SET_VECTOR_ELT(vec, i, allocVector(TYPEOF(x), INTEGER(counts)[i]));
 	setAttrib(VECTOR_ELT(vec, i), R_LevelsSymbol,
 		  getAttrib(x, R_LevelsSymbol));
 	if(have_names)
 	    setAttrib(VECTOR_ELT(vec, i), R_NamesSymbol,
-		      allocVector(STRSXP, INTEGER(counts)[i]));
+		      VECTOR_ELT(nm_vec, i));
     }
     for (int i = 0; i < nlevs; i++) INTEGER(counts)[i] = 0;
     MOD_ITERATE1(nobs, nfac, i, i1, {
@@ -121,6 +131,6 @@ SEXP attribute_hidden do_split(/*const*/ rho::Expression* call, const rho::Built
 	}
     });
     setAttrib(vec, R_NamesSymbol, getAttrib(f, R_LevelsSymbol));
-    UNPROTECT(2);
+    UNPROTECT(3);
     return vec;
 }
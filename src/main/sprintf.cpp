@@ -33,6 +33,8 @@
 #include <Internal.h>
 #include "RBufferUtils.h"
 #include <R_ext/RS.h> /* for Calloc/Free */
+#include <string>
+#include <vector>
 #ifdef Win32
 #include <trioremap.h>
 #endif
@@ -81,6 +83,242 @@ static Rboolean checkfmt(const char *fmt, const char *pattern)
     : translateChar(STRING_ELT(_STR_, _i_)))
 
 
+/*
+   A format which is used for every element of the result is compiled
+   once into a list of operations, each either a run of literal text
+   or a single conversion specification bound to one argument, and the
+   rows after the first are then produced by running that list.  The
+   first row always goes through the general code in do_sprintf, as
+   that is where any coercion of the arguments happens.  Formats using
+   '*', or which are not ASCII (and so might be translated differently
+   from row to row), are not compiled.
+*/
+
+namespace {
+    struct SprintfOp {
+	std::string spec;   /* literal text, or specification without n$ */
+	int arg;            /* argument index, or -1 for literal text */
+
+	/* The following are set up by prepareSprintfOps once the
+	   argument types are known: */
+	std::string naspec; /* specification for NA and non-finite values */
+	int width;          /* >= 0 if formatted by formatSprintfInt */
+	bool zeropad, space, plus;
+    };
+}
+
+static bool compileSprintfFormat(const char *formatString, int nargs,
+				 std::vector<SprintfOp>& ops)
+{
+    size_t n = strlen(formatString), cur, chunk;
+    int cnt = 0;
+
+    for (cur = 0; cur < n; cur += chunk) {
+	const char *curFormat = formatString + cur;
+	SprintfOp op;
+	op.arg = -1;
+	if (*curFormat != '%') {
+	    const char *ch = strchr(curFormat, '%');
+	    chunk = (ch) ? size_t (ch - curFormat) : strlen(curFormat);
+	    op.spec.assign(curFormat, chunk);
+	} else if (cur < n - 1 && curFormat[1] == '%') {
+	    chunk = 2;
+	    op.spec = "%";
+	} else {
+	    chunk = strcspn(curFormat + 1, "diosfeEgGxXaA") + 2;
+	    if (cur + chunk > n) return false;
+	    std::string fmt(curFormat, chunk);
+	    int nthis = -1;
+	    /* the %n$ and %nn$ forms, as in do_sprintf */
+	    if (fmt.size() > 3 && fmt[1] >= '1' && fmt[1] <= '9') {
+		int v = fmt[1] - '0';
+		if (fmt[2] == '$') {
+		    nthis = v-1;
+		    fmt.erase(1, 2);
+		} else if (fmt[2] >= '0' && fmt[2] <= '9' && fmt[3] == '$') {
+		    nthis = 10*v + fmt[2] - '0' - 1;
+		    fmt.erase(1, 3);
+		}
+	    }
+	    if (fmt.find('*') != std::string::npos || fmt[fmt.size() - 1] == '%')
+		return false;
+	    if (nthis < 0) nthis = cnt++;
+	    if (nthis >= nargs) return false;
+	    op.spec = fmt;
+	    op.arg = nthis;
+	}
+	if (op.arg < 0 && !ops.empty() && ops.back().arg < 0)
+	    ops.back().spec += op.spec;
+	else
+	    ops.push_back(op);
+    }
+    return true;
+}
+
+/* Check each conversion against the (by now coerced) type of its
+   argument, and prepare the specifications used for NA values.  false
+   means that the general code must be used, e.g. to report an error. */
+static bool prepareSprintfOps(std::vector<SprintfOp>& ops, SEXP *a)
+{
+    for (SprintfOp& op : ops) {
+	if (op.arg < 0) continue;
+	SEXP _this = a[op.arg];
+	const char *spec = op.spec.c_str(), *conv = findspec(spec);
+	if (length(_this) == 0) return false;
+	op.width = -1;
+	op.zeropad = op.space = op.plus = false;
+	op.naspec = op.spec;
+	switch(TYPEOF(_this)) {
+	case LGLSXP:
+	case INTSXP:
+	    if (checkfmt(spec, TYPEOF(_this) == LGLSXP ? "di" : "dioxX"))
+		return false;
+	    op.naspec[op.naspec.size() - 1] = 's';
+	    /* %d, %i and %0<w>d are formatted directly */
+	    if (*conv == 'd' || *conv == 'i') {
+		const char *p = spec + 1;
+		if (*p == '0') {
+		    op.zeropad = true;
+		    p++;
+		}
+		int width = 0;
+		for (; *p >= '0' && *p <= '9'; p++)
+		    width = 10*width + (*p - '0');
+		if (p == conv && width <= MAXLINE)
+		    op.width = width;
+	    }
+	    break;
+	case REALSXP:
+	{
+	    if (checkfmt(spec, "aAfeEgG"))
+		return false;
+	    std::string::size_type dot = op.naspec.find('.');
+	    if (dot != std::string::npos)
+		op.naspec.erase(dot + 1);
+	    else
+		dot = op.naspec.size() - 1;
+	    op.naspec[dot] = 's';
+	    op.space = (op.naspec.find(' ') != std::string::npos);
+	    op.plus = (op.naspec.find('+') != std::string::npos);
+	    break;
+	}
+	case STRSXP:
+	    if (checkfmt(spec, "s"))
+		return false;
+	    break;
+	default:
+	    return false;
+	}
+    }
+    return true;
+}
+
+template <typename T>
+static void appendSprintf(std::string& out, const char *spec, T x)
+{
+    char bit[MAXLINE+1];
+    int nc = snprintf(bit, MAXLINE+1, spec, x);
+    if (nc > MAXLINE)
+	error(_("required resulting string length %d is greater than maximal %d"),
+	      nc, MAXLINE);
+    out += bit;
+}
+
+/* As snprintf with "%d" or "%0<width>d", for x other than NA_INTEGER. */
+static void formatSprintfInt(std::string& out, int x, int width, bool zeropad)
+{
+    char digits[16], *end = digits + sizeof(digits), *p = end;
+    unsigned int u = (x < 0) ? 0u - unsigned(x) : unsigned(x);
+    do {
+	*--p = char('0' + u % 10);
+	u /= 10;
+    } while (u);
+    int len = int(end - p) + (x < 0), pad = width - len;
+    if (pad > 0 && !zeropad) out.append(pad, ' ');
+    if (x < 0) out += '-';
+    if (pad > 0 && zeropad) out.append(pad, '0');
+    out.append(p, end);
+}
+
+/* Rows [from, to) of the result of sprintf() with the compiled format
+   ops.  The arguments in a[] must have been prepared by
+   prepareSprintfOps. */
+static void runSprintfOps(const std::vector<SprintfOp>& ops, SEXP *a,
+			  int nargs, int from, int to, SEXP ans)
+{
+    std::string out;
+    for (int ns = from; ns < to; ns++) {
+	const void *vmax = vmaxget();
+	bool use_UTF8 = false;
+	for (int i = 0; i < nargs; i++) {
+	    if (!isString(a[i])) continue;
+	    if (getCharCE(STRING_ELT(a[i], ns % LENGTH(a[i]))) == CE_UTF8) {
+		use_UTF8 = true; break;
+	    }
+	}
+	out.clear();
+	for (const SprintfOp& op : ops) {
+	    if (op.arg < 0) {
+		out += op.spec;
+		continue;
+	    }
+	    SEXP _this = a[op.arg];
+	    int thislen = LENGTH(_this);
+	    switch(TYPEOF(_this)) {
+	    case LGLSXP:
+	    case INTSXP:
+	    {
+		int x = (TYPEOF(_this) == LGLSXP) ? LOGICAL(_this)[ns % thislen]
+		    : INTEGER(_this)[ns % thislen];
+		if (x == NA_INTEGER)
+		    appendSprintf(out, op.naspec.c_str(), "NA");
+		else if (op.width >= 0)
+		    formatSprintfInt(out, x, op.width, op.zeropad);
+		else
+		    appendSprintf(out, op.spec.c_str(), x);
+		break;
+	    }
+	    case REALSXP:
+	    {
+		double x = REAL(_this)[ns % thislen];
+		const char *naspec = op.naspec.c_str();
+		if (R_FINITE(x))
+		    appendSprintf(out, op.spec.c_str(), x);
+		else if (ISNA(x))
+		    appendSprintf(out, naspec, op.space ? " NA" : "NA");
+		else if (ISNAN(x))
+		    appendSprintf(out, naspec, op.space ? " NaN" : "NaN");
+		else if (x == R_PosInf)
+		    appendSprintf(out, naspec,
+				  op.plus ? "+Inf" : op.space ? " Inf" : "Inf");
+		else
+		    appendSprintf(out, naspec, "-Inf");
+		break;
+	    }
+	    case STRSXP:
+	    {
+		const char *ss = TRANSLATE_CHAR(_this, ns % thislen);
+		if (op.spec[1] == 's')
+		    out += ss;
+		else {
+		    if (strlen(ss) > MAXLINE)
+			warning(_("likely truncation of character string to %d characters"),
+				MAXLINE-1);
+		    appendSprintf(out, op.spec.c_str(), ss);
+		}
+		break;
+	    }
+	    default:
+		break;
+	    }
+	}
+	SET_STRING_ELT(ans, ns, mkCharLenCE(out.data(), int(out.size()),
+					    use_UTF8 ? CE_UTF8 : CE_NATIVE));
+	vmaxset(vmax);
+    }
+}
+
+
 SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::BuiltInFunction* op, rho::Environment* env, rho::RObject* const* args, int num_args, const rho::PairList* tags)
 {
     int i, nargs, cnt, v, thislen, nfmt, nprotect = 0;
@@ -138,6 +376,12 @@ SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::Bui
 
     CHECK_maxlen;
 
+    std::vector<SprintfOp> ops;
+    bool compiled = (nfmt == 1 && maxlen > 1
+		     && IS_ASCII(STRING_ELT(format, 0))
+		     && compileSprintfFormat(CHAR(STRING_ELT(format, 0)),
+					     nargs, ops));
+
     outputString = RHOCONSTRUCT(static_cast<char*>, R_AllocStringBuffer(0, &outbuff));
 
     /* We do the format analysis a row at a time */
@@ -455,6 +699,10 @@ SEXP attribute_hidden do_sprintf(/*const*/ rho::Expression* call, const rho::Bui
 	}
 	SET_STRING_ELT(ans, ns, mkCharCE(outputString,
 					 use_UTF8 ? CE_UTF8 : CE_NATIVE));
+	if (ns == 0 && compiled && prepareSprintfOps(ops, a)) {
+	    runSprintfOps(ops, a, nargs, 1, maxlen, ans);
+	    break;
+	}
     } /* end for(ns ...) */
 
     UNPROTECT(nprotect);
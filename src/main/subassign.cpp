@@ -117,7 +117,7 @@ static SEXP EnlargeVector(SEXP x, R_xlen_t newlen)
 
     /* Enlarge the vector itself. */
     len = xlength(x);
-    if (LOGICAL(GetOption1(install("check.bounds")))[0])
+    if (R_CheckBounds)
 	warning(_("assignment outside vector/list limits (extending from %d to %d)"),
 		len, newlen);
     PROTECT(x);
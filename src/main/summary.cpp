@@ -34,6 +34,7 @@
 
 #include "rho/Closure.hpp"
 #include "rho/GCStackRoot.hpp"
+#include "rho/LogicalVector.hpp"
 #include <R_ext/Itermacros.h>
 
 using namespace rho;
@@ -623,9 +624,26 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 		switch(TYPEOF(a)) {
 		case LGLSXP:
 		case INTSXP:
-		    updated = isum(TYPEOF(a) == LGLSXP ?
-				   LOGICAL(a) :INTEGER(a), XLENGTH(a),
-				   &itmp, narm, call);
+		    if (TYPEOF(a) == LGLSXP) {
+			/* A logical vector sums to its number of TRUE
+			   elements, which countLogicals() finds
+			   without branching on each element: */
+			const LogicalVector* lv
+			    = SEXP_downcast<LogicalVector*>(a);
+			std::size_t ntrue, nna;
+			countLogicals(lv->begin(), lv->end(), &ntrue, &nna);
+			updated = RHOCONSTRUCT(Rboolean,
+					       (nna > 0 && !narm)
+					       || nna < lv->size());
+			if (nna > 0 && !narm)
+			    itmp = NA_INTEGER;
+			else if (ntrue > std::size_t(INT_MAX)) {
+			    warningcall(call, _("integer overflow - use sum(as.numeric(.))"));
+			    itmp = NA_INTEGER;
+			} else itmp = int(ntrue);
+		    } else
+			updated = isum(INTEGER(a), XLENGTH(a),
+				       &itmp, narm, call);
 		    if(updated) {
 			if(itmp == NA_INTEGER) goto na_answer;
 			if(ans_type == INTSXP) {
@@ -905,18 +923,20 @@ SEXP attribute_hidden do_which(/*const*/ Expression* call, const BuiltInFunction
     if (!isLogical(v))
 	error(_("argument to 'which' is not logical"));
     len = length(v);
-    buf = reinterpret_cast<int *>( R_alloc(len, sizeof(int)));
 
-    for (i = 0; i < len; i++) {
-	if (LOGICAL(v)[i] == TRUE) {
-	    buf[j] = i + 1;
-	    j++;
-	}
+    /* Size the answer first, rather than collecting the indices in a
+       scratch buffer as long as v: */
+    const LogicalVector* lvec = SEXP_downcast<LogicalVector*>(v);
+    const Logical* lv = lvec->begin();
+    std::size_t ntrue, nna;
+    countLogicals(lv, lvec->end(), &ntrue, &nna);
+    PROTECT(ans = allocVector(INTSXP, ntrue));
+    buf = INTEGER(ans);
+    for (i = 0; j < int(ntrue); i++) {
+	if (lv[i].isTrue())
+	    buf[j++] = i + 1;
     }
-
     len = j;
-    PROTECT(ans = allocVector(INTSXP, len));
-    if(len) memcpy(INTEGER(ans), buf, sizeof(int) * len);
 
     if ((v_nms = getAttrib(v, R_NamesSymbol)) != R_NilValue) {
 	PROTECT(ans_nms = allocVector(STRSXP, len));
@@ -39,6 +39,8 @@
 #include <errno.h>
 #include <vector>
 
+#include "rho/CommandRecorder.hpp"
+
 using namespace std;
 
 /*
@@ -144,6 +146,8 @@ static wchar_t * wcfixmode(const wchar_t *mode)
 
 FILE *R_fopen(const char *filename, const char *mode)
 {
+    if (filename && mode[0] == 'r')
+	rho::CommandRecorder::noteFileRead(filename);
     return(filename ? fopen(filename, fixmode(mode)) : nullptr );
 }
 
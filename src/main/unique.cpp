@@ -489,6 +489,42 @@ static void removeEntry(SEXP table, SEXP x, R_xlen_t indx, HashData *d)
 	}							\
     }
 
+/* Character vectors whose elements are compared by address (i.e. for
+   which DUPLICATED_INIT leaves data.useUTF8 FALSE) and which have at
+   most StringDictionary::maxSize distinct values are deduplicated
+   with a StringDictionary of the values seen so far.  This avoids
+   allocating and probing a hash table sized for the whole vector. */
+
+static bool stringsComparedByAddress(SEXP x)
+{
+    R_xlen_t n = XLENGTH(x);
+    bool known = false;
+    for (R_xlen_t i = 0; i < n; i++) {
+	if (IS_BYTES(STRING_ELT(x, i))) return true;
+	if (ENC_KNOWN(STRING_ELT(x, i))) known = true;
+    }
+    return !known;
+}
+
+/* Sets v[i] for each element of x, as isDuplicated() would.  Returns
+   false (with v partly set) if x has too many distinct values. */
+static bool dictionaryDuplicated(SEXP x, Rboolean from_last, int *v)
+{
+    const StringVector* sv = SEXP_downcast<const StringVector*>(x);
+    R_xlen_t n = XLENGTH(x);
+    if (!StringDictionary::mayHaveFewValues(sv))
+	return false;
+    StringDictionary dict;
+    bool is_new;
+    for (R_xlen_t k = 0; k < n; k++) {
+	R_xlen_t i = from_last ? n - 1 - k : k;
+	if (dict.encode((*sv)[i], &is_new) < 0)
+	    return false;
+	v[i] = !is_new;
+    }
+    return true;
+}
+
 /* used in scan() */
 SEXP duplicated(SEXP x, Rboolean from_last)
 {
@@ -526,6 +562,14 @@ static SEXP Duplicated(SEXP x, Rboolean from_last, int nmax)
 
     if (!isVector(x)) error(_("'duplicated' applies only to vectors"));
     R_xlen_t i, n = XLENGTH(x);
+    if (TYPEOF(x) == STRSXP && nmax == NA_INTEGER
+	&& stringsComparedByAddress(x)) {
+	PROTECT(ans = allocVector(LGLSXP, n));
+	bool done = dictionaryDuplicated(x, from_last, LOGICAL(ans));
+	UNPROTECT(1);
+	if (done)
+	    return ans;
+    }
     DUPLICATED_INIT;
 
     PROTECT(data.HashTable);
@@ -557,6 +601,23 @@ R_xlen_t any_duplicated(SEXP x, Rboolean from_last)
     if (!isVector(x)) error(_("'duplicated' applies only to vectors"));
     R_xlen_t i, n = XLENGTH(x);
 
+    if (TYPEOF(x) == STRSXP && stringsComparedByAddress(x)
+	&& StringDictionary::mayHaveFewValues(
+	    SEXP_downcast<const StringVector*>(x))) {
+	const StringVector* sv = SEXP_downcast<const StringVector*>(x);
+	StringDictionary dict;
+	bool is_new;
+	int code = 0;
+	for (R_xlen_t k = 0; k < n && code >= 0; k++) {
+	    i = from_last ? n - 1 - k : k;
+	    code = dict.encode((*sv)[i], &is_new);
+	    if (code >= 0 && !is_new)
+		return i + 1;
+	}
+	if (code >= 0)
+	    return 0;
+    }
+
     DUPLICATED_INIT;
     PROTECT(data.HashTable);
 
@@ -195,6 +195,25 @@ int unzLocateFile OF((unzFile file,
 */
 
 
+/* Positions of files, for moving between them directly */
+typedef struct unz64_file_pos_s
+{
+    ZPOS64_T pos_in_zip_directory;   /* offset in zip file directory */
+    ZPOS64_T num_of_file;            /* # of file */
+} unz64_file_pos;
+
+int unzGetFilePos64 OF((unzFile file, unz64_file_pos* file_pos));
+/*
+  Record the position of the current file, for unzGoToFilePos64.
+*/
+
+int unzGoToFilePos64 OF((unzFile file, const unz64_file_pos* file_pos));
+/*
+  Set the current file to the one recorded by unzGetFilePos64,
+  possibly on another handle on the same zipfile.
+*/
+
+
 
 /* ****************************************** */
 
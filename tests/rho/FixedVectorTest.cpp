@@ -22,9 +22,12 @@
  */
 
 #include "gtest/gtest.h"
+#include "rho/AdoptedVector.hpp"
 #include "rho/FixedVector.hpp"
+#include "rho/GCStackRoot.hpp"
 #include "rho/IntVector.hpp"
 #include "rho/ListVector.hpp"
+#include "rho/RawVector.hpp"
 #include "rho/RealVector.hpp"
 
 using namespace rho;
@@ -83,3 +86,45 @@ TEST(IntegerVectorTest, ShortInitializerListConstructor) {
     object = IntVector::create({ });
     EXPECT_EQ(0, object->size());
 }
+
+TEST(IntegerVectorTest, CreateBatch) {
+    // Small vectors share batches; large ones are created singly.
+    const std::pair<std::size_t, std::size_t> cases[]
+	= {{0, 300}, {3, 300}, {100000, 20}};
+    for (const auto& c : cases) {
+	GCStackRoot<ListVector> list(ListVector::create(c.second));
+	IntVector::createBatch(c.first, c.second, list->begin());
+	std::set<const RObject*> distinct;
+	for (const auto& elt : *list) {
+	    const IntVector* v = dynamic_cast<const IntVector*>(elt.get());
+	    ASSERT_NE(nullptr, v);
+	    EXPECT_EQ(c.first, v->size());
+	    distinct.insert(v);
+	}
+	EXPECT_EQ(c.second, distinct.size());
+    }
+}
+
+TEST(AdoptedVectorTest, UsesBufferInPlace) {
+    Rbyte* buffer = static_cast<Rbyte*>(malloc(5));
+    for (int i = 0; i < 5; ++i)
+	buffer[i] = Rbyte(i + 1);
+    RawVector* object = AdoptedVector<Rbyte, RAWSXP>::create(buffer, 5);
+    ASSERT_EQ(5, object->size());
+    EXPECT_EQ(buffer, &(*object)[0]);
+    EXPECT_EQ(3, (*object)[2]);
+
+    object->decreaseSizeInPlace(2);
+    EXPECT_EQ(2, object->size());
+}
+
+TEST(AdoptedVectorTest, DataPointsToVector) {
+    // The conservative stack scan must find the vector from a
+    // pointer to its elements alone.
+    double* buffer = static_cast<double*>(malloc(4 * sizeof(double)));
+    RealVector* object = AdoptedVector<double, REALSXP>::create(buffer, 4);
+    EXPECT_EQ(object, GCNode::asGCNode(buffer));
+    EXPECT_EQ(object, GCNode::asGCNode(buffer + 2));
+    EXPECT_EQ(object, GCNode::asGCNode(buffer + 4));
+    EXPECT_EQ(nullptr, GCNode::asGCNode(buffer + 5));
+}
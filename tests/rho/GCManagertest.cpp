@@ -122,7 +122,7 @@ size_t GCNode::s_num_nodes = 42;
 
 // Other stubs:
 
-bool WeakRef::runFinalizers()
+bool WeakRef::runFinalizers(std::size_t)
 {
     bool success = (uni01() > 0.5);
     cout << "RunFinalizers():\n";
@@ -21,6 +21,8 @@
  *  http://www.r-project.org/Licenses/
  */
 
+#include <algorithm>
+#include <vector>
 #include "gtest/gtest.h"
 #include "rho/GCNodeAllocator.hpp"
 #include "rho/AddressSanitizer.hpp"
@@ -224,6 +226,36 @@ TEST(GCNodeAllocatorTest, FreeListMedium) {
     GCNodeAllocator::free(p5);
 }
 
+TEST(GCNodeAllocatorTest, ReleaseIdleSuperblocks) {
+    // Fill several superblocks and free all the blocks.  The superblocks
+    // should be released on the second call of releaseFreeMemory(), and
+    // then reused.
+    GCNodeAllocator::setReleasePolicy(1, 0);
+    std::vector<void*> allocs;
+    for (int i = 0; i < 4 * (1 << 18) / 64; ++i) {
+        allocs.push_back(GCNodeAllocator::allocate(64));
+    }
+    for (void* alloc : allocs) {
+        GCNodeAllocator::free(alloc);
+    }
+    GCNodeAllocator::releaseFreeMemory();
+    std::size_t released = GCNodeAllocator::releasedBytes();
+    EXPECT_GE(GCNodeAllocator::releaseFreeMemory(), std::size_t(3 << 18));
+    EXPECT_GE(GCNodeAllocator::releasedBytes(), released + (3 << 18));
+
+    allocs.clear();
+    for (int i = 0; i < 4 * (1 << 18) / 64; ++i) {
+        void* alloc = GCNodeAllocator::allocate(64);
+        EXPECT_EQ(alloc, GCNodeAllocator::lookupPointer(alloc));
+        allocs.push_back(alloc);
+    }
+    EXPECT_LT(GCNodeAllocator::releasedBytes(), released + (3 << 18));
+    for (void* alloc : allocs) {
+        GCNodeAllocator::free(alloc);
+    }
+    GCNodeAllocator::setReleasePolicy(2, 16 << 20);
+}
+
 #endif // HAVE_ADDRESS_SANITIZER
 
 TEST(GCNodeAllocatorTest, AllocManySmall) {
@@ -236,3 +268,29 @@ TEST(GCNodeAllocatorTest, AllocManySmall) {
     }
 }
 
+
+TEST(GCNodeAllocatorTest, AllocateBatch) {
+    // Batches spanning several superblocks, including blocks reused from
+    // the freelists, must give distinct allocations that can be looked up
+    // and freed individually.
+    static constexpr int num = 20000;
+    for (std::size_t size : {48, 256, 1024}) {
+        std::vector<void*> reused(100);
+        GCNodeAllocator::allocateBatch(size, reused.size(), reused.data());
+        for (void* alloc : reused) {
+            GCNodeAllocator::free(alloc);
+        }
+        std::vector<void*> allocs(num);
+        GCNodeAllocator::allocateBatch(size, num, allocs.data());
+        std::vector<void*> sorted(allocs);
+        std::sort(sorted.begin(), sorted.end());
+        EXPECT_EQ(sorted.end(), std::unique(sorted.begin(), sorted.end()));
+        for (void* alloc : allocs) {
+            EXPECT_EQ(alloc, GCNodeAllocator::lookupPointer(alloc));
+            EXPECT_GE(GCNodeAllocator::allocationSize(alloc), size);
+        }
+        for (void* alloc : allocs) {
+            GCNodeAllocator::free(alloc);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ *  R : A Computer Language for Statistical Data Analysis
+ *  Copyright (C) 2014 and onwards the Rho Project Authors.
+ *
+ *  Rho is not part of the R project, and bugs and other issues should
+ *  not be reported via r-bugs or other R project channels; instead refer
+ *  to the Rho website.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, a copy is available at
+ *  http://www.r-project.org/Licenses/
+ */
+
+#include "gtest/gtest.h"
+#include "rho/HeapSizingPolicy.hpp"
+
+using namespace rho;
+
+namespace {
+    const std::size_t MB = 1 << 20;
+
+    HeapSizingPolicy::Collection collection(bool full, std::size_t before,
+					    std::size_t after,
+					    double gc_seconds,
+					    double mutator_seconds)
+    {
+	HeapSizingPolicy::Collection ans;
+	ans.full = full;
+	ans.bytes_before = before;
+	ans.bytes_after = after;
+	ans.gc_seconds = gc_seconds;
+	ans.mutator_seconds = mutator_seconds;
+	return ans;
+    }
+}
+
+TEST(HeapSizingPolicyTest, GrowthAllowsTwentyPercent) {
+    GrowthHeapPolicy policy;
+    std::size_t lite = 16*MB, full = 16*MB;
+    policy.adjustThresholds(collection(true, 120*MB, 100*MB, 0.1, 1),
+			    16*MB, &lite, &full);
+    EXPECT_EQ(std::size_t(120*MB), lite);
+    EXPECT_EQ(std::size_t(120*MB), full);
+
+    // The mark-sweep threshold is left alone after a lightweight
+    // collection, and thresholds fall by at most 20%:
+    policy.adjustThresholds(collection(false, 120*MB, 10*MB, 0.01, 1),
+			    16*MB, &lite, &full);
+    EXPECT_EQ(std::size_t(96*MB), lite);
+    EXPECT_EQ(std::size_t(120*MB), full);
+}
+
+TEST(HeapSizingPolicyTest, PauseTimeScalesWithCollectionCost) {
+    // The heap grew by 100MB in 1s, and the collection took 0.1s.
+    // To spend 5% of the time in collection, the next one should
+    // come after 1.9s, i.e. after another 190MB:
+    PauseTimeHeapPolicy policy(0.05, 0.01);
+    std::size_t lite = 16*MB, full = 16*MB;
+    policy.adjustThresholds(collection(true, 100*MB, 100*MB, 0.1, 0),
+			    16*MB, &lite, &full);
+    policy.adjustThresholds(collection(true, 200*MB, 100*MB, 0.1, 1),
+			    16*MB, &lite, &full);
+    EXPECT_NEAR(double(290*MB), double(full), double(MB));
+    EXPECT_LE(lite, full);
+}
+
+TEST(HeapSizingPolicyTest, CeilingCapsHeadroom) {
+    CeilingHeapPolicy policy(200*MB);
+    std::size_t lite = 16*MB, full = 16*MB;
+    policy.adjustThresholds(collection(true, 190*MB, 170*MB, 0.1, 1),
+			    16*MB, &lite, &full);
+    EXPECT_EQ(std::size_t(185*MB), lite);
+    EXPECT_EQ(std::size_t(185*MB), full);
+
+    // Within 10% of the ceiling, every collection is a full one:
+    policy.adjustThresholds(collection(true, 200*MB, 190*MB, 0.1, 1),
+			    16*MB, &lite, &full);
+    EXPECT_EQ(std::size_t(190*MB), full);
+    EXPECT_GT(lite, full);
+}
@@ -231,4 +231,34 @@ TEST_F(NodeStackTest, checkProtectAll) {
   EXPECT_EQ(GCTestHelper::getRefCount(d2), 0);
   EXPECT_EQ(GCTestHelper::getRefCount(d1), 0);
 }
+
+// Pushes and pops entries through the R_StackRegion, as the PROTECT macros do
+// in C code, and checks that entries protected by protectAll() are left above
+// the floor for the NodeStack to unprotect.
+TEST_F(NodeStackTest, checkRegion) {
+  NodeStack stack(2);
+  R_StackRegion* region = stack.region();
+  auto d1 = IntVector::createScalar(1);
+  auto d2 = IntVector::createScalar(2);
+  stack.push(d1);
+  stack.protectAll();
+  EXPECT_EQ(region->floor, region->top);
+  ASSERT_NE(region->top, region->limit);
+  *region->top++ = d2;
+  EXPECT_EQ(stack.size(), 2);
+  EXPECT_EQ(region->top, region->limit);
+  // Growing the stack moves the region:
+  stack.push(d2);
+  EXPECT_EQ(stack.size(), 3);
+  EXPECT_EQ(stack[1], d2);
+  EXPECT_EQ(region->floor, region->base + 1);
+  EXPECT_GE(region->top - region->floor, 2);
+  region->top -= 2;
+  EXPECT_EQ(stack.size(), 1);
+  EXPECT_EQ(GCTestHelper::getRefCount(d1), 1);
+  EXPECT_EQ(GCTestHelper::getRefCount(d2), 0);
+  stack.pop();
+  EXPECT_EQ(GCTestHelper::getRefCount(d1), 0);
+  EXPECT_EQ(region->top, region->base);
+}
 }  // namespace rho